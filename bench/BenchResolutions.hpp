@@ -0,0 +1,45 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace Bench {
+
+struct Resolution {
+	const char *name;
+	std::size_t width;
+	std::size_t height;
+};
+
+/**
+ * @brief The canvas sizes every frame-sized benchmark runs at.
+ */
+inline constexpr Resolution resolutions[] = {
+	{"720p", 1280, 720},
+	{"1080p", 1920, 1080},
+	{"1440p", 2560, 1440},
+	{"2160p", 3840, 2160},
+};
+
+} // namespace Bench
+} // namespace ShowDraw
+} // namespace KaitoTokyo
@@ -0,0 +1,192 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BridgeUtils/AsyncLogQueue.hpp"
+#include "BridgeUtils/AsyncTextureReader.hpp"
+#include "BridgeUtils/GsUnique.hpp"
+#include "BridgeUtils/ILogger.hpp"
+#include "BridgeUtils/ThrottledTaskQueue.hpp"
+
+#include "BenchResolutions.hpp"
+
+using namespace KaitoTokyo::BridgeUtils;
+using namespace KaitoTokyo::ShowDraw::Bench;
+
+namespace {
+
+class NullLogger final : public ILogger {
+public:
+	void logException(const std::exception &, std::string_view) const noexcept override {}
+
+protected:
+	void log(LogLevel, std::string_view message) const noexcept override
+	{
+		benchmark::DoNotOptimize(message.data());
+	}
+};
+
+// The copy that AsyncTextureReader::sync() performs after mapping a staging surface.
+// Staging rows are padded to 256 bytes as Direct3D 11 does, so the row-by-row path is measured.
+void BM_AsyncTextureReaderCopy(benchmark::State &state, Resolution resolution, std::uint32_t bytesPerPixel)
+{
+	const std::size_t bytesPerRow = resolution.width * bytesPerPixel;
+	const std::size_t stagingLinesize = (bytesPerRow + 255) & ~std::size_t{255};
+	const auto height = static_cast<std::uint32_t>(resolution.height);
+	std::vector<std::uint8_t> staging(stagingLinesize * height, 0x5a);
+	std::vector<std::uint8_t> buffer(bytesPerRow * height);
+
+	for (auto _ : state) {
+		AsyncTextureReaderDetail::copyRows(buffer.data(), bytesPerRow, staging.data(), stagingLinesize,
+						   bytesPerRow, height);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(bytesPerRow * height));
+}
+
+[[maybe_unused]] const bool registeredCopies = [] {
+	for (const Resolution &resolution : resolutions) {
+		benchmark::RegisterBenchmark((std::string("AsyncTextureReader/CopyBGRA/") + resolution.name).c_str(),
+					     BM_AsyncTextureReaderCopy, resolution, 4u)
+			->Unit(benchmark::kMicrosecond);
+		benchmark::RegisterBenchmark((std::string("AsyncTextureReader/CopyR8/") + resolution.name).c_str(),
+					     BM_AsyncTextureReaderCopy, resolution, 1u)
+			->Unit(benchmark::kMicrosecond);
+	}
+	return true;
+}();
+
+// Every benchmark thread pushes into one queue whose worker drains it, so this measures push under contention
+// including the eviction of the oldest task once the queue is full.
+void BM_ThrottledTaskQueuePush(benchmark::State &state)
+{
+	static NullLogger logger;
+	static std::unique_ptr<ThrottledTaskQueue> queue;
+	if (state.thread_index() == 0) {
+		queue = std::make_unique<ThrottledTaskQueue>(logger, static_cast<std::size_t>(state.range(0)));
+	}
+
+	for (auto _ : state) {
+		queue->push([](const ThrottledTaskQueue::CancellationToken &token) {
+			benchmark::DoNotOptimize(token->load(std::memory_order_relaxed));
+		});
+	}
+	state.SetItemsProcessed(state.iterations());
+
+	if (state.thread_index() == 0) {
+		queue.reset();
+	}
+}
+BENCHMARK(BM_ThrottledTaskQueuePush)
+	->Name("ThrottledTaskQueue/Push")
+	->Arg(1)
+	->Arg(16)
+	->ThreadRange(1, 8)
+	->UseRealTime();
+
+// GsUnique without a graphics context: resources are scheduled and then taken back for reuse,
+// which runs the lock-free push, the collection and the descriptor search but never destroys anything.
+// Each resource keeps its node across the cycle as a texture wrapper does, so nothing is allocated.
+void BM_GsUniqueScheduleRecycle(benchmark::State &state)
+{
+	const auto batch = static_cast<std::size_t>(state.range(0));
+	const GsUnique::ResourceDescriptor descriptor{1920, 1080, GS_R8, GS_RENDER_TARGET};
+	std::vector<std::unique_ptr<GsUnique::DeferredNode>> nodes(batch);
+	for (std::size_t i = 0; i < batch; i++) {
+		nodes[i] = GsUnique::makeDeferredNode(GsUnique::ResourceKind::Texture, descriptor);
+		nodes[i]->resource = reinterpret_cast<void *>(0x1000 + i * 0x100);
+	}
+
+	for (auto _ : state) {
+		for (std::unique_ptr<GsUnique::DeferredNode> &node : nodes) {
+			GsUnique::pushDeferred(std::move(node));
+		}
+		for (std::unique_ptr<GsUnique::DeferredNode> &node : nodes) {
+			node = GsUnique::takeRecyclable(GsUnique::ResourceKind::Texture, descriptor);
+			benchmark::DoNotOptimize(node.get());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(batch));
+}
+BENCHMARK(BM_GsUniqueScheduleRecycle)->Name("GsUnique/ScheduleRecycle")->Arg(1)->Arg(8)->Arg(64);
+
+// Repeated calls from one call site hit the rate limiter after the first few messages,
+// so this is the cost a hot error path pays on the render thread.
+void BM_ILoggerRateLimitedError(benchmark::State &state)
+{
+	static NullLogger logger;
+	int frame = 0;
+	for (auto _ : state) {
+		logger.error("Failed to render frame {} at {}x{}", frame++, 1920, 1080);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ILoggerRateLimitedError)->Name("ILogger/RateLimitedError")->ThreadRange(1, 4);
+
+// The full formatting path. A call site may only emit a few messages per window,
+// so a fresh logger is swapped in, untimed, before the rate limiter would start suppressing.
+void BM_ILoggerFormat(benchmark::State &state)
+{
+	constexpr int messagesPerLogger = ILoggerDetail::CallSiteRateLimiter::MaxMessagesPerWindow;
+	std::unique_ptr<NullLogger> logger;
+	int frame = 0;
+	for (auto _ : state) {
+		if (frame % messagesPerLogger == 0) {
+			state.PauseTiming();
+			logger = std::make_unique<NullLogger>();
+			state.ResumeTiming();
+		}
+		logger->info("Rendered frame {} at {}x{} in {:.3f} ms", frame++, 1920, 1080, 1.25);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ILoggerFormat)->Name("ILogger/Format");
+
+// The producer side of ObsLogger: copying a formatted message into the lock-free ring.
+void BM_AsyncLogQueuePush(benchmark::State &state)
+{
+	static std::unique_ptr<AsyncLogQueue> queue;
+	if (state.thread_index() == 0) {
+		queue = std::make_unique<AsyncLogQueue>([](int, std::string_view) {}, 0);
+	}
+
+	const std::string message(static_cast<std::size_t>(state.range(0)), 'x');
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(queue->tryPush(0, message));
+	}
+	state.SetItemsProcessed(state.iterations());
+
+	if (state.thread_index() == 0) {
+		queue.reset();
+	}
+}
+BENCHMARK(BM_AsyncLogQueuePush)
+	->Name("AsyncLogQueue/Push")
+	->Arg(64)
+	->Arg(512)
+	->ThreadRange(1, 4)
+	->UseRealTime();
+
+} // namespace
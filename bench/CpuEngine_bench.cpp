@@ -0,0 +1,78 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "BridgeUtils/WorkStealingThreadPool.hpp"
+#include "CpuEngine/CpuEngine.hpp"
+
+#include "BenchResolutions.hpp"
+
+using namespace KaitoTokyo::BridgeUtils;
+using namespace KaitoTokyo::ShowDraw;
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+using namespace KaitoTokyo::ShowDraw::Bench;
+
+namespace {
+
+// The whole default preset per frame, to compare against the frame budget and to measure the scaling over threads.
+void BM_CpuEngineDefault(benchmark::State &state, Resolution resolution, std::size_t threadCount)
+{
+	WorkStealingThreadPool threadPool(threadCount);
+	CpuEngine engine(resolution.width, resolution.height, getKernels(), &threadPool);
+	const PresetSnapshot snapshot(Preset{}, 1);
+
+	std::mt19937 rng(1);
+	LumaImage frames[2] = {LumaImage(resolution.width, resolution.height),
+			       LumaImage(resolution.width, resolution.height)};
+	for (LumaImage &frame : frames) {
+		for (auto &pixel : frame.pixels) {
+			pixel = static_cast<std::uint8_t>(rng());
+		}
+	}
+
+	std::size_t index = 0;
+	for (auto _ : state) {
+		const ConstLumaView output = engine.processLuma(frames[index].view(), snapshot);
+		benchmark::DoNotOptimize(output.data);
+		index ^= 1;
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.counters["bands"] = static_cast<double>(engine.getBandCount());
+}
+
+/**
+ * @brief Names follow CpuEngine/Default/<threads>t/<resolution>. Wall time is what matters here.
+ */
+[[maybe_unused]] const bool registered = [] {
+	for (const Resolution &resolution : resolutions) {
+		for (std::size_t threadCount : {1, 2, 4, 8}) {
+			const std::string name = "CpuEngine/Default/" + std::to_string(threadCount) + "t/" + resolution.name;
+			benchmark::RegisterBenchmark(name.c_str(), BM_CpuEngineDefault, resolution, threadCount)
+				->Unit(benchmark::kMicrosecond)
+				->UseRealTime();
+		}
+	}
+	return true;
+}();
+
+} // namespace
@@ -0,0 +1,138 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CpuKernels/CpuKernels.hpp"
+
+#include "BenchResolutions.hpp"
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+using namespace KaitoTokyo::ShowDraw::Bench;
+
+namespace {
+
+LumaImage makeNoiseImage(std::size_t width, std::size_t height, std::uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	LumaImage image(width, height);
+	for (auto &pixel : image.pixels) {
+		pixel = static_cast<std::uint8_t>(rng());
+	}
+	return image;
+}
+
+/**
+ * @brief The buffers every stage reads from or writes to, allocated once per benchmark run.
+ */
+struct Frames {
+	std::vector<std::uint8_t> bgra;
+	LumaImage current;
+	LumaImage previous;
+	LumaImage motion;
+	LumaImage output;
+
+	Frames(std::size_t width, std::size_t height)
+		: bgra(width * height * 4),
+		  current(makeNoiseImage(width, height, 1)),
+		  previous(makeNoiseImage(width, height, 2)),
+		  motion(makeNoiseImage(width, height, 3)),
+		  output(width, height)
+	{
+		std::mt19937 rng(4);
+		for (auto &byte : bgra) {
+			byte = static_cast<std::uint8_t>(rng());
+		}
+	}
+
+	ImageView<const std::uint8_t> bgraView() const noexcept
+	{
+		return {bgra.data(), current.width, current.height, current.width * 4};
+	}
+};
+
+using Stage = std::function<void(const KernelSet &, Frames &)>;
+
+void runStage(benchmark::State &state, const KernelSet *kernels, Resolution resolution, const Stage &stage)
+{
+	Frames frames(resolution.width, resolution.height);
+	for (auto _ : state) {
+		stage(*kernels, frames);
+		benchmark::DoNotOptimize(frames.output.pixels.data());
+		benchmark::ClobberMemory();
+	}
+	const auto pixels = static_cast<std::int64_t>(resolution.width * resolution.height);
+	state.SetItemsProcessed(state.iterations() * pixels);
+	state.SetBytesProcessed(state.iterations() * pixels);
+}
+
+const std::pair<const char *, Stage> stages[] = {
+	{"ConvertGrayscale",
+	 [](const KernelSet &k, Frames &f) { convertBgraToLuma(k, f.bgraView(), f.output.view()); }},
+	{"Median3x3", [](const KernelSet &k, Frames &f) { applyMedian3x3(k, f.current.view(), f.output.view()); }},
+	{"MotionMap",
+	 [](const KernelSet &k, Frames &f) {
+		 calculateMotionMap(k, f.current.view(), f.previous.view(), f.output.view());
+	 }},
+	{"MotionAdaptiveFilter",
+	 [](const KernelSet &k, Frames &f) {
+		 static const MotionAdaptiveTable table = MotionAdaptiveTable::create(0.5f, 0.3f);
+		 applyMotionAdaptiveFilter(k, f.current.view(), f.previous.view(), f.motion.view(), f.output.view(),
+					   table);
+	 }},
+	{"SobelMagnitude",
+	 [](const KernelSet &k, Frames &f) { applySobelMagnitude(k, f.current.view(), f.output.view()); }},
+	{"FinalizeSobelMagnitude",
+	 [](const KernelSet &, Frames &f) {
+		 static const FinalizeTable table = FinalizeTable::create(true, 4.0f);
+		 applyFinalizeSobelMagnitude(f.current.view(), f.output.view(), table);
+	 }},
+	{"Erosion3x3", [](const KernelSet &k, Frames &f) { applyErosion3x3(k, f.current.view(), f.output.view()); }},
+	{"Dilation3x3", [](const KernelSet &k, Frames &f) { applyDilation3x3(k, f.current.view(), f.output.view()); }},
+};
+
+/**
+ * @brief Registers every stage for every kernel set supported by the running CPU and every resolution.
+ *
+ * Names follow CpuKernels/<stage>/<isa>/<resolution> so that results can be matched across releases.
+ */
+[[maybe_unused]] const bool registered = [] {
+	for (const auto &[stageName, stage] : stages) {
+		for (KernelIsa isa : {KernelIsa::Scalar, KernelIsa::Sse41, KernelIsa::Avx2, KernelIsa::Neon}) {
+			const KernelSet *kernels = getKernels(isa);
+			if (!kernels) {
+				continue;
+			}
+			for (const Resolution &resolution : resolutions) {
+				const std::string name = std::string("CpuKernels/") + stageName + "/" + kernels->name + "/" +
+							 resolution.name;
+				benchmark::RegisterBenchmark(name.c_str(), runStage, kernels, resolution, stage)
+					->Unit(benchmark::kMicrosecond);
+			}
+		}
+	}
+	return true;
+}();
+
+} // namespace
@@ -0,0 +1,323 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+/**
+ * Drives the whole filter through libobs: frames are pushed into a synthetic async source with
+ * obs_source_output_video(), which calls filter_video, and the libobs video thread renders the source
+ * on output channel 0, which calls video_render. Per-stage GPU times come from the filter's
+ * "get_stage_timings" procedure.
+ *
+ * Usage: showdraw-frame-bench [--frames=N] [--fps=N] [benchmark flags]
+ * On Linux run under xvfb-run; rendering is forced onto llvmpipe so that results do not depend on the GPU.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <obs.h>
+
+#include "BridgeUtils/ObsUnique.hpp"
+#include "Core/Preset.hpp"
+#include "Core/StageProfiler.hpp"
+
+#include "BenchResolutions.hpp"
+#include "ObsHeadlessVideo.hpp"
+
+using namespace KaitoTokyo::BridgeUtils;
+using namespace KaitoTokyo::ShowDraw;
+using namespace KaitoTokyo::ShowDraw::Bench;
+using namespace KaitoTokyo::ShowDraw::Testing;
+
+namespace {
+
+constexpr const char *FrameSourceId = "showdraw_bench_frame_source";
+constexpr std::size_t DistinctFrames = 16;
+
+std::uint32_t frameCount = 300;
+std::uint32_t framesPerSecond = 30;
+std::unique_ptr<ObsHeadlessVideo> video;
+
+struct BenchPreset {
+	const char *name;
+	bool medianFilterEnabled;
+	double motionAdaptiveFilteringStrength;
+};
+
+const BenchPreset presets[] = {
+	{"Default", true, 0.5},
+	{"NoMedian", false, 0.5},
+	{"NoMotionAdaptive", true, 0.0},
+	{"Minimal", false, 0.0},
+};
+
+const std::pair<const char *, ExtractionMode> extractionModes[] = {
+	{"Passthrough", ExtractionMode::Passthrough},
+	{"ConvertToGrayscale", ExtractionMode::ConvertToGrayscale},
+	{"MotionMapCalculation", ExtractionMode::MotionMapCalculation},
+	{"SobelMagnitude", ExtractionMode::SobelMagnitude},
+};
+
+struct SourceReleaser {
+	void operator()(obs_source_t *source) const { obs_source_release(source); }
+};
+using unique_obs_source_t = std::unique_ptr<obs_source_t, SourceReleaser>;
+
+void registerFrameSource()
+{
+	obs_source_info info = {};
+	info.id = FrameSourceId;
+	info.type = OBS_SOURCE_TYPE_INPUT;
+	info.output_flags = OBS_SOURCE_ASYNC_VIDEO;
+	info.get_name = [](void *) { return "ShowDraw benchmark frames"; };
+	info.create = [](obs_data_t *, obs_source_t *source) -> void * { return source; };
+	info.destroy = [](void *) {};
+	obs_register_source(&info);
+}
+
+/**
+ * @brief A gray canvas with a dark stroke that advances every frame, plus low-amplitude noise.
+ */
+std::vector<std::vector<std::uint8_t>> makeFrames(std::uint32_t width, std::uint32_t height)
+{
+	std::vector<std::vector<std::uint8_t>> frames(DistinctFrames);
+	std::uint32_t noise = 0x12345678;
+	for (std::size_t i = 0; i < DistinctFrames; i++) {
+		std::vector<std::uint8_t> &bgra = frames[i];
+		bgra.resize(std::size_t{width} * height * 4);
+		const std::uint32_t strokeEnd = width * static_cast<std::uint32_t>(i + 1) / DistinctFrames;
+		for (std::uint32_t y = 0; y < height; y++) {
+			for (std::uint32_t x = 0; x < width; x++) {
+				noise = noise * 1664525u + 1013904223u;
+				const bool onStroke = x < strokeEnd && (y + x / 4) % (height / 4 + 1) < 6;
+				const auto value = static_cast<std::uint8_t>((onStroke ? 40 : 200) + (noise >> 29));
+				std::uint8_t *pixel = &bgra[(std::size_t{y} * width + x) * 4];
+				pixel[0] = value;
+				pixel[1] = value;
+				pixel[2] = value;
+				pixel[3] = 255;
+			}
+		}
+	}
+	return frames;
+}
+
+StageTimings getStageTimings(obs_source_t *filter)
+{
+	StageTimings timings;
+	calldata_t cd;
+	calldata_init(&cd);
+	calldata_set_ptr(&cd, "timings", &timings);
+	proc_handler_call(obs_source_get_proc_handler(filter), "get_stage_timings", &cd);
+	calldata_free(&cd);
+	return timings;
+}
+
+void resetStageTimings(obs_source_t *filter)
+{
+	calldata_t cd;
+	calldata_init(&cd);
+	proc_handler_call(obs_source_get_proc_handler(filter), "reset_stage_timings", &cd);
+	calldata_free(&cd);
+}
+
+void BM_FrameDriver(benchmark::State &state, Resolution resolution, ExtractionMode extractionMode, BenchPreset preset)
+{
+	const auto width = static_cast<std::uint32_t>(resolution.width);
+	const auto height = static_cast<std::uint32_t>(resolution.height);
+
+	try {
+		video->resetVideo(width, height, framesPerSecond);
+	} catch (const std::exception &e) {
+		state.SkipWithError(e.what());
+		return;
+	}
+
+	const auto frames = makeFrames(width, height);
+
+	unique_obs_data_t settings(obs_data_create());
+	obs_data_set_int(settings.get(), "extractionMode", static_cast<long long>(extractionMode));
+	obs_data_set_bool(settings.get(), "medianFilterEnabled", preset.medianFilterEnabled);
+	obs_data_set_double(settings.get(), "motionAdaptiveFilteringStrength", preset.motionAdaptiveFilteringStrength);
+
+	unique_obs_source_t source(obs_source_create(FrameSourceId, "frames", nullptr, nullptr));
+	unique_obs_source_t filter(obs_source_create("showdraw", "showdraw", settings.get(), nullptr));
+	if (!source || !filter) {
+		state.SkipWithError("Failed to create the sources");
+		return;
+	}
+	obs_source_set_async_unbuffered(source.get(), true);
+	obs_source_filter_add(source.get(), filter.get());
+	obs_set_output_source(0, source.get());
+
+	const std::chrono::nanoseconds frameInterval(1000000000 / framesPerSecond);
+	obs_source_frame frame = {};
+	frame.width = width;
+	frame.height = height;
+	frame.format = VIDEO_FORMAT_BGRA;
+	frame.full_range = true;
+	frame.linesize[0] = width * 4;
+
+	// The first frames warm up shader compilation and texture allocation and are not measured.
+	const std::uint32_t warmupFrames = framesPerSecond;
+	std::uint64_t timestamp = 0;
+	auto pushFrames = [&](std::uint32_t count) {
+		auto next = std::chrono::steady_clock::now();
+		for (std::uint32_t i = 0; i < count; i++) {
+			frame.data[0] = const_cast<std::uint8_t *>(frames[timestamp % DistinctFrames].data());
+			frame.timestamp = timestamp++ * static_cast<std::uint64_t>(frameInterval.count());
+			obs_source_output_video(source.get(), &frame);
+			next += frameInterval;
+			std::this_thread::sleep_until(next);
+		}
+	};
+
+	StageTimings timings;
+	std::uint32_t laggedFrames = 0;
+	double elapsedSeconds = 0.0;
+	for (auto _ : state) {
+		pushFrames(warmupFrames);
+		resetStageTimings(filter.get());
+		const std::uint32_t laggedBefore = obs_get_lagged_frames();
+
+		const auto start = std::chrono::steady_clock::now();
+		pushFrames(frameCount);
+		elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// Let the last queries resolve before reading the totals.
+		std::this_thread::sleep_for(frameInterval * (StageProfiler::QueryLatency + 1));
+		laggedFrames = obs_get_lagged_frames() - laggedBefore;
+		timings = getStageTimings(filter.get());
+
+		const double renderedFrames = static_cast<double>(timings.renderedFrames);
+		state.SetIterationTime(renderedFrames > 0 ? static_cast<double>(timings.renderCpuNs) / 1e9 / renderedFrames
+							  : 0.0);
+	}
+
+	obs_set_output_source(0, nullptr);
+	obs_source_filter_remove(source.get(), filter.get());
+
+	auto perFrameMs = [](std::uint64_t totalNs, std::uint64_t frames) {
+		return frames > 0 ? static_cast<double>(totalNs) / 1e6 / static_cast<double>(frames) : 0.0;
+	};
+
+	state.counters["throughput_fps"] = static_cast<double>(timings.renderedFrames) / elapsedSeconds;
+	state.counters["rendered_frames"] = static_cast<double>(timings.renderedFrames);
+	state.counters["lagged_frames"] = laggedFrames;
+	state.counters["render_cpu_ms"] = perFrameMs(timings.renderCpuNs, timings.renderedFrames);
+	std::uint64_t gpuTotalNs = 0;
+	for (std::size_t i = 0; i < RenderStageCount; i++) {
+		if (timings.stageFrames[i] > 0) {
+			state.counters[std::string("gpu_") + getRenderStageName(static_cast<RenderStage>(i)) + "_ms"] =
+				perFrameMs(timings.stageGpuNs[i], timings.stageFrames[i]);
+		}
+		gpuTotalNs += timings.stageFrames[i] > 0 ? timings.stageGpuNs[i] / timings.stageFrames[i] : 0;
+	}
+	state.counters["gpu_total_ms"] = static_cast<double>(gpuTotalNs) / 1e6;
+}
+
+/**
+ * @brief Registers every extraction mode and preset at every resolution.
+ *
+ * Names follow FrameDriver/<mode>/<preset>/<resolution>; the reported time is the render thread's wall time
+ * per frame, and each stage is reported in milliseconds per frame as a counter.
+ */
+void registerBenchmarks()
+{
+	for (const auto &[modeName, extractionMode] : extractionModes) {
+		for (const BenchPreset &preset : presets) {
+			for (const Resolution &resolution : resolutions) {
+				const std::string name = std::string("FrameDriver/") + modeName + "/" + preset.name + "/" +
+							 resolution.name;
+				benchmark::RegisterBenchmark(name.c_str(), BM_FrameDriver, resolution, extractionMode, preset)
+					->Iterations(1)
+					->UseManualTime()
+					->Unit(benchmark::kMillisecond);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Consumes the --frames and --fps flags, leaving the rest for Google Benchmark.
+ */
+bool parseArguments(int &argc, char **argv)
+{
+	int kept = 1;
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		if (std::strncmp(arg, "--frames=", 9) == 0) {
+			frameCount = static_cast<std::uint32_t>(std::strtoul(arg + 9, nullptr, 10));
+		} else if (std::strncmp(arg, "--fps=", 6) == 0) {
+			framesPerSecond = static_cast<std::uint32_t>(std::strtoul(arg + 6, nullptr, 10));
+		} else {
+			argv[kept++] = argv[i];
+		}
+	}
+	argc = kept;
+	return frameCount > 0 && framesPerSecond > 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+try {
+	if (!parseArguments(argc, argv)) {
+		std::cerr << "--frames and --fps must be positive" << std::endl;
+		return 1;
+	}
+
+	video = std::make_unique<ObsHeadlessVideo>();
+	video->resetVideo(static_cast<std::uint32_t>(resolutions[0].width),
+			  static_cast<std::uint32_t>(resolutions[0].height), framesPerSecond);
+
+	obs_module_t *module = nullptr;
+	if (obs_open_module(&module, SHOWDRAW_MODULE_PATH, SHOWDRAW_DATA_PATH) != MODULE_SUCCESS ||
+	    !obs_init_module(module)) {
+		std::cerr << "Failed to load " << SHOWDRAW_MODULE_PATH << std::endl;
+		return 1;
+	}
+	registerFrameSource();
+
+	benchmark::AddCustomContext("showdraw_version", SHOWDRAW_VERSION);
+	benchmark::AddCustomContext("renderer", ObsHeadlessVideo::getRendererName());
+	benchmark::AddCustomContext("frames", std::to_string(frameCount));
+	benchmark::AddCustomContext("fps", std::to_string(framesPerSecond));
+
+	registerBenchmarks();
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	video.reset();
+	return 0;
+} catch (const std::exception &e) {
+	std::cerr << e.what() << std::endl;
+	return 1;
+}
@@ -0,0 +1,36 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <benchmark/benchmark.h>
+
+#include "CpuKernels/CpuKernels.hpp"
+
+int main(int argc, char **argv)
+{
+	// Recorded in the JSON context so that results from different releases and machines can be told apart.
+	benchmark::AddCustomContext("showdraw_version", SHOWDRAW_VERSION);
+	benchmark::AddCustomContext("showdraw_cpu_kernels", KaitoTokyo::ShowDraw::CpuKernels::getKernels().name);
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,255 @@
+/*
+Bridge Utils
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace KaitoTokyo {
+namespace BridgeUtils {
+
+/**
+ * @class AsyncLogQueue
+ * @brief A bounded, lock-free multi-producer ring buffer of log messages drained by a background thread.
+ *
+ * Producers copy their message into a fixed-size slot with a single CAS and never wait.
+ * When the ring is full the message is dropped and counted instead of blocking the caller,
+ * so a burst of errors on the render thread can never stall it.
+ * A single flusher thread hands the messages to the sink in the order they were reserved.
+ * Once stopped, the queue hands messages to the sink directly, so the sink must then be thread-safe.
+ */
+class AsyncLogQueue {
+public:
+	/**
+     * @brief The maximum number of bytes stored in one slot. Longer messages are split across slots.
+     */
+	static constexpr std::size_t MaxChunkSize = 1024;
+
+	using Sink = std::function<void(int level, std::string_view message)>;
+
+	/**
+     * @brief Constructs the queue and starts the flusher thread.
+     * @param _sink The function that receives every message on the flusher thread.
+     * @param _droppedNoticeLevel The level passed to the sink when reporting dropped messages.
+     * @param capacity The number of slots. Rounded up to a power of two.
+     */
+	AsyncLogQueue(Sink _sink, int _droppedNoticeLevel, std::size_t capacity = 256)
+		: sink(std::move(_sink)),
+		  droppedNoticeLevel(_droppedNoticeLevel),
+		  mask(roundUpToPowerOfTwo(capacity) - 1),
+		  slots(new Slot[mask + 1])
+	{
+		for (std::size_t i = 0; i <= mask; i++) {
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		flusher = std::thread(&AsyncLogQueue::flusherLoop, this);
+	}
+
+	/**
+     * @brief Destructor. Stops the queue unless stop() already has.
+     */
+	~AsyncLogQueue() noexcept { stop(); }
+
+	AsyncLogQueue(const AsyncLogQueue &) = delete;
+	AsyncLogQueue &operator=(const AsyncLogQueue &) = delete;
+	AsyncLogQueue(AsyncLogQueue &&) = delete;
+	AsyncLogQueue &operator=(AsyncLogQueue &&) = delete;
+
+	/**
+     * @brief Enqueues a message without blocking.
+     *
+     * Messages longer than MaxChunkSize are split, preferably at line breaks.
+     * @return false if any part of the message had to be dropped because the ring was full.
+     */
+	bool tryPush(int level, std::string_view message) noexcept
+	{
+		if (stopped.load(std::memory_order_acquire)) {
+			emit(level, message);
+			return true;
+		}
+
+		bool pushed = true;
+		do {
+			std::size_t chunkSize = std::min(message.size(), MaxChunkSize);
+			if (chunkSize < message.size()) {
+				const std::size_t lineBreak = message.rfind('\n', chunkSize - 1);
+				if (lineBreak != std::string_view::npos && lineBreak > 0) {
+					chunkSize = lineBreak + 1;
+				}
+			}
+
+			if (!tryPushChunk(level, message.substr(0, chunkSize))) {
+				pushed = false;
+			}
+			message.remove_prefix(chunkSize);
+		} while (!message.empty());
+
+		cond.notify_one();
+		return pushed;
+	}
+
+	/**
+     * @brief Flushes every queued message and joins the flusher thread. Does nothing once stopped.
+     *
+     * Call this before the code of the sink goes away, such as when a module is unloaded, rather than leaving it
+     * to the destructor of a static: on Windows that runs under the loader lock, where joining a thread can
+     * deadlock. Messages pushed afterwards are handed to the sink on the caller's thread, and one pushed while
+     * stop() runs may be lost.
+     */
+	void stop() noexcept
+	{
+		std::lock_guard<std::mutex> lock(stopMutex);
+		if (!flusher.joinable()) {
+			return;
+		}
+		stopped.store(true, std::memory_order_release);
+		cond.notify_one();
+		flusher.join();
+		// The flusher is gone, so this thread may take its place for what was pushed during its last drain.
+		drainToSink();
+	}
+
+	/**
+     * @brief Gets the number of messages dropped so far because the ring was full.
+     */
+	std::uint64_t getDroppedCount() const noexcept { return totalDropped.load(std::memory_order_relaxed); }
+
+private:
+	struct Slot {
+		std::atomic<std::size_t> sequence{0};
+		int level = 0;
+		std::size_t length = 0;
+		char text[MaxChunkSize];
+	};
+
+	static std::size_t roundUpToPowerOfTwo(std::size_t value) noexcept
+	{
+		std::size_t result = 2;
+		while (result < value) {
+			result <<= 1;
+		}
+		return result;
+	}
+
+	bool tryPushChunk(int level, std::string_view chunk) noexcept
+	{
+		std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		Slot *slot;
+		while (true) {
+			slot = &slots[position & mask];
+			const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			const auto difference =
+				static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+			if (difference == 0) {
+				if (enqueuePosition.compare_exchange_weak(position, position + 1,
+									  std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (difference < 0) {
+				pendingDropped.fetch_add(1, std::memory_order_relaxed);
+				totalDropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			} else {
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->level = level;
+		slot->length = chunk.size();
+		std::memcpy(slot->text, chunk.data(), chunk.size());
+		slot->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+     * @brief Hands every published message to the sink. Only called from the flusher thread.
+     */
+	void drainToSink() noexcept
+	{
+		while (true) {
+			Slot &slot = slots[dequeuePosition & mask];
+			if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+				break;
+			}
+
+			emit(slot.level, {slot.text, slot.length});
+			slot.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+			dequeuePosition++;
+		}
+
+		const std::uint64_t dropped = pendingDropped.exchange(0, std::memory_order_relaxed);
+		if (dropped > 0) {
+			const std::string notice = "[AsyncLogQueue] " + std::to_string(dropped) +
+						   " log messages were dropped because the queue was full";
+			emit(droppedNoticeLevel, notice);
+		}
+	}
+
+	void emit(int level, std::string_view message) noexcept
+	try {
+		sink(level, message);
+	} catch (...) {
+		// A failing sink must not take the flusher thread down with it.
+	}
+
+	void flusherLoop() noexcept
+	{
+		while (!stopped.load(std::memory_order_acquire)) {
+			drainToSink();
+
+			// Producers notify without taking the mutex, so a wakeup can be missed;
+			// the timeout bounds the latency in that case.
+			std::unique_lock<std::mutex> lock(mtx);
+			cond.wait_for(lock, std::chrono::milliseconds(50));
+		}
+		drainToSink();
+	}
+
+	const Sink sink;
+	const int droppedNoticeLevel;
+	const std::size_t mask;
+	const std::unique_ptr<Slot[]> slots;
+
+	alignas(64) std::atomic<std::size_t> enqueuePosition{0};
+	alignas(64) std::size_t dequeuePosition = 0;
+
+	std::atomic<std::uint64_t> pendingDropped{0};
+	std::atomic<std::uint64_t> totalDropped{0};
+
+	std::atomic<bool> stopped{false};
+	std::mutex stopMutex;
+	std::mutex mtx;
+	std::condition_variable cond;
+	std::thread flusher;
+};
+
+} // namespace BridgeUtils
+} // namespace KaitoTokyo
@@ -18,6 +18,7 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cstddef>
@@ -28,6 +29,10 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <utility>
 #include <vector>
 
+#include <obs.h>
+
+#include "GsUnique.hpp"
+
 namespace KaitoTokyo {
 namespace BridgeUtils {
 
@@ -60,12 +65,27 @@ inline std::uint32_t getBytesPerPixel(const gs_color_format format)
 	}
 }
 
+/**
+ * @brief Copies rows between buffers of different line sizes. This is the CPU side of sync().
+ */
+inline void copyRows(std::uint8_t *dst, std::size_t dstLinesize, const std::uint8_t *src, std::size_t srcLinesize,
+		     std::size_t bytesPerRow, std::uint32_t height) noexcept
+{
+	if (dstLinesize == srcLinesize && bytesPerRow == srcLinesize) {
+		std::memcpy(dst, src, srcLinesize * height);
+		return;
+	}
+	for (std::uint32_t y = 0; y < height; y++) {
+		std::memcpy(dst + y * dstLinesize, src + y * srcLinesize, bytesPerRow);
+	}
+}
+
 struct ScopedStageSurfMap {
 	gs_stagesurf_t *surf = nullptr;
 	std::uint8_t *data = nullptr;
 	std::uint32_t linesize = 0;
 
-	explicit ScopedStageSurfMap(gs_stagesurf_t *surf) : surf{surf}
+	explicit ScopedStageSurfMap(gs_stagesurf_t *_surf) : surf{_surf}
 	{
 		if (!surf) {
 			throw std::invalid_argument("Target surface cannot be null.");
@@ -117,11 +137,11 @@ public:
 			   const gs_color_format format = GS_BGRA)
 		: width(width),
 		  height(height),
-		  bufferLinesize((width * async_texture_reader_detail::getBytesPerPixel(format) + 3) & ~3u),
+		  bufferLinesize((width * AsyncTextureReaderDetail::getBytesPerPixel(format) + 3) & ~3u),
 		  cpuBuffers{std::vector<std::uint8_t>(height * bufferLinesize),
 			     std::vector<std::uint8_t>(height * bufferLinesize)},
-		  stagesurfs{obs_bridge_utils::make_unique_gs_stagesurf(width, height, format),
-			     obs_bridge_utils::make_unique_gs_stagesurf(width, height, format)}
+		  stagesurfs{make_unique_gs_stagesurf(width, height, format),
+			     make_unique_gs_stagesurf(width, height, format)}
 	{
 	}
 
@@ -154,9 +174,10 @@ public:
 		}
 		gs_stagesurf_t *const stagesurf = stagesurfs[gpuReadIndex].get();
 
-		const async_texture_reader_detail::ScopedStageSurfMap mappedSurf(stagesurf);
+		const AsyncTextureReaderDetail::ScopedStageSurfMap mappedSurf(stagesurf);
 
-		if (!mappedSurf.data || mappedSurf.linesize > bufferLinesize) {
+		// Staging surfaces may pad their rows beyond bufferLinesize; only the leading bytes are copied.
+		if (!mappedSurf.data) {
 			throw std::runtime_error("gs_stagesurface_map returned invalid data");
 		}
 
@@ -166,11 +187,8 @@ public:
 		const std::size_t backBufferIndex = 1 - activeCpuBufferIndex.load(std::memory_order_acquire);
 		auto &backBuffer = cpuBuffers[backBufferIndex];
 
-		for (std::uint32_t y = 0; y < height; y++) {
-			const std::uint8_t *srcRow = mappedSurf.data + (y * mappedSurf.linesize);
-			std::uint8_t *dstRow = backBuffer.data() + (y * bufferLinesize);
-			std::memcpy(dstRow, srcRow, bytesToCopyPerRow);
-		}
+		AsyncTextureReaderDetail::copyRows(backBuffer.data(), bufferLinesize, mappedSurf.data, mappedSurf.linesize,
+						   bytesToCopyPerRow, height);
 
 		activeCpuBufferIndex.store(backBufferIndex, std::memory_order_release);
 	}
@@ -223,7 +241,7 @@ private:
 	std::array<std::vector<std::uint8_t>, 2> cpuBuffers;
 	std::atomic<std::size_t> activeCpuBufferIndex = {0};
 
-	std::array<KaitoTokyo::BridgeUtils::gs_stagesurf_t, 2> stagesurfs;
+	std::array<unique_gs_stagesurf_t, 2> stagesurfs;
 	std::size_t gpuWriteIndex = 0;
 	std::mutex gpuMutex;
 };
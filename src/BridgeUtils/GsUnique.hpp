@@ -18,13 +18,16 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #pragma once
 
-#include <deque>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <mutex>
+#include <new>
 #include <stdexcept>
 #include <string>
 
 #include <obs.h>
+#include <graphics/vec4.h>
 
 #include "ObsUnique.hpp"
 
@@ -33,94 +36,239 @@ namespace BridgeUtils {
 
 namespace GsUnique {
 
-inline std::mutex &getMutex()
+/**
+ * @brief Default number of resources destroyed by a single call to drainSome().
+ */
+constexpr std::size_t DefaultDrainBudgetPerFrame = 4;
+
+enum class ResourceKind : std::uint8_t { Effect, Texture, Stagesurf, Timer, TimerRange };
+
+/**
+ * @brief Describes a graphics resource well enough to decide whether it can be reused.
+ *
+ * A zero-sized descriptor marks a resource that must never be recycled.
+ */
+struct ResourceDescriptor {
+	std::uint32_t width = 0;
+	std::uint32_t height = 0;
+	gs_color_format format = GS_UNKNOWN;
+	std::uint32_t flags = 0;
+
+	bool isRecyclable() const noexcept { return width > 0 && height > 0; }
+
+	bool operator==(const ResourceDescriptor &other) const noexcept
+	{
+		return width == other.width && height == other.height && format == other.format &&
+		       flags == other.flags;
+	}
+};
+
+/**
+ * @brief A node of the intrusive deferred-free list.
+ *
+ * Each resource wrapper allocates its node along with the resource, so that releasing the resource from any thread
+ * pushes the node with a single CAS and never allocates. Nodes are owned exclusively by the graphics thread after
+ * they have been collected, and a recycled resource takes its node back with it.
+ */
+struct DeferredNode {
+	DeferredNode *next = nullptr;
+	ResourceKind kind;
+	void *resource;
+	ResourceDescriptor descriptor;
+};
+
+inline std::unique_ptr<DeferredNode> makeDeferredNode(ResourceKind kind, const ResourceDescriptor &descriptor = {})
 {
-	static std::mutex mtx;
-	return mtx;
+	return std::unique_ptr<DeferredNode>(new DeferredNode{nullptr, kind, nullptr, descriptor});
 }
 
-inline std::deque<gs_effect_t *> &getEffectsDeque()
+inline std::atomic<DeferredNode *> &getPendingHead() noexcept
 {
-	static std::deque<gs_effect_t *> effectsToDelete;
-	return effectsToDelete;
+	static std::atomic<DeferredNode *> pendingHead{nullptr};
+	return pendingHead;
 }
 
-inline std::deque<gs_texture_t *> &getTexturesDeque()
+/**
+ * @brief The collected nodes waiting for destruction or reuse, oldest first.
+ * Only touched while the graphics context is entered, which serializes access.
+ */
+struct CollectedList {
+	DeferredNode *head = nullptr;
+	// The last node, so that collect() appends without walking the list.
+	DeferredNode *tail = nullptr;
+
+	/**
+	 * @brief Unlinks the node that follows previous, or the head when previous is null.
+	 */
+	DeferredNode *unlinkAfter(DeferredNode *previous) noexcept
+	{
+		DeferredNode *&link = previous ? previous->next : head;
+		DeferredNode *node = link;
+		link = node->next;
+		if (node == tail) {
+			tail = previous;
+		}
+		node->next = nullptr;
+		return node;
+	}
+};
+
+inline CollectedList &getCollected() noexcept
 {
-	static std::deque<gs_texture_t *> texturesToDelete;
-	return texturesToDelete;
+	static CollectedList collected;
+	return collected;
 }
 
-inline std::deque<gs_stagesurf_t *> &getStagesurfsDeque()
+/**
+ * @brief Schedules the resource held by a node for deletion. Safe to call from any thread.
+ */
+inline void pushDeferred(std::unique_ptr<DeferredNode> owned) noexcept
 {
-	static std::deque<gs_stagesurf_t *> stagesurfsToDelete;
-	return stagesurfsToDelete;
+	DeferredNode *node = owned.release();
+
+	std::atomic<DeferredNode *> &head = getPendingHead();
+	DeferredNode *expected = head.load(std::memory_order_relaxed);
+	do {
+		node->next = expected;
+	} while (!head.compare_exchange_weak(expected, node, std::memory_order_release, std::memory_order_relaxed));
 }
 
-inline void scheduleEffectToDelete(gs_effect_t *effect)
+/**
+ * @brief Moves every pending node onto the collected list. Must be called within the graphics context.
+ *
+ * The pending list is detached with a single exchange, so producers never contend with the consumer.
+ * Nodes are appended in the order they were scheduled so that the oldest resources are destroyed first.
+ */
+inline void collect() noexcept
 {
-	if (effect) {
-		std::lock_guard lock(getMutex());
-		getEffectsDeque().push_back(effect);
+	DeferredNode *pending = getPendingHead().exchange(nullptr, std::memory_order_acquire);
+	if (!pending) {
+		return;
 	}
-}
 
-inline void scheduleTextureToDelete(gs_texture_t *texture)
-{
-	if (texture) {
-		std::lock_guard lock(getMutex());
-		getTexturesDeque().push_back(texture);
+	DeferredNode *const last = pending;
+	DeferredNode *ordered = nullptr;
+	while (pending) {
+		DeferredNode *next = pending->next;
+		pending->next = ordered;
+		ordered = pending;
+		pending = next;
+	}
+
+	CollectedList &collected = getCollected();
+	if (collected.tail) {
+		collected.tail->next = ordered;
+	} else {
+		collected.head = ordered;
 	}
+	collected.tail = last;
 }
 
-inline void scheduleStagesurfsToDelete(gs_stagesurf_t *surface)
+inline void destroyNode(DeferredNode *node) noexcept
 {
-	if (surface) {
-		std::lock_guard lock(getMutex());
-		getStagesurfsDeque().push_back(surface);
+	switch (node->kind) {
+	case ResourceKind::Effect:
+		gs_effect_destroy(static_cast<gs_effect_t *>(node->resource));
+		break;
+	case ResourceKind::Texture:
+		gs_texture_destroy(static_cast<gs_texture_t *>(node->resource));
+		break;
+	case ResourceKind::Stagesurf:
+		gs_stagesurface_destroy(static_cast<gs_stagesurf_t *>(node->resource));
+		break;
+	case ResourceKind::Timer:
+		gs_timer_destroy(static_cast<gs_timer_t *>(node->resource));
+		break;
+	case ResourceKind::TimerRange:
+		gs_timer_range_destroy(static_cast<gs_timer_range_t *>(node->resource));
+		break;
 	}
+	delete node;
 }
 
-inline void drain()
+/**
+ * @brief Takes a scheduled resource matching the descriptor out of the deferred-free list.
+ * Must be called within the graphics context.
+ * @return The node of the resource to be reused, or null if nothing matches.
+ */
+inline std::unique_ptr<DeferredNode> takeRecyclable(ResourceKind kind, const ResourceDescriptor &descriptor) noexcept
 {
-	std::deque<gs_effect_t *> _effects_to_delete;
-	std::deque<gs_texture_t *> _textures_to_delete;
-	std::deque<gs_stagesurf_t *> _stagesurfs_to_delete;
-	{
-		std::lock_guard lock(getMutex());
-		if (!getEffectsDeque().empty()) {
-			_effects_to_delete = std::move(getEffectsDeque());
-		}
-		if (!getTexturesDeque().empty()) {
-			_textures_to_delete = std::move(getTexturesDeque());
-		}
-		if (!getStagesurfsDeque().empty()) {
-			_stagesurfs_to_delete = std::move(getStagesurfsDeque());
-		}
+	if (!descriptor.isRecyclable()) {
+		return nullptr;
 	}
 
-	for (gs_effect_t *effect : _effects_to_delete) {
-		gs_effect_destroy(effect);
+	collect();
+
+	CollectedList &collected = getCollected();
+	DeferredNode *previous = nullptr;
+	for (DeferredNode *node = collected.head; node; previous = node, node = node->next) {
+		if (node->kind == kind && node->descriptor == descriptor) {
+			return std::unique_ptr<DeferredNode>(collected.unlinkAfter(previous));
+		}
 	}
-	for (gs_texture_t *texture : _textures_to_delete) {
-		gs_texture_destroy(texture);
+	return nullptr;
+}
+
+/**
+ * @brief Destroys at most `budget` scheduled resources. Must be called within the graphics context.
+ *
+ * Intended to be called once per frame from the render thread so that released resources are
+ * reclaimed steadily without ever spending more than a bounded amount of time per frame.
+ * @return The number of resources destroyed.
+ */
+inline std::size_t drainSome(std::size_t budget = DefaultDrainBudgetPerFrame) noexcept
+{
+	collect();
+
+	std::size_t destroyed = 0;
+	CollectedList &collected = getCollected();
+	while (collected.head && destroyed < budget) {
+		destroyNode(collected.unlinkAfter(nullptr));
+		destroyed++;
 	}
-	for (gs_stagesurf_t *surface : _stagesurfs_to_delete) {
-		gs_stagesurface_destroy(surface);
+	return destroyed;
+}
+
+/**
+ * @brief Destroys every scheduled resource. Must be called within the graphics context.
+ */
+inline void drain() noexcept
+{
+	collect();
+
+	CollectedList &collected = getCollected();
+	while (collected.head) {
+		destroyNode(collected.unlinkAfter(nullptr));
 	}
 }
 
-struct GsEffectDeleter {
-	void operator()(gs_effect_t *effect) const { scheduleEffectToDelete(effect); }
-};
+/**
+ * @brief Schedules a resource for deletion through the node that the wrapper was created with.
+ *
+ * A wrapper that adopted a resource without a node allocates one on release. If that fails, the resource is leaked
+ * rather than the process terminated.
+ */
+template<typename T, ResourceKind Kind> struct DeferredDeleter {
+	std::unique_ptr<DeferredNode> node;
 
-struct GsTextureDeleter {
-	void operator()(gs_texture_t *texture) const { scheduleTextureToDelete(texture); }
+	void operator()(T *resource) noexcept
+	{
+		if (!node) {
+			node.reset(new (std::nothrow) DeferredNode{nullptr, Kind, nullptr, {}});
+			if (!node) {
+				return;
+			}
+		}
+		node->resource = resource;
+		pushDeferred(std::move(node));
+	}
 };
 
-struct GsStagesurfDeleter {
-	void operator()(gs_stagesurf_t *surface) const { scheduleStagesurfsToDelete(surface); }
-};
+using GsEffectDeleter = DeferredDeleter<gs_effect_t, ResourceKind::Effect>;
+using GsTextureDeleter = DeferredDeleter<gs_texture_t, ResourceKind::Texture>;
+using GsStagesurfDeleter = DeferredDeleter<gs_stagesurf_t, ResourceKind::Stagesurf>;
+using GsTimerDeleter = DeferredDeleter<gs_timer_t, ResourceKind::Timer>;
+using GsTimerRangeDeleter = DeferredDeleter<gs_timer_range_t, ResourceKind::TimerRange>;
 
 } // namespace GsUnique
 
@@ -128,6 +276,8 @@ using unique_gs_effect_t = std::unique_ptr<gs_effect_t, GsUnique::GsEffectDelete
 
 inline unique_gs_effect_t make_unique_gs_effect_from_file(const unique_bfree_char_t &file)
 {
+	std::unique_ptr<GsUnique::DeferredNode> node = GsUnique::makeDeferredNode(GsUnique::ResourceKind::Effect);
+
 	char *raw_error_string = nullptr;
 	gs_effect_t *raw_effect = gs_effect_create_from_file(file.get(), &raw_error_string);
 	unique_bfree_char_t error_string(raw_error_string);
@@ -136,20 +286,69 @@ inline unique_gs_effect_t make_unique_gs_effect_from_file(const unique_bfree_cha
 		throw std::runtime_error(std::string("gs_effect_create_from_file failed: ") +
 					 (error_string ? error_string.get() : "(unknown error)"));
 	}
-	return unique_gs_effect_t(raw_effect);
+	return unique_gs_effect_t(raw_effect, {std::move(node)});
 }
 
 using unique_gs_texture_t = std::unique_ptr<gs_texture_t, GsUnique::GsTextureDeleter>;
 
+namespace GsUnique {
+
+/**
+ * @brief Clears a render target to transparent black, leaving the current render target as it was.
+ */
+inline void clearRenderTarget(gs_texture_t *texture) noexcept
+{
+	gs_texture_t *const previousRenderTarget = gs_get_render_target();
+	gs_zstencil_t *const previousZStencil = gs_get_zstencil_target();
+	const gs_color_space previousColorSpace = gs_get_color_space();
+
+	gs_set_render_target_with_color_space(texture, nullptr, GS_CS_SRGB);
+	struct vec4 transparent;
+	vec4_zero(&transparent);
+	gs_clear(GS_CLEAR_COLOR, &transparent, 0.0f, 0);
+
+	gs_set_render_target_with_color_space(previousRenderTarget, previousZStencil, previousColorSpace);
+}
+
+} // namespace GsUnique
+
+/**
+ * @brief Creates a texture, reusing one of the same descriptor that is waiting to be destroyed when possible.
+ *
+ * Must be called within the graphics context. A blank render target, whether new or recycled, starts cleared to
+ * transparent black, so a texture never shows what its previous owner drew. Other blank textures have undefined
+ * contents until they are written.
+ */
 inline unique_gs_texture_t make_unique_gs_texture(std::uint32_t width, std::uint32_t height,
 						  enum gs_color_format color_format, std::uint32_t levels,
 						  const std::uint8_t **data, std::uint32_t flags)
 {
+	// Only blank single-level textures are interchangeable, so only those take part in recycling.
+	GsUnique::ResourceDescriptor descriptor;
+	if (levels == 1 && !data) {
+		descriptor = {width, height, color_format, flags};
+		if (std::unique_ptr<GsUnique::DeferredNode> recycled =
+			    GsUnique::takeRecyclable(GsUnique::ResourceKind::Texture, descriptor)) {
+			gs_texture_t *const rawTexture = static_cast<gs_texture_t *>(recycled->resource);
+			unique_gs_texture_t texture(rawTexture, {std::move(recycled)});
+			if (flags & GS_RENDER_TARGET) {
+				GsUnique::clearRenderTarget(texture.get());
+			}
+			return texture;
+		}
+	}
+
+	std::unique_ptr<GsUnique::DeferredNode> node =
+		GsUnique::makeDeferredNode(GsUnique::ResourceKind::Texture, descriptor);
 	gs_texture_t *rawTexture = gs_texture_create(width, height, color_format, levels, data, flags);
 	if (!rawTexture) {
 		throw std::runtime_error("gs_texture_create failed");
 	}
-	return unique_gs_texture_t(rawTexture);
+	unique_gs_texture_t texture(rawTexture, {std::move(node)});
+	if (!data && (flags & GS_RENDER_TARGET)) {
+		GsUnique::clearRenderTarget(texture.get());
+	}
+	return texture;
 }
 
 using unique_gs_stagesurf_t = std::unique_ptr<gs_stagesurf_t, GsUnique::GsStagesurfDeleter>;
@@ -157,11 +356,45 @@ using unique_gs_stagesurf_t = std::unique_ptr<gs_stagesurf_t, GsUnique::GsStages
 inline unique_gs_stagesurf_t make_unique_gs_stagesurf(std::uint32_t width, std::uint32_t height,
 						      enum gs_color_format color_format)
 {
+	const GsUnique::ResourceDescriptor descriptor{width, height, color_format, 0};
+	if (std::unique_ptr<GsUnique::DeferredNode> recycled =
+		    GsUnique::takeRecyclable(GsUnique::ResourceKind::Stagesurf, descriptor)) {
+		gs_stagesurf_t *const rawSurface = static_cast<gs_stagesurf_t *>(recycled->resource);
+		return unique_gs_stagesurf_t(rawSurface, {std::move(recycled)});
+	}
+
+	std::unique_ptr<GsUnique::DeferredNode> node =
+		GsUnique::makeDeferredNode(GsUnique::ResourceKind::Stagesurf, descriptor);
 	gs_stagesurf_t *rawSurface = gs_stagesurface_create(width, height, color_format);
 	if (!rawSurface) {
 		throw std::runtime_error("gs_stagesurface_create failed");
 	}
-	return unique_gs_stagesurf_t(rawSurface);
+	return unique_gs_stagesurf_t(rawSurface, {std::move(node)});
+}
+
+using unique_gs_timer_t = std::unique_ptr<gs_timer_t, GsUnique::GsTimerDeleter>;
+
+inline unique_gs_timer_t make_unique_gs_timer()
+{
+	std::unique_ptr<GsUnique::DeferredNode> node = GsUnique::makeDeferredNode(GsUnique::ResourceKind::Timer);
+	gs_timer_t *rawTimer = gs_timer_create();
+	if (!rawTimer) {
+		throw std::runtime_error("gs_timer_create failed");
+	}
+	return unique_gs_timer_t(rawTimer, {std::move(node)});
+}
+
+using unique_gs_timer_range_t = std::unique_ptr<gs_timer_range_t, GsUnique::GsTimerRangeDeleter>;
+
+inline unique_gs_timer_range_t make_unique_gs_timer_range()
+{
+	std::unique_ptr<GsUnique::DeferredNode> node =
+		GsUnique::makeDeferredNode(GsUnique::ResourceKind::TimerRange);
+	gs_timer_range_t *rawRange = gs_timer_range_create();
+	if (!rawRange) {
+		throw std::runtime_error("gs_timer_range_create failed");
+	}
+	return unique_gs_timer_range_t(rawRange, {std::move(node)});
 }
 
 class GraphicsContextGuard {
@@ -18,8 +18,13 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <functional>
 #include <iterator>
 #include <stdexcept>
 #include <string_view>
@@ -31,6 +36,90 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 namespace KaitoTokyo {
 namespace BridgeUtils {
 
+namespace ILoggerDetail {
+
+#if defined(NDEBUG) && !defined(KAITOTOKYO_BRIDGEUTILS_ENABLE_DEBUG_LOG)
+constexpr bool DebugLogEnabled = false;
+#else
+constexpr bool DebugLogEnabled = true;
+#endif
+
+/**
+ * @brief Limits how often each call site may log, identified by the address of its format string.
+ *
+ * Each call site may emit MaxMessagesPerWindow messages per window. Further messages are only counted,
+ * and the count is reported with the next message the call site is allowed to emit.
+ * All state is kept in a fixed table of atomics, so admitting a message never locks or allocates.
+ */
+class CallSiteRateLimiter {
+public:
+	static constexpr std::size_t SlotCount = 64;
+	static constexpr std::size_t MaxProbes = 8;
+	static constexpr std::uint32_t MaxMessagesPerWindow = 5;
+	static constexpr std::int64_t WindowNs = 1'000'000'000;
+
+	/**
+	 * @brief Decides whether a message from the call site may be emitted.
+	 * @param site A pointer that identifies the call site.
+	 * @param nowNs The current time in nanoseconds on a monotonic clock.
+	 * @param suppressed Receives the number of messages suppressed since the last admitted one.
+	 * @return true if the message should be emitted.
+	 */
+	bool admit(const void *site, std::int64_t nowNs, std::uint32_t &suppressed) noexcept
+	{
+		suppressed = 0;
+
+		Slot *slot = findSlot(site);
+		if (!slot) {
+			// The table is full; fall back to logging everything rather than hiding messages.
+			return true;
+		}
+
+		std::int64_t windowStart = slot->windowStart.load(std::memory_order_relaxed);
+		if (nowNs - windowStart >= WindowNs &&
+		    slot->windowStart.compare_exchange_strong(windowStart, nowNs, std::memory_order_relaxed)) {
+			slot->count.store(0, std::memory_order_relaxed);
+		}
+
+		if (slot->count.fetch_add(1, std::memory_order_relaxed) < MaxMessagesPerWindow) {
+			suppressed = slot->suppressed.exchange(0, std::memory_order_relaxed);
+			return true;
+		}
+
+		slot->suppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+private:
+	struct Slot {
+		std::atomic<const void *> site{nullptr};
+		std::atomic<std::int64_t> windowStart{0};
+		std::atomic<std::uint32_t> count{0};
+		std::atomic<std::uint32_t> suppressed{0};
+	};
+
+	Slot *findSlot(const void *site) noexcept
+	{
+		const std::size_t hash = std::hash<const void *>{}(site);
+		for (std::size_t probe = 0; probe < MaxProbes; probe++) {
+			Slot &slot = slots[(hash + probe) % SlotCount];
+			const void *current = slot.site.load(std::memory_order_acquire);
+			if (!current) {
+				// On failure, current receives the site that claimed the slot first.
+				slot.site.compare_exchange_strong(current, site, std::memory_order_acq_rel);
+			}
+			if (!current || current == site) {
+				return &slot;
+			}
+		}
+		return nullptr;
+	}
+
+	std::array<Slot, SlotCount> slots;
+};
+
+} // namespace ILoggerDetail
+
 class ILogger {
 public:
 	ILogger() noexcept = default;
@@ -41,9 +130,15 @@ public:
 	ILogger(ILogger &&) = delete;
 	ILogger &operator=(ILogger &&) = delete;
 
+	/**
+	 * @brief Logs a debug message. Compiled out of release builds unless
+	 * KAITOTOKYO_BRIDGEUTILS_ENABLE_DEBUG_LOG is defined.
+	 */
 	template<typename... Args> void debug(fmt::format_string<Args...> fmt, Args &&...args) const noexcept
 	{
-		formatAndLog(LogLevel::Debug, fmt, std::forward<Args>(args)...);
+		if constexpr (ILoggerDetail::DebugLogEnabled) {
+			formatAndLog(LogLevel::Debug, fmt, std::forward<Args>(args)...);
+		}
 	}
 
 	template<typename... Args> void info(fmt::format_string<Args...> fmt, Args &&...args) const noexcept
@@ -74,15 +169,29 @@ private:
 	template<typename... Args>
 	void formatAndLog(LogLevel level, fmt::format_string<Args...> fmt, Args &&...args) const noexcept
 	try {
+		const std::int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+						   std::chrono::steady_clock::now().time_since_epoch())
+						   .count();
+		std::uint32_t suppressed;
+		if (!rateLimiter.admit(fmt::string_view(fmt).data(), nowNs, suppressed)) {
+			return;
+		}
+
+		// memory_buffer keeps up to 500 characters inline, so typical messages are formatted on the stack.
 		fmt::memory_buffer buffer;
 		fmt::format_to(std::back_inserter(buffer), "{}", getPrefix());
 		fmt::vformat_to(std::back_inserter(buffer), fmt, fmt::make_format_args(args...));
+		if (suppressed > 0) {
+			fmt::format_to(std::back_inserter(buffer), " (suppressed {} similar)", suppressed);
+		}
 		log(level, {buffer.data(), buffer.size()});
 	} catch (const std::exception &e) {
 		fprintf(stderr, "[LOGGER FATAL] Failed to format log message: %s\n", e.what());
 	} catch (...) {
 		fprintf(stderr, "[LOGGER FATAL] An unknown error occurred while formatting log message.\n");
 	}
+
+	mutable ILoggerDetail::CallSiteRateLimiter rateLimiter;
 };
 
 } // namespace BridgeUtils
@@ -18,28 +18,46 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #pragma once
 
-#include <mutex>
 #include <sstream>
+#include <string>
 #include <string_view>
 
 #include <backward.hpp>
 
 #include <util/base.h>
 
+#include "AsyncLogQueue.hpp"
 #include "ILogger.hpp"
 #include "ObsUnique.hpp"
 
 namespace KaitoTokyo {
 namespace BridgeUtils {
 
+/**
+ * @brief An ILogger that forwards messages to blog() from a background thread.
+ *
+ * log() only copies the message into an AsyncLogQueue, so callers on the render or video threads
+ * never wait on blog() or on each other. Messages are dropped rather than blocking when the queue is full.
+ */
 class ObsLogger final : public ILogger {
 public:
-	ObsLogger(const std::string &_prefix) : prefix(_prefix) {}
+	ObsLogger(const std::string &_prefix)
+		: prefix(_prefix),
+		  queue([](int blogLevel, std::string_view message) {
+			  blog(blogLevel, "%.*s", static_cast<int>(message.length()), message.data());
+		  },
+			LOG_WARNING)
+	{
+	}
+
+	/**
+	 * @brief Flushes the queued messages and stops the background thread. Later messages go to blog() directly.
+	 */
+	void stop() noexcept { queue.stop(); }
 
 protected:
 	void log(LogLevel level, std::string_view message) const noexcept override
 	{
-		std::lock_guard<std::mutex> lock(mtx);
 		int blogLevel;
 		switch (level) {
 		case LogLevel::Debug:
@@ -59,16 +77,7 @@ protected:
 			return;
 		}
 
-		constexpr size_t MAX_LOG_CHUNK_SIZE = 4000;
-
-		if (message.length() <= MAX_LOG_CHUNK_SIZE) {
-			blog(blogLevel, "%.*s", static_cast<int>(message.length()), message.data());
-		} else {
-			for (size_t i = 0; i < message.length(); i += MAX_LOG_CHUNK_SIZE) {
-				const auto chunk = message.substr(i, MAX_LOG_CHUNK_SIZE);
-				blog(blogLevel, "%.*s", static_cast<int>(chunk.length()), chunk.data());
-			}
-		}
+		queue.tryPush(blogLevel, message);
 	}
 
 	void logException(const std::exception &e, std::string_view context) const noexcept override
@@ -94,7 +103,7 @@ protected:
 
 private:
 	const std::string prefix;
-	mutable std::mutex mtx;
+	mutable AsyncLogQueue queue;
 };
 
 } // namespace BridgeUtils
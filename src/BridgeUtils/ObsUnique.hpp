@@ -38,6 +38,14 @@ struct ObsDataArrayDeleter {
 	void operator()(obs_data_array_t *array) const { obs_data_array_release(array); }
 };
 
+struct ObsSourceDeleter {
+	void operator()(obs_source_t *source) const { obs_source_release(source); }
+};
+
+struct ObsWeakSourceDeleter {
+	void operator()(obs_weak_source_t *weakSource) const { obs_weak_source_release(weakSource); }
+};
+
 } // namespace ObsUnique
 
 using unique_bfree_char_t = std::unique_ptr<char, ObsUnique::BfreeDeleter>;
@@ -49,6 +57,8 @@ inline unique_bfree_char_t unique_obs_module_file(const char *file)
 
 using unique_obs_data_t = std::unique_ptr<obs_data_t, ObsUnique::ObsDataDeleter>;
 using unique_obs_data_array_t = std::unique_ptr<obs_data_array_t, ObsUnique::ObsDataArrayDeleter>;
+using unique_obs_source_t = std::unique_ptr<obs_source_t, ObsUnique::ObsSourceDeleter>;
+using unique_obs_weak_source_t = std::unique_ptr<obs_weak_source_t, ObsUnique::ObsWeakSourceDeleter>;
 
 } // namespace BridgeUtils
 } // namespace KaitoTokyo
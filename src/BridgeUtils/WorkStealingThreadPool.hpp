@@ -0,0 +1,281 @@
+/*
+Bridge Utils
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace KaitoTokyo {
+namespace BridgeUtils {
+
+namespace WorkStealingThreadPoolDetail {
+
+/**
+ * @brief Pins a thread to one logical core. Best effort; does nothing where affinity is not supported.
+ */
+inline void pinThread(std::thread &thread, std::size_t core) noexcept
+{
+#if defined(_WIN32)
+	const std::size_t bits = sizeof(DWORD_PTR) * 8;
+	SetThreadAffinityMask(thread.native_handle(), DWORD_PTR{1} << (core % bits));
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(static_cast<int>(core % CPU_SETSIZE), &set);
+	pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+	// macOS only offers affinity hints through thread_policy_set, which the scheduler is free to ignore.
+	(void)thread;
+	(void)core;
+#endif
+}
+
+} // namespace WorkStealingThreadPoolDetail
+
+/**
+ * @brief A persistent pool of worker threads that run the iterations of parallelFor calls.
+ *
+ * Each worker owns a deque. parallelFor deals its iterations round-robin into the deques; a worker takes
+ * from the front of its own deque and, once that is empty, steals from the back of the others, so uneven
+ * iterations are balanced without a shared queue. The calling thread runs iterations too until its call is
+ * complete, which makes every parallelFor a barrier. Calls from several threads may be in flight at once.
+ */
+class WorkStealingThreadPool {
+	/**
+	 * @brief The work of one parallelFor call, owned by the calling thread for the duration of the call.
+	 */
+	struct Batch {
+		const std::function<void(std::size_t)> &body;
+		std::mutex mutex;
+		std::condition_variable done;
+		std::size_t remaining;
+		std::exception_ptr exception;
+	};
+
+	struct Task {
+		Batch *batch;
+		std::size_t index;
+	};
+
+	struct Worker {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	// Deques of the workers; the calling threads have none and only steal.
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+	// Guards the increments of queuedTasks and stopped so that sleeping workers do not miss a wake-up.
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	std::atomic<std::size_t> queuedTasks{0};
+	std::atomic<std::size_t> nextWorker{0};
+	bool stopped = false;
+
+public:
+	/**
+	 * @brief Constructor. Starts the worker threads.
+	 * @param threadCount The number of threads that run iterations, including the thread that calls
+	 * parallelFor. A pool of 1 starts no thread and runs everything on the caller.
+	 * @param pinThreads Whether to pin worker i to logical core i + 1, leaving core 0 to the caller.
+	 */
+	explicit WorkStealingThreadPool(std::size_t threadCount = getDefaultThreadCount(), bool pinThreads = false)
+	{
+		const std::size_t workerCount = std::max<std::size_t>(threadCount, 1) - 1;
+		for (std::size_t i = 0; i < workerCount; i++) {
+			workers.push_back(std::make_unique<Worker>());
+		}
+		for (std::size_t i = 0; i < workerCount; i++) {
+			threads.emplace_back(&WorkStealingThreadPool::workerLoop, this, i);
+			if (pinThreads) {
+				WorkStealingThreadPoolDetail::pinThread(threads.back(), i + 1);
+			}
+		}
+	}
+
+	/**
+	 * @brief Destructor. Waits for the worker threads to finish. No parallelFor may be in flight.
+	 */
+	~WorkStealingThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			stopped = true;
+		}
+		wake.notify_all();
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+	}
+
+	// Forbid copy and move semantics; workers hold a pointer to the pool.
+	WorkStealingThreadPool(const WorkStealingThreadPool &) = delete;
+	WorkStealingThreadPool &operator=(const WorkStealingThreadPool &) = delete;
+	WorkStealingThreadPool(WorkStealingThreadPool &&) = delete;
+	WorkStealingThreadPool &operator=(WorkStealingThreadPool &&) = delete;
+
+	/**
+	 * @brief Gets the number of logical cores, or 1 if it cannot be determined.
+	 */
+	static std::size_t getDefaultThreadCount() noexcept
+	{
+		return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+	/**
+	 * @brief Gets the number of threads that run iterations, including the caller.
+	 */
+	std::size_t getThreadCount() const noexcept { return workers.size() + 1; }
+
+	/**
+	 * @brief Runs body(i) for every i in [0, count) and returns when all of them have finished.
+	 * @throws The first exception thrown by body, after every iteration has finished.
+	 */
+	void parallelFor(std::size_t count, const std::function<void(std::size_t)> &body)
+	{
+		if (count == 0) {
+			return;
+		}
+		if (workers.empty() || count == 1) {
+			for (std::size_t i = 0; i < count; i++) {
+				body(i);
+			}
+			return;
+		}
+
+		Batch batch{body, {}, {}, count, nullptr};
+		// Counted before they are queued so that the count never drops below the tasks still in the deques.
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			queuedTasks += count;
+		}
+		const std::size_t first = nextWorker.fetch_add(1) % workers.size();
+		for (std::size_t i = 0; i < count; i++) {
+			Worker &worker = *workers[(first + i) % workers.size()];
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			worker.tasks.push_back({&batch, i});
+		}
+		wake.notify_all();
+
+		// Help until nothing is left to take, then wait for the iterations still running elsewhere.
+		while (const std::optional<Task> task = steal(0)) {
+			run(*task);
+		}
+
+		std::unique_lock<std::mutex> lock(batch.mutex);
+		batch.done.wait(lock, [&batch] { return batch.remaining == 0; });
+		if (batch.exception) {
+			std::rethrow_exception(batch.exception);
+		}
+	}
+
+private:
+	void workerLoop(std::size_t self)
+	{
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(wakeMutex);
+				wake.wait(lock, [this] { return queuedTasks > 0 || stopped; });
+				if (stopped) {
+					return;
+				}
+			}
+			while (const std::optional<Task> task = take(self)) {
+				run(*task);
+			}
+		}
+	}
+
+	/**
+	 * @brief Takes the oldest task of the given worker, or steals the newest one of another worker.
+	 */
+	std::optional<Task> take(std::size_t self)
+	{
+		{
+			Worker &worker = *workers[self];
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			if (!worker.tasks.empty()) {
+				const Task task = worker.tasks.front();
+				worker.tasks.pop_front();
+				queuedTasks--;
+				return task;
+			}
+		}
+		return steal(self + 1);
+	}
+
+	/**
+	 * @brief Steals the newest task of any worker, starting the search at the given one.
+	 */
+	std::optional<Task> steal(std::size_t first)
+	{
+		for (std::size_t i = 0; i < workers.size(); i++) {
+			Worker &victim = *workers[(first + i) % workers.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				const Task task = victim.tasks.back();
+				victim.tasks.pop_back();
+				queuedTasks--;
+				return task;
+			}
+		}
+		return std::nullopt;
+	}
+
+	static void run(const Task &task)
+	{
+		Batch &batch = *task.batch;
+		std::exception_ptr exception;
+		try {
+			batch.body(task.index);
+		} catch (...) {
+			exception = std::current_exception();
+		}
+
+		// The batch lives on the stack of the caller, which returns as soon as it observes the last
+		// decrement, so the notification is sent before the mutex is released.
+		std::lock_guard<std::mutex> lock(batch.mutex);
+		if (exception && !batch.exception) {
+			batch.exception = exception;
+		}
+		if (--batch.remaining == 0) {
+			batch.done.notify_all();
+		}
+	}
+};
+
+} // namespace BridgeUtils
+} // namespace KaitoTokyo
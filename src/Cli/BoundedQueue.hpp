@@ -0,0 +1,93 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace Cli {
+
+/**
+ * @brief A blocking FIFO with a fixed capacity that connects two pipeline stages.
+ *
+ * push() waits while the queue is full, so a fast producer is throttled to the pace of its consumer
+ * instead of dropping work as ThrottledTaskQueue does. close() wakes every waiter; pop() keeps returning
+ * the remaining items and then std::nullopt.
+ */
+template<typename T> class BoundedQueue {
+public:
+	explicit BoundedQueue(std::size_t _capacity) : capacity(_capacity > 0 ? _capacity : 1) {}
+
+	BoundedQueue(const BoundedQueue &) = delete;
+	BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+	/**
+	 * @return false if the queue has been closed and the item was discarded.
+	 */
+	bool push(T item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+		if (closed) {
+			return false;
+		}
+		items.push_back(std::move(item));
+		notEmpty.notify_one();
+		return true;
+	}
+
+	std::optional<T> pop()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+		if (items.empty()) {
+			return std::nullopt;
+		}
+		T item = std::move(items.front());
+		items.pop_front();
+		notFull.notify_one();
+		return item;
+	}
+
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		notEmpty.notify_all();
+		notFull.notify_all();
+	}
+
+private:
+	const std::size_t capacity;
+	std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+	std::deque<T> items;
+	bool closed = false;
+};
+
+} // namespace Cli
+} // namespace ShowDraw
+} // namespace KaitoTokyo
@@ -0,0 +1,133 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace Cli {
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ *
+ * Frames are parsed in place, so hours of recordings are never copied into memory up front;
+ * the kernel pages them in as the decoder advances and the mapping is marked sequential where supported.
+ */
+class MappedFile {
+public:
+	explicit MappedFile(const std::string &path)
+	{
+#if defined(_WIN32)
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+				   FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("Failed to open " + path);
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize)) {
+			CloseHandle(file);
+			throw std::runtime_error("Failed to get the size of " + path);
+		}
+		size = static_cast<std::size_t>(fileSize.QuadPart);
+		if (size > 0) {
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+			if (!view) {
+				if (mapping) {
+					CloseHandle(mapping);
+				}
+				CloseHandle(file);
+				throw std::runtime_error("Failed to map " + path);
+			}
+			data = static_cast<const std::uint8_t *>(view);
+		}
+#else
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error("Failed to open " + path);
+		}
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			close(fd);
+			throw std::runtime_error("Failed to get the size of " + path);
+		}
+		size = static_cast<std::size_t>(st.st_size);
+		if (size > 0) {
+			void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view == MAP_FAILED) {
+				close(fd);
+				throw std::runtime_error("Failed to map " + path);
+			}
+			madvise(view, size, MADV_SEQUENTIAL);
+			data = static_cast<const std::uint8_t *>(view);
+		}
+		close(fd);
+#endif
+	}
+
+	~MappedFile() noexcept
+	{
+#if defined(_WIN32)
+		if (data) {
+			UnmapViewOfFile(data);
+		}
+		if (mapping) {
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+#else
+		if (data) {
+			munmap(const_cast<std::uint8_t *>(data), size);
+		}
+#endif
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+	MappedFile(MappedFile &&) = delete;
+	MappedFile &operator=(MappedFile &&) = delete;
+
+	const std::uint8_t *getData() const noexcept { return data; }
+	std::size_t getSize() const noexcept { return size; }
+
+private:
+	const std::uint8_t *data = nullptr;
+	std::size_t size = 0;
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+};
+
+} // namespace Cli
+} // namespace ShowDraw
+} // namespace KaitoTokyo
@@ -0,0 +1,202 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "Y4m.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace Cli {
+
+namespace {
+
+constexpr std::string_view StreamMagic = "YUV4MPEG2";
+constexpr std::string_view FrameMagic = "FRAME";
+
+std::size_t parseDimension(std::string_view value)
+{
+	std::size_t result = 0;
+	for (char c : value) {
+		if (c < '0' || c > '9' || result > 1000000) {
+			throw std::runtime_error("Invalid Y4M dimension: " + std::string(value));
+		}
+		result = result * 10 + static_cast<std::size_t>(c - '0');
+	}
+	if (result == 0) {
+		throw std::runtime_error("Invalid Y4M dimension: " + std::string(value));
+	}
+	return result;
+}
+
+} // namespace
+
+Y4mHeader Y4mHeader::parse(std::string_view line)
+{
+	if (line.substr(0, StreamMagic.size()) != StreamMagic) {
+		throw std::runtime_error("Not a YUV4MPEG2 stream");
+	}
+
+	Y4mHeader header;
+	std::size_t pos = StreamMagic.size();
+	while (pos < line.size()) {
+		if (line[pos] == ' ') {
+			pos++;
+			continue;
+		}
+		const std::size_t end = std::min(line.find(' ', pos), line.size());
+		const std::string_view token = line.substr(pos, end - pos);
+		const std::string_view value = token.substr(1);
+		switch (token[0]) {
+		case 'W':
+			header.width = parseDimension(value);
+			break;
+		case 'H':
+			header.height = parseDimension(value);
+			break;
+		case 'F':
+			header.frameRate = std::string(value);
+			break;
+		case 'A':
+			header.pixelAspect = std::string(value);
+			break;
+		case 'C':
+			header.colorspace = std::string(value);
+			break;
+		case 'I':
+			if (value != "p" && value != "?") {
+				throw std::runtime_error("Interlaced Y4M streams are not supported");
+			}
+			break;
+		default:
+			break;
+		}
+		pos = end;
+	}
+
+	if (header.width == 0 || header.height == 0) {
+		throw std::runtime_error("Y4M header lacks W or H");
+	}
+	header.getChromaSize();
+	return header;
+}
+
+std::size_t Y4mHeader::getChromaSize() const
+{
+	const std::size_t halfWidth = (width + 1) / 2;
+	const std::size_t halfHeight = (height + 1) / 2;
+	if (colorspace == "mono") {
+		return 0;
+	}
+	if (colorspace == "420" || colorspace == "420jpeg" || colorspace == "420paldv" || colorspace == "420mpeg2") {
+		return 2 * halfWidth * halfHeight;
+	}
+	if (colorspace == "422") {
+		return 2 * halfWidth * height;
+	}
+	if (colorspace == "444") {
+		return 2 * width * height;
+	}
+	if (colorspace == "444alpha") {
+		return 3 * width * height;
+	}
+	throw std::runtime_error("Unsupported Y4M colorspace: " + colorspace);
+}
+
+FrameReader::FrameReader(const std::uint8_t *_data, std::size_t _size) : data(_data), size(_size), isY4m(true)
+{
+	const void *newline = std::memchr(data, '\n', size);
+	if (!newline) {
+		throw std::runtime_error("Y4M header is not terminated");
+	}
+	const std::size_t headerSize = static_cast<std::size_t>(static_cast<const std::uint8_t *>(newline) - data);
+	header = Y4mHeader::parse(std::string_view(reinterpret_cast<const char *>(data), headerSize));
+	chromaSize = header.getChromaSize();
+	offset = headerSize + 1;
+}
+
+FrameReader::FrameReader(const std::uint8_t *_data, std::size_t _size, std::size_t width, std::size_t height,
+			 std::string frameRate)
+	: data(_data),
+	  size(_size),
+	  isY4m(false)
+{
+	header.width = width;
+	header.height = height;
+	header.frameRate = std::move(frameRate);
+	header.colorspace = "mono";
+}
+
+std::optional<ConstLumaView> FrameReader::next()
+{
+	if (offset >= size) {
+		return std::nullopt;
+	}
+
+	if (isY4m) {
+		const std::size_t remaining = size - offset;
+		if (remaining < FrameMagic.size() ||
+		    std::memcmp(data + offset, FrameMagic.data(), FrameMagic.size()) != 0) {
+			throw std::runtime_error("Y4M frame header not found at offset " + std::to_string(offset));
+		}
+		const void *newline = std::memchr(data + offset, '\n', remaining);
+		if (!newline) {
+			throw std::runtime_error("Y4M frame header is not terminated");
+		}
+		offset = static_cast<std::size_t>(static_cast<const std::uint8_t *>(newline) - data) + 1;
+	}
+
+	const std::size_t lumaSize = header.width * header.height;
+	if (size - offset < lumaSize + chromaSize) {
+		throw std::runtime_error("Truncated frame at offset " + std::to_string(offset));
+	}
+
+	const ConstLumaView luma{data + offset, header.width, header.height, header.width};
+	offset += lumaSize + chromaSize;
+	return luma;
+}
+
+Y4mMonoWriter::Y4mMonoWriter(std::FILE *_file, const Y4mHeader &inputHeader) : file(_file)
+{
+	const std::string header = std::string(StreamMagic) + " W" + std::to_string(inputHeader.width) + " H" +
+				   std::to_string(inputHeader.height) + " F" + inputHeader.frameRate + " Ip A" +
+				   inputHeader.pixelAspect + " Cmono\n";
+	if (std::fwrite(header.data(), 1, header.size(), file) != header.size()) {
+		throw std::runtime_error("Failed to write the Y4M header");
+	}
+}
+
+void Y4mMonoWriter::write(const ConstLumaView &luma)
+{
+	bool ok = std::fwrite("FRAME\n", 1, 6, file) == 6;
+	for (std::size_t y = 0; ok && y < luma.height; y++) {
+		ok = std::fwrite(luma.row(y), 1, luma.width, file) == luma.width;
+	}
+	if (!ok) {
+		throw std::runtime_error("Failed to write a frame");
+	}
+}
+
+} // namespace Cli
+} // namespace ShowDraw
+} // namespace KaitoTokyo
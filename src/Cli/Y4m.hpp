@@ -0,0 +1,106 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "../CpuKernels/CpuKernels.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace Cli {
+
+/**
+ * @brief The stream parameters of a YUV4MPEG2 file. Only 8-bit streams are supported.
+ */
+struct Y4mHeader {
+	std::size_t width = 0;
+	std::size_t height = 0;
+	std::string frameRate = "30:1";
+	std::string pixelAspect = "1:1";
+	std::string colorspace = "420jpeg";
+
+	/**
+	 * @brief Parses the header line, without the trailing newline.
+	 * @throws std::runtime_error if the header is malformed or describes an unsupported stream.
+	 */
+	static Y4mHeader parse(std::string_view line);
+
+	/**
+	 * @brief Gets the number of bytes that follow the luma plane in each frame.
+	 */
+	std::size_t getChromaSize() const;
+};
+
+/**
+ * @brief Walks the frames of a Y4M stream or of a headerless file of packed luma planes, in place.
+ *
+ * Returned views point into the given buffer, which must outlive them.
+ */
+class FrameReader {
+public:
+	/**
+	 * @brief Reads a Y4M stream.
+	 */
+	FrameReader(const std::uint8_t *data, std::size_t size);
+
+	/**
+	 * @brief Reads raw 8-bit luma planes of the given size back to back.
+	 */
+	FrameReader(const std::uint8_t *data, std::size_t size, std::size_t width, std::size_t height,
+		    std::string frameRate);
+
+	const Y4mHeader &getHeader() const noexcept { return header; }
+
+	/**
+	 * @return std::nullopt at the end of the stream.
+	 * @throws std::runtime_error if the stream is truncated or malformed.
+	 */
+	std::optional<CpuKernels::ConstLumaView> next();
+
+private:
+	const std::uint8_t *const data;
+	const std::size_t size;
+	const bool isY4m;
+	Y4mHeader header;
+	std::size_t chromaSize = 0;
+	std::size_t offset = 0;
+};
+
+/**
+ * @brief Writes a Y4M stream of luma planes with the Cmono colorspace.
+ */
+class Y4mMonoWriter {
+public:
+	Y4mMonoWriter(std::FILE *_file, const Y4mHeader &inputHeader);
+
+	void write(const CpuKernels::ConstLumaView &luma);
+
+private:
+	std::FILE *const file;
+};
+
+} // namespace Cli
+} // namespace ShowDraw
+} // namespace KaitoTokyo
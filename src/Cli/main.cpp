@@ -0,0 +1,323 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+/**
+ * showdraw-cli: runs the ShowDraw pipeline over a recorded stream, faster than real time.
+ *
+ * The input is memory-mapped and walked in place by a decode thread; a processing thread runs CpuEngine, whose
+ * stages are split into row bands over a work-stealing thread pool; the main thread writes a Y4M Cmono stream.
+ * Stages are connected by bounded queues, and output buffers are recycled through a pool so that no allocation
+ * happens per frame.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "../BridgeUtils/WorkStealingThreadPool.hpp"
+#include "../Core/Preset.hpp"
+#include "../CpuEngine/CpuEngine.hpp"
+#include "../CpuKernels/CpuKernels.hpp"
+
+#include "BoundedQueue.hpp"
+#include "MappedFile.hpp"
+#include "Y4m.hpp"
+
+using namespace KaitoTokyo::BridgeUtils;
+using namespace KaitoTokyo::ShowDraw;
+using namespace KaitoTokyo::ShowDraw::Cli;
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+
+namespace {
+
+constexpr const char *Usage =
+	R"(Usage: showdraw-cli [options] <input> <output>
+
+Runs the ShowDraw pipeline on the CPU over a Y4M file (or raw 8-bit luma planes) and writes a Y4M Cmono stream.
+Only the luma plane of the input is used. Use "-" as output to write to standard output.
+
+Options:
+  --raw=WxH                 Read headerless luma planes of the given size instead of Y4M
+  --fps=N:D                 Frame rate written for raw input (default 30:1)
+  --mode=MODE               passthrough, grayscale, motion or sobel (default sobel)
+  --median=on|off           Median filter (default on)
+  --strength=F              Motion-adaptive filtering strength, 0 disables it (default 0.5)
+  --threshold=F             Motion-adaptive filtering motion threshold (default 0.3)
+  --sobel-log=on|off        Logarithmic Sobel response (default on)
+  --sobel-db=F              Sobel scaling factor in dB (default 10)
+  --isa=ISA                 scalar, sse41, avx2 or neon (default: the fastest supported)
+  --frames=N                Stop after N frames
+  --queue=N                 Frames buffered between stages (default 4)
+  --threads=N               Threads that process the bands of a frame (default: one per logical core)
+  --pin-threads=on|off      Pin each processing thread to its own core (default off)
+)";
+
+struct Options {
+	std::string inputPath;
+	std::string outputPath;
+	std::size_t rawWidth = 0;
+	std::size_t rawHeight = 0;
+	std::string rawFrameRate = "30:1";
+	Preset preset;
+	const KernelSet *kernels = &getKernels();
+	std::size_t maxFrames = 0;
+	std::size_t queueDepth = 4;
+	std::size_t threadCount = WorkStealingThreadPool::getDefaultThreadCount();
+	bool pinThreads = false;
+};
+
+bool parseSwitch(const std::string &value)
+{
+	if (value == "on") {
+		return true;
+	}
+	if (value == "off") {
+		return false;
+	}
+	throw std::invalid_argument("Expected on or off but got " + value);
+}
+
+Options parseOptions(int argc, char **argv)
+{
+	Options options;
+	// The plugin stores the Sobel scaling factor in amplitude dB once the user edits it; keep the same meaning.
+	options.preset.sobelScalingFactor = DecibelField::fromDbAmp(options.preset.sobelScalingFactor.db);
+	options.preset.extractionMode = ExtractionMode::SobelMagnitude;
+
+	std::vector<std::string> positional;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		const std::size_t equals = arg.find('=');
+		const std::string name = arg.substr(0, equals);
+		const std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+
+		if (arg.size() < 3 || arg.compare(0, 2, "--") != 0) {
+			positional.push_back(arg);
+		} else if (name == "--help") {
+			std::cout << Usage;
+			std::exit(0);
+		} else if (name == "--raw") {
+			const std::size_t x = value.find('x');
+			if (x == std::string::npos) {
+				throw std::invalid_argument("--raw expects WxH");
+			}
+			options.rawWidth = std::stoul(value.substr(0, x));
+			options.rawHeight = std::stoul(value.substr(x + 1));
+		} else if (name == "--fps") {
+			options.rawFrameRate = value;
+		} else if (name == "--mode") {
+			if (value == "passthrough") {
+				options.preset.extractionMode = ExtractionMode::Passthrough;
+			} else if (value == "grayscale") {
+				options.preset.extractionMode = ExtractionMode::ConvertToGrayscale;
+			} else if (value == "motion") {
+				options.preset.extractionMode = ExtractionMode::MotionMapCalculation;
+			} else if (value == "sobel") {
+				options.preset.extractionMode = ExtractionMode::SobelMagnitude;
+			} else {
+				throw std::invalid_argument("Unknown mode " + value);
+			}
+		} else if (name == "--median") {
+			options.preset.medianFilterEnabled = parseSwitch(value);
+		} else if (name == "--strength") {
+			options.preset.motionAdaptiveFilteringStrength = std::stod(value);
+		} else if (name == "--threshold") {
+			options.preset.motionAdaptiveFilteringMotionThreshold = std::stod(value);
+		} else if (name == "--sobel-log") {
+			options.preset.sobelUseLog = parseSwitch(value);
+		} else if (name == "--sobel-db") {
+			options.preset.sobelScalingFactor = DecibelField::fromDbAmp(std::stod(value));
+		} else if (name == "--isa") {
+			const KernelIsa isa = value == "scalar" ? KernelIsa::Scalar
+					      : value == "sse41" ? KernelIsa::Sse41
+					      : value == "avx2"  ? KernelIsa::Avx2
+					      : value == "neon"  ? KernelIsa::Neon
+								 : throw std::invalid_argument("Unknown ISA " + value);
+			options.kernels = getKernels(isa);
+			if (!options.kernels) {
+				throw std::invalid_argument(value + " is not supported on this CPU");
+			}
+		} else if (name == "--frames") {
+			options.maxFrames = std::stoul(value);
+		} else if (name == "--queue") {
+			options.queueDepth = std::stoul(value);
+		} else if (name == "--threads") {
+			options.threadCount = std::stoul(value);
+			if (options.threadCount == 0) {
+				throw std::invalid_argument("--threads expects at least 1");
+			}
+		} else if (name == "--pin-threads") {
+			options.pinThreads = parseSwitch(value);
+		} else {
+			throw std::invalid_argument("Unknown option " + name);
+		}
+	}
+
+	if (positional.size() != 2) {
+		throw std::invalid_argument("Expected an input and an output");
+	}
+	options.inputPath = positional[0];
+	options.outputPath = positional[1];
+	return options;
+}
+
+std::FILE *openOutput(const std::string &path)
+{
+	if (path == "-") {
+#if defined(_WIN32)
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		return stdout;
+	}
+	std::FILE *file = std::fopen(path.c_str(), "wb");
+	if (!file) {
+		throw std::runtime_error("Failed to open " + path);
+	}
+	return file;
+}
+
+int run(const Options &options)
+{
+	const MappedFile input(options.inputPath);
+	FrameReader reader = options.rawWidth > 0 ? FrameReader(input.getData(), input.getSize(), options.rawWidth,
+								 options.rawHeight, options.rawFrameRate)
+						  : FrameReader(input.getData(), input.getSize());
+	const Y4mHeader &header = reader.getHeader();
+
+	std::FILE *output = openOutput(options.outputPath);
+	std::vector<char> outputBuffer(1 << 20);
+	std::setvbuf(output, outputBuffer.data(), _IOFBF, outputBuffer.size());
+	Y4mMonoWriter writer(output, header);
+
+	const PresetSnapshot snapshot(options.preset, 1);
+	WorkStealingThreadPool threadPool(options.threadCount, options.pinThreads);
+	CpuEngine engine(header.width, header.height, *options.kernels, &threadPool);
+
+	BoundedQueue<ConstLumaView> decoded(options.queueDepth);
+	BoundedQueue<LumaImage> processed(options.queueDepth);
+	BoundedQueue<LumaImage> pool(options.queueDepth + 2);
+	for (std::size_t i = 0; i < options.queueDepth + 2; i++) {
+		pool.push(LumaImage(header.width, header.height));
+	}
+
+	std::exception_ptr decodeError;
+	std::exception_ptr processError;
+
+	std::thread decodeThread([&] {
+		try {
+			std::size_t count = 0;
+			while (options.maxFrames == 0 || count < options.maxFrames) {
+				std::optional<ConstLumaView> frame = reader.next();
+				if (!frame || !decoded.push(*frame)) {
+					break;
+				}
+				count++;
+			}
+		} catch (...) {
+			decodeError = std::current_exception();
+		}
+		decoded.close();
+	});
+
+	std::thread processThread([&] {
+		try {
+			while (std::optional<ConstLumaView> frame = decoded.pop()) {
+				std::optional<LumaImage> buffer = pool.pop();
+				if (!buffer) {
+					break;
+				}
+				const ConstLumaView result = engine.processLuma(*frame, snapshot);
+				for (std::size_t y = 0; y < result.height; y++) {
+					std::memcpy(buffer->pixels.data() + y * buffer->width, result.row(y), result.width);
+				}
+				if (!processed.push(std::move(*buffer))) {
+					break;
+				}
+			}
+		} catch (...) {
+			processError = std::current_exception();
+			decoded.close();
+		}
+		processed.close();
+	});
+
+	const auto start = std::chrono::steady_clock::now();
+	std::size_t frameCount = 0;
+	std::exception_ptr writeError;
+	try {
+		while (std::optional<LumaImage> frame = processed.pop()) {
+			writer.write(frame->view());
+			pool.push(std::move(*frame));
+			frameCount++;
+		}
+		if (std::fflush(output) != 0) {
+			throw std::runtime_error("Failed to flush the output");
+		}
+	} catch (...) {
+		writeError = std::current_exception();
+		decoded.close();
+		processed.close();
+		pool.close();
+	}
+
+	decodeThread.join();
+	processThread.join();
+	if (output != stdout) {
+		std::fclose(output);
+	}
+
+	for (const std::exception_ptr &error : {decodeError, processError, writeError}) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << "Processed " << frameCount << " frames of " << header.width << "x" << header.height << " in "
+		  << seconds << " s (" << (seconds > 0 ? static_cast<double>(frameCount) / seconds : 0.0)
+		  << " fps) with " << options.kernels->name << " kernels" << std::endl;
+	return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+try {
+	return run(parseOptions(argc, argv));
+} catch (const std::invalid_argument &e) {
+	std::cerr << "showdraw-cli: " << e.what() << "\n\n" << Usage;
+	return 2;
+} catch (const std::exception &e) {
+	std::cerr << "showdraw-cli: " << e.what() << std::endl;
+	return 1;
+}
@@ -0,0 +1,136 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <vector>
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @brief A read-only luma plane. Samples are pixelStride bytes apart, which covers packed YUV and RGB formats.
+ */
+struct LumaPlaneView {
+	const std::uint8_t *data;
+	std::size_t linesize;
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t pixelStride;
+
+	std::uint8_t at(std::uint32_t x, std::uint32_t y) const noexcept
+	{
+		return data[static_cast<std::size_t>(y) * linesize + static_cast<std::size_t>(x) * pixelStride];
+	}
+};
+
+/**
+ * @class ActivityGate
+ * @brief Tells whether the drawing is changing from a sparse grid of luma samples of each source frame.
+ *
+ * Owned by the thread that calls filter_video. A frame is active when enough grid samples differ from the
+ * reference by more than the sensor noise. While active the reference follows every frame; once no activity has
+ * been seen for the hold time the gate turns idle and freezes the reference, so that slow changes such as a
+ * drifting light still add up until they wake it. Costs a few thousand byte reads per frame.
+ */
+class ActivityGate {
+public:
+	static constexpr std::uint32_t GridWidth = 128;
+	static constexpr std::uint32_t GridHeight = 72;
+	// Luma levels a sample must change by to count, well above camera noise.
+	static constexpr int SampleThreshold = 16;
+	// The fraction of changed samples that counts as activity; about 18 samples, so a moving pen is enough.
+	static constexpr float ActiveFraction = 0.002f;
+
+	/**
+	 * @brief Registers a new source frame.
+	 * @param holdSeconds How long the gate stays active after the last activity.
+	 * @return The new state if it changed.
+	 */
+	std::optional<bool> update(const LumaPlaneView &luma, std::uint64_t timestamp, double holdSeconds)
+	{
+		// Samples sit at the centers of the grid cells.
+		samples.resize(static_cast<std::size_t>(GridWidth) * GridHeight);
+		for (std::uint32_t gy = 0; gy < GridHeight; gy++) {
+			const std::uint64_t y = (2ULL * gy + 1) * luma.height / (2 * GridHeight);
+			for (std::uint32_t gx = 0; gx < GridWidth; gx++) {
+				const std::uint64_t x = (2ULL * gx + 1) * luma.width / (2 * GridWidth);
+				samples[static_cast<std::size_t>(gy) * GridWidth + gx] =
+					luma.at(static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y));
+			}
+		}
+
+		if (reference.size() != samples.size() || timestamp < lastActivityTimestamp ||
+		    getChangedFraction(samples, reference) >= ActiveFraction) {
+			lastActivityTimestamp = timestamp;
+		}
+
+		const auto holdNs = static_cast<std::uint64_t>(std::max(holdSeconds, 0.0) * 1e9);
+		const bool nowActive = timestamp - lastActivityTimestamp <= holdNs;
+		if (nowActive) {
+			reference.swap(samples);
+		}
+		return setActive(nowActive);
+	}
+
+	/**
+	 * @brief Forgets the reference and turns active, e.g. when gating is disabled.
+	 * @return The new state if it changed.
+	 */
+	std::optional<bool> reset() noexcept
+	{
+		reference.clear();
+		return setActive(true);
+	}
+
+	bool isActive() const noexcept { return active; }
+
+	static float getChangedFraction(const std::vector<std::uint8_t> &a, const std::vector<std::uint8_t> &b) noexcept
+	{
+		std::size_t changed = 0;
+		for (std::size_t i = 0; i < a.size(); i++) {
+			if (std::abs(int{a[i]} - int{b[i]}) > SampleThreshold) {
+				changed++;
+			}
+		}
+		return a.empty() ? 0.0f : static_cast<float>(changed) / static_cast<float>(a.size());
+	}
+
+private:
+	std::optional<bool> setActive(bool newActive) noexcept
+	{
+		if (newActive == active) {
+			return std::nullopt;
+		}
+		active = newActive;
+		return active;
+	}
+
+	std::vector<std::uint8_t> reference;
+	std::vector<std::uint8_t> samples;
+	std::uint64_t lastActivityTimestamp = 0;
+	bool active = true;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
@@ -0,0 +1,155 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @brief The statistics of one block of a single-channel image, as produced by the GPU reduction.
+ */
+struct BlockStats {
+	float mean;
+	float meanSquare;
+	float max;
+
+	float getStdDev() const noexcept { return std::sqrt(std::max(meanSquare - mean * mean, 0.0f)); }
+};
+
+namespace AutoCalibratorDetail {
+
+/**
+ * @brief Gets the value below which the given fraction of values lie. Reorders the values.
+ */
+inline float getPercentile(std::vector<float> &values, float fraction) noexcept
+{
+	if (values.empty()) {
+		return 0.0f;
+	}
+	const auto index = static_cast<std::size_t>(std::clamp(fraction, 0.0f, 1.0f) *
+						    static_cast<float>(values.size() - 1));
+	std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+	return values[index];
+}
+
+} // namespace AutoCalibratorDetail
+
+/**
+ * @class AutoCalibrator
+ * @brief Derives the Sobel scaling factor and the motion threshold from block statistics of the live image.
+ *
+ * Most of a drawing surface is blank paper, so the median block is taken as the noise floor and a high percentile
+ * of the block maxima as the level of the strokes. The Sobel scaling factor maps that stroke level to full white,
+ * and the motion threshold sits a few noise deviations above the temporal noise so that sensor noise is still
+ * averaged away while real motion is not. Targets are smoothed exponentially so that the output does not pump.
+ */
+class AutoCalibrator {
+public:
+	static constexpr float StrokePercentile = 0.9f;
+	static constexpr float StrokeToNoiseRatio = 4.0f;
+	static constexpr float MinStrokeLevel = 0.02f;
+	static constexpr float MinSobelScalingFactor = 0.1f;
+	static constexpr float MaxSobelScalingFactor = 10.0f;
+
+	static constexpr float MotionNoiseDeviations = 3.0f;
+	static constexpr float MinMotionThreshold = 0.02f;
+	static constexpr float MaxMotionThreshold = 0.5f;
+
+	// The weight of each new measurement; about a second to settle at 30 fps.
+	static constexpr float SmoothingFactor = 0.05f;
+
+	/**
+	 * @param blocks Statistics of the unscaled Sobel magnitude.
+	 * @param useLog Whether the magnitude is log-compressed before scaling.
+	 */
+	void updateSobel(const std::vector<BlockStats> &blocks, bool useLog)
+	{
+		if (blocks.empty()) {
+			return;
+		}
+
+		scratch.clear();
+		for (const BlockStats &block : blocks) {
+			scratch.push_back(block.mean);
+		}
+		const float noise = AutoCalibratorDetail::getPercentile(scratch, 0.5f);
+
+		scratch.clear();
+		for (const BlockStats &block : blocks) {
+			scratch.push_back(block.max);
+		}
+		const float stroke = AutoCalibratorDetail::getPercentile(scratch, StrokePercentile);
+
+		// A blank sheet has no strokes to measure; keep the gain from amplifying its noise.
+		const float level = std::max({stroke, noise * StrokeToNoiseRatio, MinStrokeLevel});
+		const float compressed = useLog ? std::log2(1.0f + level) : level;
+		const float target = std::clamp(1.0f / compressed, MinSobelScalingFactor, MaxSobelScalingFactor);
+
+		// The gain is smoothed in the log domain so that it moves evenly in both directions.
+		const float targetLog = std::log(target);
+		sobelScalingFactorLog = sobelScalingFactorLog
+						? *sobelScalingFactorLog +
+							  SmoothingFactor * (targetLog - *sobelScalingFactorLog)
+						: targetLog;
+	}
+
+	/**
+	 * @param blocks Statistics of the motion map.
+	 */
+	void updateMotion(const std::vector<BlockStats> &blocks)
+	{
+		if (blocks.empty()) {
+			return;
+		}
+
+		scratch.clear();
+		for (const BlockStats &block : blocks) {
+			scratch.push_back(block.mean + MotionNoiseDeviations * block.getStdDev());
+		}
+		const float target = std::clamp(AutoCalibratorDetail::getPercentile(scratch, 0.5f), MinMotionThreshold,
+						MaxMotionThreshold);
+
+		motionThreshold = motionThreshold ? *motionThreshold + SmoothingFactor * (target - *motionThreshold)
+						  : target;
+	}
+
+	std::optional<float> getSobelScalingFactor() const noexcept
+	{
+		if (!sobelScalingFactorLog) {
+			return std::nullopt;
+		}
+		return std::exp(*sobelScalingFactorLog);
+	}
+
+	std::optional<float> getMotionThreshold() const noexcept { return motionThreshold; }
+
+private:
+	std::optional<float> sobelScalingFactorLog;
+	std::optional<float> motionThreshold;
+	std::vector<float> scratch;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
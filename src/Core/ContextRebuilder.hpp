@@ -0,0 +1,125 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @class ContextRebuilder
+ * @brief Holds the context built for the current spec, which one thread requests and another builds.
+ *
+ * The filter thread asks for the context of the frame it has; when the published one was built for another spec, it
+ * records the request and gets null until the rebuild is done. The graphics thread builds the requested context at
+ * its next opportunity and publishes it with an atomic swap, so neither thread waits for the other and any thread
+ * may keep using the context it loaded until it lets go. Only the latest request is built.
+ */
+template<typename Context, typename Spec> class ContextRebuilder {
+public:
+	/**
+	 * @param spec What the context should be built for, or nullopt for no context.
+	 * @return The published context if it was built for the spec, otherwise null.
+	 */
+	std::shared_ptr<Context> acquire(const std::optional<Spec> &spec)
+	{
+		const std::shared_ptr<const Entry> entry = std::atomic_load(&published);
+		const bool matches = entry ? spec && entry->spec == *spec : !spec;
+		// A request that has not been built yet is withdrawn when the frames go back to the published spec.
+		if (!matches || hasRequest.load()) {
+			std::lock_guard<std::mutex> lock(mutex);
+			requested = spec;
+			hasRequest.store(!matches);
+		}
+		return matches && entry ? entry->context : nullptr;
+	}
+
+	/**
+	 * @return The published context, whatever it was built for.
+	 */
+	std::shared_ptr<Context> get() const
+	{
+		const std::shared_ptr<const Entry> entry = std::atomic_load(&published);
+		return entry ? entry->context : nullptr;
+	}
+
+	/**
+	 * @brief Builds and publishes the requested context, unless it is the one already published.
+	 * @param make Builds the context for a spec. If it throws, the request is dropped and the old context stays.
+	 * @return Whether another context was published.
+	 */
+	template<typename Factory> bool rebuild(Factory &&make)
+	{
+		std::optional<Spec> spec;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!hasRequest.load()) {
+				return false;
+			}
+			spec = std::move(requested);
+			hasRequest.store(false);
+		}
+
+		const std::shared_ptr<const Entry> current = std::atomic_load(&published);
+		if (current ? spec && current->spec == *spec : !spec) {
+			return false;
+		}
+
+		std::shared_ptr<const Entry> next;
+		if (spec) {
+			next = std::make_shared<const Entry>(Entry{*spec, make(*spec)});
+		}
+		std::atomic_store(&published, std::move(next));
+		return true;
+	}
+
+	/**
+	 * @brief Drops the published context and any request.
+	 */
+	void reset()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			requested.reset();
+			hasRequest.store(false);
+		}
+		std::atomic_store(&published, std::shared_ptr<const Entry>());
+	}
+
+private:
+	struct Entry {
+		Spec spec;
+		std::shared_ptr<Context> context;
+	};
+
+	std::shared_ptr<const Entry> published;
+
+	std::mutex mutex;
+	std::optional<Spec> requested;
+	// Written under the mutex, but read without it so that a matching frame costs no lock.
+	std::atomic<bool> hasRequest = false;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
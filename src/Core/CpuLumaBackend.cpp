@@ -0,0 +1,78 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "CpuLumaBackend.hpp"
+
+#include "SourceFrameLuma.hpp"
+
+#include <algorithm>
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+namespace {
+
+/**
+ * @brief Gets the pool shared by the CPU backends of every filter instance, started on first use.
+ */
+BridgeUtils::WorkStealingThreadPool &getSharedThreadPool()
+{
+	static BridgeUtils::WorkStealingThreadPool threadPool;
+	return threadPool;
+}
+
+} // namespace
+
+bool CpuLumaBackend::filterVideo(obs_source_frame *frame, const PresetSnapshot &snapshot, bool isSceneActive)
+{
+	const std::optional<YuvFrameView> yuv = getSourceFrameYuv(frame);
+	if (!yuv) {
+		return false;
+	}
+	if (snapshot.preset.extractionMode == ExtractionMode::Passthrough) {
+		return true;
+	}
+
+	if (!engine || engine->width != frame->width || engine->height != frame->height) {
+		engine = std::make_unique<CpuEngine>(frame->width, frame->height, getKernels(), &getSharedThreadPool());
+		lastOutput = LumaImage();
+	}
+
+	// The temporal blend runs once per processed frame; unlike the GPU path it is not rescaled for skipped ones.
+	const bool hasOutput = lastOutput.width == frame->width && lastOutput.height == frame->height;
+	const bool isDue = isSceneActive &&
+			   processingCadence.onNewFrame(frame->timestamp, snapshot.preset.maxProcessingRate) > 0;
+	if (!hasOutput || isDue || processedEpoch != snapshot.epoch) {
+		processedEpoch = snapshot.epoch;
+		const ConstLumaView output = engine->processLuma(extractLuma(*yuv, scratch), snapshot);
+		if (!hasOutput) {
+			lastOutput = LumaImage(frame->width, frame->height);
+		}
+		for (std::size_t y = 0; y < output.height; y++) {
+			std::copy_n(output.row(y), output.width, lastOutput.view().row(y));
+		}
+	}
+
+	writeLumaWithNeutralChroma(*yuv, lastOutput.view());
+	return true;
+}
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
@@ -0,0 +1,62 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include <obs.h>
+
+#include "../CpuEngine/CpuEngine.hpp"
+
+#include "Preset.hpp"
+#include "ProcessingCadence.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @class CpuLumaBackend
+ * @brief Runs the pipeline on the Y plane of the native camera frame and writes the result back in place.
+ *
+ * Replaces drawSource and ConvertGrayscale with a direct read of the luma, so neither a color conversion nor
+ * the graphics subsystem is involved; the chroma is set to neutral so that the frame shows the grayscale result.
+ * The ROI, the mask, canvas rectification and auto-calibration belong to the GPU pipeline and are not applied.
+ * Row bands of each frame run on a thread pool shared by all instances. Owned by the thread that calls filter_video.
+ */
+class CpuLumaBackend {
+public:
+	/**
+	 * @param isSceneActive False while the drawing is static, in which case the last output is reused.
+	 * @return false if the frame format is not supported; the frame is then left untouched.
+	 */
+	bool filterVideo(obs_source_frame *frame, const PresetSnapshot &snapshot, bool isSceneActive);
+
+private:
+	std::unique_ptr<CpuEngine> engine;
+	CpuKernels::LumaImage scratch;
+	// The last processed output, written again into frames that are not processed.
+	CpuKernels::LumaImage lastOutput;
+	ProcessingCadence processingCadence;
+	std::optional<std::uint64_t> processedEpoch;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
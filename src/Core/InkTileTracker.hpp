@@ -0,0 +1,128 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "AutoCalibrator.hpp"
+#include "Preset.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @class InkTileTracker
+ * @brief Finds the tiles of the image whose edges are committed and need not be recomputed.
+ *
+ * The tiles are the blocks of the motion statistics. A tile settles once its peak motion has stayed below the
+ * threshold for the commit frame count: nothing has moved there, so its edges are those already committed. The
+ * statistics arrive a frame late, so the region to recompute is grown by one tile on each side to cover motion
+ * that has crossed into a neighbouring tile since.
+ */
+class InkTileTracker {
+public:
+	/**
+	 * @param blocks Statistics of the motion map, row by row.
+	 * @param blocksWide The number of blocks in a row.
+	 * @param commitFrames The number of motion-free frames after which a tile settles.
+	 */
+	void update(const std::vector<BlockStats> &blocks, std::uint32_t blocksWide, float motionThreshold,
+		    std::uint32_t commitFrames)
+	{
+		if (blocksWide == 0 || blocks.size() % blocksWide != 0) {
+			reset();
+			return;
+		}
+		if (blocks.size() != quietFrames.size() || blocksWide != columns) {
+			quietFrames.assign(blocks.size(), 0);
+			columns = blocksWide;
+		}
+
+		requiredFrames = std::max<std::uint32_t>(commitFrames, 1);
+		for (std::size_t i = 0; i < blocks.size(); i++) {
+			quietFrames[i] = blocks[i].max <= motionThreshold ? std::min(quietFrames[i] + 1, requiredFrames)
+									  : 0;
+		}
+	}
+
+	/**
+	 * @brief Forgets every tile, so that the whole image is recomputed until the tiles settle again.
+	 */
+	void reset() noexcept
+	{
+		quietFrames.clear();
+		columns = 0;
+	}
+
+	/**
+	 * @brief Gets the region whose edges must be recomputed.
+	 * @param width The width of the image in pixels.
+	 * @param height The height of the image in pixels.
+	 * @param blockSize The edge of a block in pixels.
+	 * @return The whole image before the first update, or nullopt if every tile has settled.
+	 */
+	std::optional<RoiRect> getDirtyRect(std::uint32_t width, std::uint32_t height,
+					    std::uint32_t blockSize) const noexcept
+	{
+		if (quietFrames.empty() || blockSize == 0) {
+			return RoiRect{0, 0, width, height};
+		}
+
+		const std::uint32_t rows = static_cast<std::uint32_t>(quietFrames.size() / columns);
+		std::uint32_t left = columns, top = rows, right = 0, bottom = 0;
+		for (std::uint32_t y = 0; y < rows; y++) {
+			for (std::uint32_t x = 0; x < columns; x++) {
+				if (quietFrames[static_cast<std::size_t>(y) * columns + x] < requiredFrames) {
+					left = std::min(left, x);
+					top = std::min(top, y);
+					right = std::max(right, x + 1);
+					bottom = std::max(bottom, y + 1);
+				}
+			}
+		}
+		if (left >= right) {
+			return std::nullopt;
+		}
+
+		const auto toPixels = [blockSize](std::uint32_t block, std::uint32_t size) {
+			return static_cast<std::uint32_t>(
+				std::min<std::uint64_t>(static_cast<std::uint64_t>(block) * blockSize, size));
+		};
+		const std::uint32_t x0 = toPixels(left > 0 ? left - 1 : 0, width);
+		const std::uint32_t y0 = toPixels(top > 0 ? top - 1 : 0, height);
+		const std::uint32_t x1 = toPixels(std::min(right + 1, columns), width);
+		const std::uint32_t y1 = toPixels(std::min(bottom + 1, rows), height);
+		if (x0 >= x1 || y0 >= y1) {
+			return std::nullopt;
+		}
+		return RoiRect{x0, y0, x1 - x0, y1 - y0};
+	}
+
+private:
+	std::vector<std::uint32_t> quietFrames;
+	std::uint32_t columns = 0;
+	std::uint32_t requiredFrames = 1;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
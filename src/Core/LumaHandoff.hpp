@@ -0,0 +1,89 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @class LumaHandoff
+ * @brief Passes the luma of processed frames from filter_video to video_render by swapping three buffers.
+ *
+ * The filter thread fills the staging buffer and publishes it; the render thread takes the latest published one to
+ * upload. Neither holds the lock for longer than a swap, and a frame published before the previous one was taken
+ * replaces it.
+ */
+class LumaHandoff {
+public:
+	/**
+	 * @brief Filter thread: the buffer for the next frame, resized to the given number of bytes.
+	 */
+	std::vector<std::uint8_t> &getStaging(std::size_t size)
+	{
+		staging.resize(size);
+		return staging;
+	}
+
+	/**
+	 * @brief Filter thread: makes the staging buffer the latest frame.
+	 */
+	void publish()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending.swap(staging);
+		hasPending = true;
+	}
+
+	/**
+	 * @brief Render thread: takes the latest frame published since the last call.
+	 * @return The frame, valid until the next call, or null if none was published.
+	 */
+	const std::vector<std::uint8_t> *take()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!hasPending) {
+			return nullptr;
+		}
+		uploading.swap(pending);
+		hasPending = false;
+		hasTaken = true;
+		return &uploading;
+	}
+
+	/**
+	 * @brief Render thread: whether a frame has ever been taken, that is whether the texture it went to holds one.
+	 */
+	bool hasTakenFrame() const noexcept { return hasTaken; }
+
+private:
+	std::vector<std::uint8_t> staging;
+	std::mutex mutex;
+	std::vector<std::uint8_t> pending;
+	bool hasPending = false;
+	std::vector<std::uint8_t> uploading;
+	bool hasTaken = false;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
@@ -18,10 +18,16 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <string>
+#include <vector>
 
 #include <obs.h>
+#include <graphics/vec2.h>
+#include <graphics/vec3.h>
+#include <graphics/vec4.h>
 
 #include "../BridgeUtils/GsUnique.hpp"
 #include "../BridgeUtils/ILogger.hpp"
@@ -30,6 +36,38 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 namespace KaitoTokyo {
 namespace ShowDraw {
 
+/**
+ * @brief How the neighbourhood techniques of main.effect fetch their input.
+ */
+enum class TexelFetchMode {
+	// Filtered Sample at texel centres, addressed with the float texel size; works on every backend.
+	Sample = 100,
+	// Point-exact Load at integer texel positions, clamped to lastTexel.
+	Load = 200,
+	// Load, except that Sobel takes four bilinear taps on texel corners instead of eight texels.
+	LoadQuadSobel = 300,
+};
+
+/**
+ * @brief Chooses the fetch mode for a graphics backend, as returned by gs_get_device_type.
+ *
+ * OBS compiles effects for Direct3D 11 with ps_4_0 and has no GLSL translation for Gather, so neither backend
+ * can gather; the corner taps of LoadQuadSobel read the same 2x2 quads instead. Direct3D 11 filters UNORM
+ * textures at full precision, whereas OpenGL drivers, including the software rasterizer, may filter 8-bit
+ * textures in 8-bit fixed point and would round the quad averages. Unknown backends keep Sample.
+ */
+inline TexelFetchMode getTexelFetchMode(int deviceType) noexcept
+{
+	switch (deviceType) {
+	case GS_DEVICE_DIRECT3D_11:
+		return TexelFetchMode::LoadQuadSobel;
+	case GS_DEVICE_OPENGL:
+		return TexelFetchMode::Load;
+	default:
+		return TexelFetchMode::Sample;
+	}
+}
+
 namespace MainEffectDetail {
 
 inline gs_eparam_t *getEffectParam(const KaitoTokyo::BridgeUtils::unique_gs_effect_t &effect, const char *name)
@@ -50,6 +88,18 @@ inline gs_technique_t *getEffectTech(const KaitoTokyo::BridgeUtils::unique_gs_ef
 	return tech;
 }
 
+/**
+ * @brief Gets the variant of a neighbourhood technique for the fetch mode.
+ */
+inline gs_technique_t *getFetchTech(const KaitoTokyo::BridgeUtils::unique_gs_effect_t &effect, std::string name,
+				    TexelFetchMode texelFetchMode)
+{
+	if (texelFetchMode != TexelFetchMode::Sample) {
+		name += "Load";
+	}
+	return getEffectTech(effect, name.c_str());
+}
+
 struct TransformStateGuard {
 	TransformStateGuard()
 	{
@@ -83,65 +133,146 @@ struct RenderTargetGuard {
 	}
 };
 
+/**
+ * @brief Restricts rendering to a rectangle of the render target while in scope. Does nothing for a null rectangle.
+ */
+struct ScissorGuard {
+	const bool isScissored;
+
+	explicit ScissorGuard(const gs_rect *rect) : isScissored(rect != nullptr)
+	{
+		if (isScissored) {
+			gs_set_scissor_rect(rect);
+		}
+	}
+
+	~ScissorGuard()
+	{
+		if (isScissored) {
+			gs_set_scissor_rect(nullptr);
+		}
+	}
+};
+
 } // namespace MainEffectDetail
 
 class MainEffect {
 public:
 	const KaitoTokyo::BridgeUtils::unique_gs_effect_t effect;
+	const TexelFetchMode texelFetchMode;
 
 	gs_eparam_t *const textureImage;
 	gs_eparam_t *const textureImage1;
+	gs_eparam_t *const textureImage2;
+	gs_eparam_t *const textureImage3;
+	gs_eparam_t *const textureImage4;
 	gs_eparam_t *const floatTexelWidth;
 	gs_eparam_t *const floatTexelHeight;
+	gs_eparam_t *const int2LastTexel;
 	gs_eparam_t *const textureMotionMap;
 	gs_eparam_t *const floatStrength;
 	gs_eparam_t *const floatMotionThreshold;
 	gs_eparam_t *const boolUseLog;
 	gs_eparam_t *const floatScalingFactor;
+	gs_eparam_t *const floatCommitFrames;
+	gs_eparam_t *const textureMask;
+	gs_eparam_t *const float4InkColor;
+	gs_eparam_t *const float2SourceOffset;
+	gs_eparam_t *const float2SourceScale;
+	gs_eparam_t *const boolUseMask;
+	gs_eparam_t *const float3HomographyX;
+	gs_eparam_t *const float3HomographyY;
+	gs_eparam_t *const float3HomographyW;
 
 	gs_technique_t *const techDraw;
 	gs_technique_t *const techDrawGrayscale;
+	gs_technique_t *const techDrawGrayscaleMasked;
+	gs_technique_t *const techDrawMultiply;
+	gs_technique_t *const techDrawOverlay;
+	gs_technique_t *const techDrawAlphaMask;
 
 	gs_technique_t *const techConvertGrayscale;
+	gs_technique_t *const techWarpConvertGrayscale;
 	gs_technique_t *const techHorizontalMedian3;
 	gs_technique_t *const techVerticalMedian3;
 	gs_technique_t *const techCalculateHorizontalMotionMap3;
 	gs_technique_t *const techCalculateVerticalMotionMap3;
 	gs_technique_t *const techMotionAdaptiveFiltering;
+	gs_technique_t *const techTemporalMedian3;
+	gs_technique_t *const techTemporalMedian5;
 	gs_technique_t *const techApplySobel;
 	gs_technique_t *const techFinalizeSobelMagnitude;
+	gs_technique_t *const techUpdateCommittedInk;
+	gs_technique_t *const techComposeCommittedInk;
+	gs_technique_t *const techReduceLuma4x4;
+	gs_technique_t *const techReduceStats4x4;
 	gs_technique_t *const techHorizontalErosion3;
 	gs_technique_t *const techVerticalErosion3;
 	gs_technique_t *const techHorizontalDilation3;
 	gs_technique_t *const techVerticalDilation3;
 
-	explicit MainEffect(const KaitoTokyo::BridgeUtils::unique_bfree_char_t &effectPath)
+	/**
+	 * @param texelFetchMode Selects the variants of the neighbourhood techniques. Must be called in the graphics
+	 * context, as the default depends on the backend.
+	 */
+	explicit MainEffect(const KaitoTokyo::BridgeUtils::unique_bfree_char_t &effectPath,
+			    TexelFetchMode _texelFetchMode = getTexelFetchMode(gs_get_device_type()))
 		: effect(KaitoTokyo::BridgeUtils::make_unique_gs_effect_from_file(effectPath)),
+		  texelFetchMode(_texelFetchMode),
 		  textureImage(MainEffectDetail::getEffectParam(effect, "image")),
 		  textureImage1(MainEffectDetail::getEffectParam(effect, "image1")),
+		  textureImage2(MainEffectDetail::getEffectParam(effect, "image2")),
+		  textureImage3(MainEffectDetail::getEffectParam(effect, "image3")),
+		  textureImage4(MainEffectDetail::getEffectParam(effect, "image4")),
 		  floatTexelWidth(MainEffectDetail::getEffectParam(effect, "texelWidth")),
 		  floatTexelHeight(MainEffectDetail::getEffectParam(effect, "texelHeight")),
+		  int2LastTexel(MainEffectDetail::getEffectParam(effect, "lastTexel")),
 		  textureMotionMap(MainEffectDetail::getEffectParam(effect, "motionMap")),
 		  floatStrength(MainEffectDetail::getEffectParam(effect, "strength")),
 		  floatMotionThreshold(MainEffectDetail::getEffectParam(effect, "motionThreshold")),
 		  boolUseLog(MainEffectDetail::getEffectParam(effect, "useLog")),
 		  floatScalingFactor(MainEffectDetail::getEffectParam(effect, "scalingFactor")),
+		  floatCommitFrames(MainEffectDetail::getEffectParam(effect, "commitFrames")),
+		  textureMask(MainEffectDetail::getEffectParam(effect, "mask")),
+		  float4InkColor(MainEffectDetail::getEffectParam(effect, "inkColor")),
+		  float2SourceOffset(MainEffectDetail::getEffectParam(effect, "sourceOffset")),
+		  float2SourceScale(MainEffectDetail::getEffectParam(effect, "sourceScale")),
+		  boolUseMask(MainEffectDetail::getEffectParam(effect, "useMask")),
+		  float3HomographyX(MainEffectDetail::getEffectParam(effect, "homographyX")),
+		  float3HomographyY(MainEffectDetail::getEffectParam(effect, "homographyY")),
+		  float3HomographyW(MainEffectDetail::getEffectParam(effect, "homographyW")),
 		  techDraw(MainEffectDetail::getEffectTech(effect, "Draw")),
 		  techDrawGrayscale(MainEffectDetail::getEffectTech(effect, "DrawGrayscale")),
+		  techDrawGrayscaleMasked(MainEffectDetail::getEffectTech(effect, "DrawGrayscaleMasked")),
+		  techDrawMultiply(MainEffectDetail::getEffectTech(effect, "DrawMultiply")),
+		  techDrawOverlay(MainEffectDetail::getEffectTech(effect, "DrawOverlay")),
+		  techDrawAlphaMask(MainEffectDetail::getEffectTech(effect, "DrawAlphaMask")),
 		  techConvertGrayscale(MainEffectDetail::getEffectTech(effect, "ConvertGrayscale")),
-		  techHorizontalMedian3(MainEffectDetail::getEffectTech(effect, "HorizontalMedian3")),
-		  techVerticalMedian3(MainEffectDetail::getEffectTech(effect, "VerticalMedian3")),
+		  techWarpConvertGrayscale(MainEffectDetail::getEffectTech(effect, "WarpConvertGrayscale")),
+		  techHorizontalMedian3(MainEffectDetail::getFetchTech(effect, "HorizontalMedian3", texelFetchMode)),
+		  techVerticalMedian3(MainEffectDetail::getFetchTech(effect, "VerticalMedian3", texelFetchMode)),
 		  techCalculateHorizontalMotionMap3(
-			  MainEffectDetail::getEffectTech(effect, "CalculateHorizontalMotionMap3")),
+			  MainEffectDetail::getFetchTech(effect, "CalculateHorizontalMotionMap3", texelFetchMode)),
 		  techCalculateVerticalMotionMap3(
-			  MainEffectDetail::getEffectTech(effect, "CalculateVerticalMotionMap3")),
-		  techMotionAdaptiveFiltering(MainEffectDetail::getEffectTech(effect, "MotionAdaptiveFiltering")),
-		  techApplySobel(MainEffectDetail::getEffectTech(effect, "ApplySobel")),
-		  techFinalizeSobelMagnitude(MainEffectDetail::getEffectTech(effect, "FinalizeSobelMagnitude")),
-		  techHorizontalErosion3(MainEffectDetail::getEffectTech(effect, "HorizontalErosion3")),
-		  techVerticalErosion3(MainEffectDetail::getEffectTech(effect, "VerticalErosion3")),
-		  techHorizontalDilation3(MainEffectDetail::getEffectTech(effect, "HorizontalDilation3")),
-		  techVerticalDilation3(MainEffectDetail::getEffectTech(effect, "VerticalDilation3"))
+			  MainEffectDetail::getFetchTech(effect, "CalculateVerticalMotionMap3", texelFetchMode)),
+		  techMotionAdaptiveFiltering(
+			  MainEffectDetail::getFetchTech(effect, "MotionAdaptiveFiltering", texelFetchMode)),
+		  techTemporalMedian3(MainEffectDetail::getEffectTech(effect, "TemporalMedian3")),
+		  techTemporalMedian5(MainEffectDetail::getEffectTech(effect, "TemporalMedian5")),
+		  techApplySobel(texelFetchMode == TexelFetchMode::LoadQuadSobel
+					 ? MainEffectDetail::getEffectTech(effect, "ApplySobelQuad")
+					 : MainEffectDetail::getFetchTech(effect, "ApplySobel", texelFetchMode)),
+		  techFinalizeSobelMagnitude(
+			  MainEffectDetail::getFetchTech(effect, "FinalizeSobelMagnitude", texelFetchMode)),
+		  techUpdateCommittedInk(MainEffectDetail::getEffectTech(effect, "UpdateCommittedInk")),
+		  techComposeCommittedInk(MainEffectDetail::getEffectTech(effect, "ComposeCommittedInk")),
+		  techReduceLuma4x4(MainEffectDetail::getEffectTech(effect, "ReduceLuma4x4")),
+		  techReduceStats4x4(MainEffectDetail::getEffectTech(effect, "ReduceStats4x4")),
+		  techHorizontalErosion3(MainEffectDetail::getFetchTech(effect, "HorizontalErosion3", texelFetchMode)),
+		  techVerticalErosion3(MainEffectDetail::getFetchTech(effect, "VerticalErosion3", texelFetchMode)),
+		  techHorizontalDilation3(
+			  MainEffectDetail::getFetchTech(effect, "HorizontalDilation3", texelFetchMode)),
+		  techVerticalDilation3(MainEffectDetail::getFetchTech(effect, "VerticalDilation3", texelFetchMode))
 	{
 	}
 
@@ -206,17 +337,150 @@ public:
 		gs_technique_end(techDrawGrayscale);
 	}
 
+	/**
+	 * @brief Draws a grayscale texture over the current target, leaving pixels outside the mask untouched.
+	 */
+	void drawGrayscaleTextureMasked(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source,
+					const KaitoTokyo::BridgeUtils::unique_gs_texture_t &mask) const noexcept
+	{
+		const std::uint32_t width = gs_texture_get_width(source.get());
+		const std::uint32_t height = gs_texture_get_height(source.get());
+
+		gs_blend_state_push();
+		gs_enable_blending(true);
+		gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+		const std::size_t passes = gs_technique_begin(techDrawGrayscaleMasked);
+		for (std::size_t i = 0; i < passes; i++) {
+			if (gs_technique_begin_pass(techDrawGrayscaleMasked, i)) {
+				gs_effect_set_texture(textureImage, source.get());
+				gs_effect_set_texture(textureMask, mask.get());
+
+				gs_draw_sprite(nullptr, 0, width, height);
+				gs_technique_end_pass(techDrawGrayscaleMasked);
+			}
+		}
+		gs_technique_end(techDrawGrayscaleMasked);
+
+		gs_blend_state_pop();
+	}
+
+	/**
+	 * @brief Draws grayscale edges multiplied onto a color source over the current target, in one pass.
+	 * @param sourceRegion The region of the color source under the drawn texture: the u and v offsets, then the u
+	 * and v scales.
+	 * @param inkColor The color that full edges multiply by, as 0xAABBGGRR like OBS color properties. The alpha is
+	 * ignored.
+	 * @param mask The region of interest mask, which limits the ink, or null.
+	 */
+	void drawGrayscaleMultiplied(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source,
+				     const KaitoTokyo::BridgeUtils::unique_gs_texture_t &color,
+				     const std::array<float, 4> &sourceRegion, std::uint32_t inkColor,
+				     const KaitoTokyo::BridgeUtils::unique_gs_texture_t *mask) const noexcept
+	{
+		drawInk(techDrawMultiply, source, &color, sourceRegion, inkColor, mask);
+	}
+
+	/**
+	 * @brief Draws the ink over a color source over the current target, as opaque as the edges are strong, in one
+	 * pass. The parameters are those of drawGrayscaleMultiplied.
+	 */
+	void drawGrayscaleOverlaid(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source,
+				   const KaitoTokyo::BridgeUtils::unique_gs_texture_t &color,
+				   const std::array<float, 4> &sourceRegion, std::uint32_t inkColor,
+				   const KaitoTokyo::BridgeUtils::unique_gs_texture_t *mask) const noexcept
+	{
+		drawInk(techDrawOverlay, source, &color, sourceRegion, inkColor, mask);
+	}
+
+	/**
+	 * @brief Draws the ink over the current target with grayscale edges as its premultiplied alpha.
+	 * @param inkColor As 0xAABBGGRR like OBS color properties. The alpha is ignored.
+	 * @param mask The region of interest mask, which limits the ink, or null.
+	 */
+	void drawGrayscaleAsAlpha(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source, std::uint32_t inkColor,
+				  const KaitoTokyo::BridgeUtils::unique_gs_texture_t *mask) const noexcept
+	{
+		gs_blend_state_push();
+		gs_enable_blending(true);
+		gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+		drawInk(techDrawAlphaMask, source, nullptr, {0.0f, 0.0f, 1.0f, 1.0f}, inkColor, mask);
+		gs_blend_state_pop();
+	}
+
+	/**
+	 * @brief Fills a rectangle of the current target with an opaque color given as 0xAARRGGBB.
+	 */
+	void drawSolidColor(std::uint32_t width, std::uint32_t height, std::uint32_t color) const noexcept
+	{
+		gs_effect_t *solid = obs_get_base_effect(OBS_EFFECT_SOLID);
+		gs_effect_set_color(gs_effect_get_param_by_name(solid, "color"), color);
+		while (gs_effect_loop(solid, "Solid")) {
+			gs_draw_sprite(nullptr, 0, width, height);
+		}
+	}
+
+	/**
+	 * @brief Renders another source, stretched to the frame, into a target that covers a region of the frame.
+	 * @param x The left edge of the region in the frame.
+	 * @param y The top edge of the region in the frame.
+	 */
+	void drawMaskSource(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target, obs_source_t *maskSource,
+			    std::uint32_t frameWidth, std::uint32_t frameHeight, std::uint32_t x,
+			    std::uint32_t y) const noexcept
+	{
+		const MainEffectDetail::RenderTargetGuard renderTargetGuard;
+		const MainEffectDetail::TransformStateGuard transformStateGuard;
+
+		const std::uint32_t width = gs_texture_get_width(target.get());
+		const std::uint32_t height = gs_texture_get_height(target.get());
+
+		gs_set_render_target_with_color_space(target.get(), nullptr, GS_CS_SRGB);
+
+		struct vec4 transparent;
+		vec4_zero(&transparent);
+		gs_clear(GS_CLEAR_COLOR, &transparent, 0.0f, 0);
+
+		const std::uint32_t maskWidth = obs_source_get_width(maskSource);
+		const std::uint32_t maskHeight = obs_source_get_height(maskSource);
+		if (maskWidth == 0 || maskHeight == 0) {
+			return;
+		}
+
+		gs_set_viewport(0, 0, width, height);
+		gs_ortho(static_cast<float>(x), static_cast<float>(x + width), static_cast<float>(y),
+			 static_cast<float>(y + height), -100.0f, 100.0f);
+		gs_matrix_identity();
+		gs_matrix_scale3f(static_cast<float>(frameWidth) / static_cast<float>(maskWidth),
+				  static_cast<float>(frameHeight) / static_cast<float>(maskHeight), 1.0f);
+
+		gs_blend_state_push();
+		gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+		obs_source_video_render(maskSource);
+		gs_blend_state_pop();
+	}
+
+	/**
+	 * @brief Converts a region of the source, scaled to fill the target.
+	 * @param regionWidth The width of the region, or 0 for the width of the target.
+	 * @param regionHeight The height of the region, or 0 for the height of the target.
+	 */
 	void applyConvertToGrayscale(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target,
-				     const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source) const noexcept
+				     const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source,
+				     std::uint32_t sourceX = 0, std::uint32_t sourceY = 0,
+				     std::uint32_t regionWidth = 0, std::uint32_t regionHeight = 0) const noexcept
 	{
 		const MainEffectDetail::RenderTargetGuard renderTargetGuard;
 		const MainEffectDetail::TransformStateGuard transformStateGuard;
 
-		std::uint32_t width = gs_texture_get_width(target.get());
-		std::uint32_t height = gs_texture_get_height(target.get());
+		const std::uint32_t width = gs_texture_get_width(target.get());
+		const std::uint32_t height = gs_texture_get_height(target.get());
+		const std::uint32_t spriteWidth = regionWidth > 0 ? regionWidth : width;
+		const std::uint32_t spriteHeight = regionHeight > 0 ? regionHeight : height;
 
 		gs_set_viewport(0, 0, width, height);
-		gs_ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height), -100.0f, 100.0f);
+		gs_ortho(0.0f, static_cast<float>(spriteWidth), 0.0f, static_cast<float>(spriteHeight), -100.0f,
+			 100.0f);
 		gs_matrix_identity();
 
 		gs_set_render_target_with_color_space(target.get(), nullptr, GS_CS_SRGB);
@@ -225,13 +489,89 @@ public:
 			if (gs_technique_begin_pass(techConvertGrayscale, i)) {
 				gs_effect_set_texture(textureImage, source.get());
 
-				gs_draw_sprite(nullptr, 0, width, height);
+				gs_draw_sprite_subregion(source.get(), 0, sourceX, sourceY, spriteWidth, spriteHeight);
 				gs_technique_end_pass(techConvertGrayscale);
 			}
 		}
 		gs_technique_end(techConvertGrayscale);
 	}
 
+	/**
+	 * @brief Copies the region of a single-channel source that starts at (sourceX, sourceY), scaled to fill the
+	 * target.
+	 * @param regionWidth The width of the region, or 0 for the width of the target.
+	 * @param regionHeight The height of the region, or 0 for the height of the target.
+	 */
+	void applyCropGrayscale(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target,
+				const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source, std::uint32_t sourceX,
+				std::uint32_t sourceY, std::uint32_t regionWidth = 0,
+				std::uint32_t regionHeight = 0) const noexcept
+	{
+		const MainEffectDetail::RenderTargetGuard renderTargetGuard;
+		const MainEffectDetail::TransformStateGuard transformStateGuard;
+
+		const std::uint32_t width = gs_texture_get_width(target.get());
+		const std::uint32_t height = gs_texture_get_height(target.get());
+		const std::uint32_t spriteWidth = regionWidth > 0 ? regionWidth : width;
+		const std::uint32_t spriteHeight = regionHeight > 0 ? regionHeight : height;
+
+		gs_set_viewport(0, 0, width, height);
+		gs_ortho(0.0f, static_cast<float>(spriteWidth), 0.0f, static_cast<float>(spriteHeight), -100.0f,
+			 100.0f);
+		gs_matrix_identity();
+
+		gs_set_render_target_with_color_space(target.get(), nullptr, GS_CS_SRGB);
+		const std::size_t passes = gs_technique_begin(techDrawGrayscale);
+		for (std::size_t i = 0; i < passes; i++) {
+			if (gs_technique_begin_pass(techDrawGrayscale, i)) {
+				gs_effect_set_texture(textureImage, source.get());
+
+				gs_draw_sprite_subregion(source.get(), 0, sourceX, sourceY, spriteWidth, spriteHeight);
+				gs_technique_end_pass(techDrawGrayscale);
+			}
+		}
+		gs_technique_end(techDrawGrayscale);
+	}
+
+	/**
+	 * @brief Converts the quadrilateral of the source given by a homography to a grayscale target.
+	 * @param homography Row-major; maps the uv of the target to the uv of the source.
+	 */
+	void applyWarpConvertToGrayscale(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target,
+					 const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source,
+					 const std::array<float, 9> &homography) const noexcept
+	{
+		const MainEffectDetail::RenderTargetGuard renderTargetGuard;
+		const MainEffectDetail::TransformStateGuard transformStateGuard;
+
+		const std::uint32_t width = gs_texture_get_width(target.get());
+		const std::uint32_t height = gs_texture_get_height(target.get());
+
+		gs_set_viewport(0, 0, width, height);
+		gs_ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height), -100.0f, 100.0f);
+		gs_matrix_identity();
+
+		gs_set_render_target_with_color_space(target.get(), nullptr, GS_CS_SRGB);
+		const std::size_t passes = gs_technique_begin(techWarpConvertGrayscale);
+		for (std::size_t i = 0; i < passes; i++) {
+			if (gs_technique_begin_pass(techWarpConvertGrayscale, i)) {
+				gs_effect_set_texture(textureImage, source.get());
+
+				struct vec3 row;
+				vec3_set(&row, homography[0], homography[1], homography[2]);
+				gs_effect_set_vec3(float3HomographyX, &row);
+				vec3_set(&row, homography[3], homography[4], homography[5]);
+				gs_effect_set_vec3(float3HomographyY, &row);
+				vec3_set(&row, homography[6], homography[7], homography[8]);
+				gs_effect_set_vec3(float3HomographyW, &row);
+
+				gs_draw_sprite(nullptr, 0, width, height);
+				gs_technique_end_pass(techWarpConvertGrayscale);
+			}
+		}
+		gs_technique_end(techWarpConvertGrayscale);
+	}
+
 	void applyMedianFilter(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target,
 			       const KaitoTokyo::BridgeUtils::unique_gs_texture_t &intermediate,
 			       const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source) const noexcept
@@ -241,8 +581,6 @@ public:
 
 		const std::uint32_t width = gs_texture_get_width(target.get());
 		const std::uint32_t height = gs_texture_get_height(target.get());
-		const float texelWidth = 1.0f / static_cast<float>(width);
-		const float texelHeight = 1.0f / static_cast<float>(height);
 
 		gs_set_viewport(0, 0, width, height);
 		gs_ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height), -100.0f, 100.0f);
@@ -255,7 +593,7 @@ public:
 			if (gs_technique_begin_pass(techHorizontalMedian3, i)) {
 				gs_effect_set_texture(textureImage, source.get());
 
-				gs_effect_set_float(floatTexelWidth, texelWidth);
+				setNeighbourhood(width, height);
 
 				gs_draw_sprite(nullptr, 0, width, height);
 				gs_technique_end_pass(techHorizontalMedian3);
@@ -270,7 +608,7 @@ public:
 			if (gs_technique_begin_pass(techVerticalMedian3, i)) {
 				gs_effect_set_texture(textureImage, intermediate.get());
 
-				gs_effect_set_float(floatTexelHeight, texelHeight);
+				setNeighbourhood(width, height);
 
 				gs_draw_sprite(nullptr, 0, width, height);
 				gs_technique_end_pass(techVerticalMedian3);
@@ -291,8 +629,6 @@ public:
 
 		const std::uint32_t width = gs_texture_get_width(target.get());
 		const std::uint32_t height = gs_texture_get_height(target.get());
-		const float texelWidth = 1.0f / static_cast<float>(width);
-		const float texelHeight = 1.0f / static_cast<float>(height);
 
 		gs_set_viewport(0, 0, width, height);
 		gs_ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height), -100.0f, 100.0f);
@@ -307,7 +643,7 @@ public:
 
 				gs_effect_set_texture(textureImage1, previousGrayscale.get());
 
-				gs_effect_set_float(floatTexelWidth, texelWidth);
+				setNeighbourhood(width, height);
 
 				gs_draw_sprite(nullptr, 0, width, height);
 				gs_technique_end_pass(techCalculateHorizontalMotionMap3);
@@ -322,7 +658,7 @@ public:
 			if (gs_technique_begin_pass(techCalculateVerticalMotionMap3, i)) {
 				gs_effect_set_texture(textureImage, intermediate.get());
 
-				gs_effect_set_float(floatTexelHeight, texelHeight);
+				setNeighbourhood(width, height);
 
 				gs_draw_sprite(nullptr, 0, width, height);
 				gs_technique_end_pass(techCalculateVerticalMotionMap3);
@@ -350,16 +686,61 @@ public:
 		gs_technique_end(techMotionAdaptiveFiltering);
 	}
 
+	/**
+	 * @brief Writes the per-pixel median of the frames to the target.
+	 * @param frames Three or five frames of the size of the target. The median does not depend on their order,
+	 * so the slots of a history ring can be passed as they are.
+	 */
+	void applyTemporalMedian(
+		const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target,
+		const std::vector<const KaitoTokyo::BridgeUtils::unique_gs_texture_t *> &frames) const noexcept
+	{
+		if (frames.size() != 3 && frames.size() != 5) {
+			return;
+		}
+
+		const MainEffectDetail::RenderTargetGuard renderTargetGuard;
+		const MainEffectDetail::TransformStateGuard transformStateGuard;
+
+		const std::uint32_t width = gs_texture_get_width(target.get());
+		const std::uint32_t height = gs_texture_get_height(target.get());
+
+		gs_set_viewport(0, 0, width, height);
+		gs_ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height), -100.0f, 100.0f);
+		gs_matrix_identity();
+
+		gs_technique_t *const technique = frames.size() == 5 ? techTemporalMedian5 : techTemporalMedian3;
+		gs_eparam_t *const textures[] = {textureImage, textureImage1, textureImage2, textureImage3,
+						 textureImage4};
+
+		gs_set_render_target_with_color_space(target.get(), nullptr, GS_CS_SRGB);
+		const std::size_t passes = gs_technique_begin(technique);
+		for (std::size_t i = 0; i < passes; i++) {
+			if (gs_technique_begin_pass(technique, i)) {
+				for (std::size_t j = 0; j < frames.size(); j++) {
+					gs_effect_set_texture(textures[j], frames[j]->get());
+				}
+
+				gs_draw_sprite(nullptr, 0, width, height);
+				gs_technique_end_pass(technique);
+			}
+		}
+		gs_technique_end(technique);
+	}
+
+	/**
+	 * @param scissor The region of the target to write, or null for all of it. The rest keeps its contents.
+	 */
 	void applySobel(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target,
-			const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source) const noexcept
+			const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source,
+			const gs_rect *scissor = nullptr) const noexcept
 	{
 		const MainEffectDetail::RenderTargetGuard renderTargetGuard;
 		const MainEffectDetail::TransformStateGuard transformStateGuard;
+		const MainEffectDetail::ScissorGuard scissorGuard(scissor);
 
 		const std::uint32_t width = gs_texture_get_width(target.get());
 		const std::uint32_t height = gs_texture_get_height(target.get());
-		const float texelWidth = 1.0f / static_cast<float>(width);
-		const float texelHeight = 1.0f / static_cast<float>(height);
 
 		gs_set_viewport(0, 0, width, height);
 		gs_ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height), -100.0f, 100.0f);
@@ -371,8 +752,7 @@ public:
 			if (gs_technique_begin_pass(techApplySobel, i)) {
 				gs_effect_set_texture(textureImage, source.get());
 
-				gs_effect_set_float(floatTexelWidth, texelWidth);
-				gs_effect_set_float(floatTexelHeight, texelHeight);
+				setNeighbourhood(width, height);
 
 				gs_draw_sprite(nullptr, 0, width, height);
 				gs_technique_end_pass(techApplySobel);
@@ -381,12 +761,16 @@ public:
 		gs_technique_end(techApplySobel);
 	}
 
+	/**
+	 * @param scissor The region of the target to write, or null for all of it. The rest keeps its contents.
+	 */
 	void applyFinalizeSobelMagnitude(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target,
 					 const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source, bool useLog,
-					 float scalingFactor) const noexcept
+					 float scalingFactor, const gs_rect *scissor = nullptr) const noexcept
 	{
 		const MainEffectDetail::RenderTargetGuard renderTargetGuard;
 		const MainEffectDetail::TransformStateGuard transformStateGuard;
+		const MainEffectDetail::ScissorGuard scissorGuard(scissor);
 
 		const std::uint32_t width = gs_texture_get_width(target.get());
 		const std::uint32_t height = gs_texture_get_height(target.get());
@@ -411,6 +795,80 @@ public:
 		gs_technique_end(techFinalizeSobelMagnitude);
 	}
 
+	/**
+	 * @brief Advances the committed ink by one frame and writes the edges to show.
+	 * @param target Receives the committed ink where the motion exceeds the threshold and the edges elsewhere.
+	 * @param state Receives the new state; RGBA, of the size of the target.
+	 * @param previousState The state written on the previous frame; must not be the same texture as state.
+	 * @param commitFrames The number of frames an edge must stay unchanged and motion-free to be committed.
+	 */
+	void applyCommitInk(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target,
+			    const KaitoTokyo::BridgeUtils::unique_gs_texture_t &state,
+			    const KaitoTokyo::BridgeUtils::unique_gs_texture_t &edges,
+			    const KaitoTokyo::BridgeUtils::unique_gs_texture_t &previousState,
+			    const KaitoTokyo::BridgeUtils::unique_gs_texture_t &motionMap, float motionThreshold,
+			    float commitFrames) const noexcept
+	{
+		const MainEffectDetail::RenderTargetGuard renderTargetGuard;
+		const MainEffectDetail::TransformStateGuard transformStateGuard;
+
+		const std::uint32_t width = gs_texture_get_width(target.get());
+		const std::uint32_t height = gs_texture_get_height(target.get());
+
+		gs_set_viewport(0, 0, width, height);
+		gs_ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height), -100.0f, 100.0f);
+		gs_matrix_identity();
+
+		// State update pass
+		gs_set_render_target_with_color_space(state.get(), nullptr, GS_CS_SRGB);
+		const std::size_t passesUpdate = gs_technique_begin(techUpdateCommittedInk);
+		for (std::size_t i = 0; i < passesUpdate; i++) {
+			if (gs_technique_begin_pass(techUpdateCommittedInk, i)) {
+				gs_effect_set_texture(textureImage, edges.get());
+				gs_effect_set_texture(textureImage1, previousState.get());
+				gs_effect_set_texture(textureMotionMap, motionMap.get());
+
+				gs_effect_set_float(floatMotionThreshold, motionThreshold);
+				gs_effect_set_float(floatCommitFrames, commitFrames);
+
+				gs_draw_sprite(nullptr, 0, width, height);
+				gs_technique_end_pass(techUpdateCommittedInk);
+			}
+		}
+		gs_technique_end(techUpdateCommittedInk);
+
+		// Composition pass
+		gs_set_render_target_with_color_space(target.get(), nullptr, GS_CS_SRGB);
+		const std::size_t passesCompose = gs_technique_begin(techComposeCommittedInk);
+		for (std::size_t i = 0; i < passesCompose; i++) {
+			if (gs_technique_begin_pass(techComposeCommittedInk, i)) {
+				gs_effect_set_texture(textureImage, edges.get());
+				gs_effect_set_texture(textureImage1, state.get());
+				gs_effect_set_texture(textureMotionMap, motionMap.get());
+
+				gs_effect_set_float(floatMotionThreshold, motionThreshold);
+
+				gs_draw_sprite(nullptr, 0, width, height);
+				gs_technique_end_pass(techComposeCommittedInk);
+			}
+		}
+		gs_technique_end(techComposeCommittedInk);
+	}
+
+	/**
+	 * @brief Reduces the r channel of the source to block statistics through a chain of 4x4 reductions.
+	 * @param targets RGBA32F targets, each a quarter of the previous size rounded up; the last holds the result.
+	 */
+	void applyReduceToBlockStats(const std::vector<KaitoTokyo::BridgeUtils::unique_gs_texture_t> &targets,
+				     const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source) const noexcept
+	{
+		const KaitoTokyo::BridgeUtils::unique_gs_texture_t *input = &source;
+		for (const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target : targets) {
+			applyReduce4x4(target, *input, input == &source ? techReduceLuma4x4 : techReduceStats4x4);
+			input = &target;
+		}
+	}
+
 	void applyMorphology(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target,
 			     const KaitoTokyo::BridgeUtils::unique_gs_texture_t &intermediate,
 			     const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source,
@@ -421,8 +879,6 @@ public:
 
 		const std::uint32_t width = gs_texture_get_width(target.get());
 		const std::uint32_t height = gs_texture_get_height(target.get());
-		const float texelWidth = 1.0f / static_cast<float>(width);
-		const float texelHeight = 1.0f / static_cast<float>(height);
 
 		gs_set_viewport(0, 0, width, height);
 		gs_ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height), -100.0f, 100.0f);
@@ -434,7 +890,7 @@ public:
 		for (std::size_t i = 0; i < passesHorizontal; i++) {
 			if (gs_technique_begin_pass(horizontalTechnique, i)) {
 				gs_effect_set_texture(textureImage, source.get());
-				gs_effect_set_float(floatTexelWidth, texelWidth);
+				setNeighbourhood(width, height);
 				gs_draw_sprite(nullptr, 0, width, height);
 				gs_technique_end_pass(horizontalTechnique);
 			}
@@ -448,7 +904,7 @@ public:
 			if (gs_technique_begin_pass(verticalTechnique, i)) {
 				gs_effect_set_texture(textureImage, intermediate.get());
 
-				gs_effect_set_float(floatTexelHeight, texelHeight);
+				setNeighbourhood(width, height);
 
 				gs_draw_sprite(nullptr, 0, width, height);
 				gs_technique_end_pass(verticalTechnique);
@@ -456,6 +912,86 @@ public:
 		}
 		gs_technique_end(verticalTechnique);
 	}
+
+private:
+	void applyReduce4x4(const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target,
+			    const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source,
+			    gs_technique_t *tech) const noexcept
+	{
+		const MainEffectDetail::RenderTargetGuard renderTargetGuard;
+		const MainEffectDetail::TransformStateGuard transformStateGuard;
+
+		const std::uint32_t width = gs_texture_get_width(target.get());
+		const std::uint32_t height = gs_texture_get_height(target.get());
+		const std::uint32_t sourceWidth = gs_texture_get_width(source.get());
+		const std::uint32_t sourceHeight = gs_texture_get_height(source.get());
+
+		// Each target pixel covers exactly 4x4 source texels; blocks past the edge repeat the edge texels.
+		gs_set_viewport(0, 0, width, height);
+		gs_ortho(0.0f, static_cast<float>(width * 4), 0.0f, static_cast<float>(height * 4), -100.0f, 100.0f);
+		gs_matrix_identity();
+
+		gs_set_render_target_with_color_space(target.get(), nullptr, GS_CS_SRGB);
+		const std::size_t passes = gs_technique_begin(tech);
+		for (std::size_t i = 0; i < passes; i++) {
+			if (gs_technique_begin_pass(tech, i)) {
+				gs_effect_set_texture(textureImage, source.get());
+				gs_effect_set_float(floatTexelWidth, 1.0f / static_cast<float>(sourceWidth));
+				gs_effect_set_float(floatTexelHeight, 1.0f / static_cast<float>(sourceHeight));
+
+				gs_draw_sprite_subregion(source.get(), 0, 0, 0, width * 4, height * 4);
+				gs_technique_end_pass(tech);
+			}
+		}
+		gs_technique_end(tech);
+	}
+
+	void drawInk(gs_technique_t *tech, const KaitoTokyo::BridgeUtils::unique_gs_texture_t &source,
+		     const KaitoTokyo::BridgeUtils::unique_gs_texture_t *color,
+		     const std::array<float, 4> &sourceRegion, std::uint32_t inkColor,
+		     const KaitoTokyo::BridgeUtils::unique_gs_texture_t *mask) const noexcept
+	{
+		const std::uint32_t width = gs_texture_get_width(source.get());
+		const std::uint32_t height = gs_texture_get_height(source.get());
+
+		struct vec4 ink;
+		vec4_from_rgba(&ink, inkColor);
+		const struct vec2 offset{sourceRegion[0], sourceRegion[1]};
+		const struct vec2 scale{sourceRegion[2], sourceRegion[3]};
+
+		const std::size_t passes = gs_technique_begin(tech);
+		for (std::size_t i = 0; i < passes; i++) {
+			if (gs_technique_begin_pass(tech, i)) {
+				gs_effect_set_texture(textureImage, source.get());
+				gs_effect_set_texture(textureImage1, color ? color->get() : nullptr);
+				gs_effect_set_texture(textureMask, mask ? mask->get() : nullptr);
+				gs_effect_set_vec4(float4InkColor, &ink);
+				gs_effect_set_vec2(float2SourceOffset, &offset);
+				gs_effect_set_vec2(float2SourceScale, &scale);
+				gs_effect_set_bool(boolUseMask, mask != nullptr);
+
+				gs_draw_sprite(nullptr, 0, width, height);
+				gs_technique_end_pass(tech);
+			}
+		}
+		gs_technique_end(tech);
+	}
+
+	/**
+	 * @brief Sets what the neighbourhood techniques of the fetch mode need to address an input of the given size.
+	 */
+	void setNeighbourhood(std::uint32_t width, std::uint32_t height) const noexcept
+	{
+		if (texelFetchMode != TexelFetchMode::Load) {
+			// Sample and the corner taps of LoadQuadSobel address texels in uv.
+			gs_effect_set_float(floatTexelWidth, 1.0f / static_cast<float>(width));
+			gs_effect_set_float(floatTexelHeight, 1.0f / static_cast<float>(height));
+		}
+		if (texelFetchMode != TexelFetchMode::Sample) {
+			const std::array<int, 2> lastTexel{static_cast<int>(width) - 1, static_cast<int>(height) - 1};
+			gs_effect_set_val(int2LastTexel, lastTexel.data(), sizeof(lastTexel));
+		}
+	}
 };
 
 } // namespace ShowDraw
@@ -18,23 +18,45 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #include "MainPluginContext.h"
 
+#include <algorithm>
+#include <string>
+
 #include <obs.h>
 
 #include "../BridgeUtils/GsUnique.hpp"
 #include "../BridgeUtils/ObsLogger.hpp"
 
+#include "SourceFrameLuma.hpp"
+
 using namespace KaitoTokyo::BridgeUtils;
 
 namespace KaitoTokyo {
 namespace ShowDraw {
 
+namespace {
+
+// A mask source that does not exist is looked up by name again at most this often.
+constexpr std::uint64_t MaskLookupRetryNs = 1000000000;
+
+} // namespace
+
 MainPluginContext::MainPluginContext(const BridgeUtils::ILogger &_logger, obs_data_t *settings, obs_source_t *_source)
 	: logger(_logger),
 	  source{_source},
-	  mainEffect(unique_obs_module_file("effects/main.effect"))
+	  mainEffect(unique_obs_module_file("effects/main.effect")),
+	  canvasTaskQueue(logger, 1),
+	  renderPresetReader(presetStore),
+	  filterPresetReader(presetStore)
 {
-	std::atomic_store(&preset, std::make_shared<const Preset>());
 	update(settings);
+
+	proc_handler_t *ph = obs_source_get_proc_handler(source);
+	proc_handler_add(ph, "void reset_stage_timings()", &MainPluginContext::handleResetStageTimings, this);
+	proc_handler_add(ph, "void get_stage_timings(in ptr timings)", &MainPluginContext::handleGetStageTimings,
+			 this);
+
+	signal_handler_add(obs_source_get_signal_handler(source),
+			   "void drawing_activity_changed(ptr source, bool active)");
 }
 
 MainPluginContext::~MainPluginContext() noexcept
@@ -44,30 +66,54 @@ MainPluginContext::~MainPluginContext() noexcept
 
 void MainPluginContext::shutdown() noexcept
 {
-	renderingContext.reset();
+	canvasTaskQueue.shutdown();
+	renderingContexts.reset();
 	logger.info("Context shut down");
 }
 
 uint32_t MainPluginContext::getWidth() const noexcept
 {
-	return renderingContext ? renderingContext->width : 0;
+	return frameWidth.load();
 }
 
 uint32_t MainPluginContext::getHeight() const noexcept
 {
-	return renderingContext ? renderingContext->height : 0;
+	return frameHeight.load();
 }
 
 void MainPluginContext::getDefaults(obs_data_t *data)
 {
 	Preset p;
 	obs_data_set_default_int(data, "extractionMode", static_cast<int>(p.extractionMode));
+	obs_data_set_default_int(data, "processingBackend", static_cast<int>(p.processingBackend));
 	obs_data_set_default_bool(data, "medianFilterEnabled", p.medianFilterEnabled);
 	obs_data_set_default_double(data, "motionAdaptiveFilteringStrength", p.motionAdaptiveFilteringStrength);
 	obs_data_set_default_double(data, "motionAdaptiveFilteringMotionThreshold",
 				    p.motionAdaptiveFilteringMotionThreshold);
+	obs_data_set_default_int(data, "temporalMedianFrames", p.temporalMedianFrames);
 	obs_data_set_default_bool(data, "sobelUseLog", p.sobelUseLog);
 	obs_data_set_default_double(data, "sobelScalingFactorDb", p.sobelScalingFactor.db);
+	obs_data_set_default_bool(data, "inkCommitEnabled", p.inkCommitEnabled);
+	obs_data_set_default_int(data, "inkCommitFrames", p.inkCommitFrames);
+	obs_data_set_default_bool(data, "autoCalibrationEnabled", p.autoCalibrationEnabled);
+	obs_data_set_default_int(data, "maxProcessingRate", p.maxProcessingRate);
+	obs_data_set_default_int(data, "processingScale", p.processingScale);
+	obs_data_set_default_bool(data, "qualityGovernorEnabled", p.qualityGovernorEnabled);
+	obs_data_set_default_int(data, "qualityGovernorBudget", p.qualityGovernorBudget);
+	obs_data_set_default_bool(data, "staticSceneGatingEnabled", p.staticSceneGatingEnabled);
+	obs_data_set_default_double(data, "staticSceneHoldTime", p.staticSceneHoldTime);
+	obs_data_set_default_bool(data, "roiEnabled", p.roiEnabled);
+	obs_data_set_default_double(data, "roiCropLeft", p.roiCropLeft);
+	obs_data_set_default_double(data, "roiCropTop", p.roiCropTop);
+	obs_data_set_default_double(data, "roiCropRight", p.roiCropRight);
+	obs_data_set_default_double(data, "roiCropBottom", p.roiCropBottom);
+	obs_data_set_default_int(data, "roiOutsideMode", static_cast<int>(p.roiOutsideMode));
+	obs_data_set_default_string(data, "roiMaskSourceName", p.roiMaskSourceName.c_str());
+	obs_data_set_default_int(data, "outputMode", static_cast<int>(p.outputMode));
+	obs_data_set_default_int(data, "inkColor", p.inkColor);
+	obs_data_set_default_bool(data, "canvasRectificationEnabled", p.canvasRectificationEnabled);
+	obs_data_set_default_int(data, "canvasWorkingWidth", p.canvasWorkingWidth);
+	obs_data_set_default_double(data, "canvasDetectionInterval", p.canvasDetectionInterval);
 }
 
 obs_properties_t *MainPluginContext::getProperties()
@@ -90,31 +136,147 @@ obs_properties_t *MainPluginContext::getProperties()
 	obs_property_list_add_int(p, obs_module_text("extractionModeSobelMagnitude"),
 				  static_cast<long long>(ExtractionMode::SobelMagnitude));
 
+	obs_property_t *backend = obs_properties_add_list(props, "processingBackend",
+							  obs_module_text("processingBackend"), OBS_COMBO_TYPE_LIST,
+							  OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(backend, obs_module_text("processingBackendGpu"),
+				  static_cast<long long>(ProcessingBackend::Gpu));
+	obs_property_list_add_int(backend, obs_module_text("processingBackendCpuLuma"),
+				  static_cast<long long>(ProcessingBackend::CpuLuma));
+
 	obs_properties_add_float_slider(props, "motionAdaptiveFilteringStrength",
 					obs_module_text("motionAdaptiveFilteringStrength"), 0.0, 1.0, 0.001);
 	obs_properties_add_float_slider(props, "motionAdaptiveFilteringMotionThreshold",
 					obs_module_text("motionAdaptiveFilteringMotionThreshold"), 0.0, 1.0, 0.001);
 
+	obs_property_t *temporal = obs_properties_add_list(props, "temporalMedianFrames",
+							   obs_module_text("temporalMedianFrames"), OBS_COMBO_TYPE_LIST,
+							   OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(temporal, obs_module_text("temporalMedianFramesOff"), 0);
+	obs_property_list_add_int(temporal, obs_module_text("temporalMedianFrames3"), 3);
+	obs_property_list_add_int(temporal, obs_module_text("temporalMedianFrames5"), 5);
+
 	obs_properties_add_bool(props, "sobelUseLog", obs_module_text("sobelUseLog"));
 	obs_properties_add_float_slider(props, "sobelScalingFactorDb", obs_module_text("sobelScalingFactorDb"), -20.0,
 					20.0, 0.01);
+	obs_properties_add_bool(props, "inkCommitEnabled", obs_module_text("inkCommitEnabled"));
+	obs_properties_add_int_slider(props, "inkCommitFrames", obs_module_text("inkCommitFrames"), 2, 30, 1);
+	obs_properties_add_bool(props, "autoCalibrationEnabled", obs_module_text("autoCalibrationEnabled"));
+
+	obs_property_t *rate = obs_properties_add_list(props, "maxProcessingRate", obs_module_text("maxProcessingRate"),
+						       OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(rate, obs_module_text("maxProcessingRateEveryFrame"), 0);
+	for (int hz : {60, 30, 20, 15, 10, 5}) {
+		obs_property_list_add_int(rate, (std::to_string(hz) + " Hz").c_str(), hz);
+	}
+
+	obs_property_t *scale = obs_properties_add_list(props, "processingScale", obs_module_text("processingScale"),
+							OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	for (int percent : {100, 75, 50, 25}) {
+		obs_property_list_add_int(scale, (std::to_string(percent) + "%").c_str(), percent);
+	}
+
+	obs_properties_add_bool(props, "qualityGovernorEnabled", obs_module_text("qualityGovernorEnabled"));
+	obs_property_t *budget = obs_properties_add_int_slider(props, "qualityGovernorBudget",
+							       obs_module_text("qualityGovernorBudget"), 5, 100, 5);
+	obs_property_int_set_suffix(budget, "%");
+
+	obs_properties_add_bool(props, "staticSceneGatingEnabled", obs_module_text("staticSceneGatingEnabled"));
+	obs_property_t *hold = obs_properties_add_float_slider(props, "staticSceneHoldTime",
+							       obs_module_text("staticSceneHoldTime"), 0.5, 10.0, 0.5);
+	obs_property_float_set_suffix(hold, " s");
+
+	obs_properties_add_bool(props, "roiEnabled", obs_module_text("roiEnabled"));
+	for (const char *name : {"roiCropLeft", "roiCropTop", "roiCropRight", "roiCropBottom"}) {
+		obs_property_t *crop =
+			obs_properties_add_float_slider(props, name, obs_module_text(name), 0.0, 100.0, 0.1);
+		obs_property_float_set_suffix(crop, "%");
+	}
+
+	obs_property_t *outside = obs_properties_add_list(props, "roiOutsideMode", obs_module_text("roiOutsideMode"),
+							  OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(outside, obs_module_text("roiOutsideModePassthrough"),
+				  static_cast<long long>(RoiOutsideMode::Passthrough));
+	obs_property_list_add_int(outside, obs_module_text("roiOutsideModeBlank"),
+				  static_cast<long long>(RoiOutsideMode::Blank));
+
+	obs_property_t *mask = obs_properties_add_list(props, "roiMaskSourceName", obs_module_text("roiMaskSourceName"),
+						       OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(mask, obs_module_text("roiMaskSourceNone"), "");
+	obs_enum_sources(
+		[](void *param, obs_source_t *candidate) {
+			obs_property_list_add_string(static_cast<obs_property_t *>(param),
+						     obs_source_get_name(candidate), obs_source_get_name(candidate));
+			return true;
+		},
+		mask);
+
+	obs_property_t *output = obs_properties_add_list(props, "outputMode", obs_module_text("outputMode"),
+							 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(output, obs_module_text("outputModeGrayscale"),
+				  static_cast<long long>(OutputMode::Grayscale));
+	obs_property_list_add_int(output, obs_module_text("outputModeMultiply"),
+				  static_cast<long long>(OutputMode::Multiply));
+	obs_property_list_add_int(output, obs_module_text("outputModeOverlay"),
+				  static_cast<long long>(OutputMode::Overlay));
+	obs_property_list_add_int(output, obs_module_text("outputModeAlphaMask"),
+				  static_cast<long long>(OutputMode::AlphaMask));
+	obs_properties_add_color(props, "inkColor", obs_module_text("inkColor"));
+
+	obs_properties_add_bool(props, "canvasRectificationEnabled", obs_module_text("canvasRectificationEnabled"));
+	obs_property_t *working = obs_properties_add_list(props, "canvasWorkingWidth",
+							  obs_module_text("canvasWorkingWidth"), OBS_COMBO_TYPE_LIST,
+							  OBS_COMBO_FORMAT_INT);
+	for (int workingWidth : {1920, 1280, 960, 640}) {
+		const std::string label = std::to_string(workingWidth) + "x" + std::to_string(workingWidth * 9 / 16);
+		obs_property_list_add_int(working, label.c_str(), workingWidth);
+	}
+	obs_property_t *interval = obs_properties_add_float_slider(props, "canvasDetectionInterval",
+								   obs_module_text("canvasDetectionInterval"), 0.5,
+								   10.0, 0.5);
+	obs_property_float_set_suffix(interval, " s");
 
 	return props;
 }
 
 void MainPluginContext::update(obs_data_t *data)
 {
-	Preset newPreset = *std::atomic_load(&preset);
+	std::lock_guard<std::mutex> lock(requestedPresetMutex);
+	Preset newPreset = requestedPreset;
 
 	newPreset.extractionMode = static_cast<ExtractionMode>(obs_data_get_int(data, "extractionMode"));
+	newPreset.processingBackend = static_cast<ProcessingBackend>(obs_data_get_int(data, "processingBackend"));
 	newPreset.medianFilterEnabled = obs_data_get_bool(data, "medianFilterEnabled");
 	newPreset.motionAdaptiveFilteringStrength = obs_data_get_double(data, "motionAdaptiveFilteringStrength");
 	newPreset.motionAdaptiveFilteringMotionThreshold =
 		obs_data_get_double(data, "motionAdaptiveFilteringMotionThreshold");
+	newPreset.temporalMedianFrames = static_cast<int>(obs_data_get_int(data, "temporalMedianFrames"));
 	newPreset.sobelUseLog = obs_data_get_bool(data, "sobelUseLog");
 	newPreset.sobelScalingFactor = DecibelField::fromDbAmp(obs_data_get_double(data, "sobelScalingFactorDb"));
-
-	std::atomic_store(&preset, std::make_shared<const Preset>(newPreset));
+	newPreset.inkCommitEnabled = obs_data_get_bool(data, "inkCommitEnabled");
+	newPreset.inkCommitFrames = static_cast<int>(obs_data_get_int(data, "inkCommitFrames"));
+	newPreset.autoCalibrationEnabled = obs_data_get_bool(data, "autoCalibrationEnabled");
+	newPreset.maxProcessingRate = static_cast<int>(obs_data_get_int(data, "maxProcessingRate"));
+	newPreset.processingScale = static_cast<int>(obs_data_get_int(data, "processingScale"));
+	newPreset.qualityGovernorEnabled = obs_data_get_bool(data, "qualityGovernorEnabled");
+	newPreset.qualityGovernorBudget = static_cast<int>(obs_data_get_int(data, "qualityGovernorBudget"));
+	newPreset.staticSceneGatingEnabled = obs_data_get_bool(data, "staticSceneGatingEnabled");
+	newPreset.staticSceneHoldTime = obs_data_get_double(data, "staticSceneHoldTime");
+	newPreset.roiEnabled = obs_data_get_bool(data, "roiEnabled");
+	newPreset.roiCropLeft = obs_data_get_double(data, "roiCropLeft");
+	newPreset.roiCropTop = obs_data_get_double(data, "roiCropTop");
+	newPreset.roiCropRight = obs_data_get_double(data, "roiCropRight");
+	newPreset.roiCropBottom = obs_data_get_double(data, "roiCropBottom");
+	newPreset.roiOutsideMode = static_cast<RoiOutsideMode>(obs_data_get_int(data, "roiOutsideMode"));
+	newPreset.roiMaskSourceName = obs_data_get_string(data, "roiMaskSourceName");
+	newPreset.outputMode = static_cast<OutputMode>(obs_data_get_int(data, "outputMode"));
+	newPreset.inkColor = static_cast<std::uint32_t>(obs_data_get_int(data, "inkColor"));
+	newPreset.canvasRectificationEnabled = obs_data_get_bool(data, "canvasRectificationEnabled");
+	newPreset.canvasWorkingWidth = static_cast<int>(obs_data_get_int(data, "canvasWorkingWidth"));
+	newPreset.canvasDetectionInterval = obs_data_get_double(data, "canvasDetectionInterval");
+
+	requestedPreset = newPreset;
+	presetStore.publish(QualityGovernor::degrade(newPreset, qualityLevel.load(), obs_get_frame_interval_ns()));
 }
 
 void MainPluginContext::activate()
@@ -139,8 +301,137 @@ void MainPluginContext::videoTick(float) {}
 
 void MainPluginContext::videoRender()
 {
-	if (renderingContext) {
-		renderingContext->videoRender(preset);
+	// The context that the filter thread asked for is built here, where the graphics context is already held, so
+	// that thread never waits to enter it. Until then the old context keeps drawing its last output.
+	const auto makeRenderingContext = [this](const RenderingContextSpec &spec) {
+		return std::make_shared<RenderingContext>(source, logger, mainEffect, canvasTaskQueue, spec.width,
+							  spec.height, spec.layout);
+	};
+	if (renderingContexts.rebuild(makeRenderingContext)) {
+		GsUnique::drain();
+	}
+	const std::shared_ptr<RenderingContext> renderingContext = renderingContexts.get();
+
+	if (isCpuLumaFrame.load()) {
+		// The frame already carries the result, so it is drawn without running the GPU pipeline.
+		obs_source_skip_video_filter(source);
+	} else if (renderingContext) {
+		const PresetSnapshot &snapshot = renderPresetReader.get();
+		const unique_obs_source_t maskSource = getMaskSource(snapshot.preset.roiMaskSourceName);
+
+		stageProfiler.beginFrame();
+		renderingContext->videoRender(snapshot, stageProfiler, maskSource.get());
+		stageProfiler.endFrame();
+
+		updateQualityGovernor(snapshot.preset);
+	}
+
+	// video_render runs inside the graphics context, so this is where released GPU resources are reclaimed.
+	GsUnique::drainSome();
+}
+
+unique_obs_source_t MainPluginContext::getMaskSource(const std::string &name)
+{
+	if (name.empty()) {
+		maskSourceName.clear();
+		maskWeakSource.reset();
+		return nullptr;
+	}
+
+	const bool isNewName = name != maskSourceName;
+	unique_obs_source_t mask;
+	if (!isNewName && maskWeakSource) {
+		mask.reset(obs_weak_source_get_source(maskWeakSource.get()));
+	}
+	// A lookup by name takes the lock of the global source list, so it runs only when the setting changes or the
+	// source went away, and then only once per MaskLookupRetryNs while no source has the name.
+	const std::uint64_t now = obs_get_video_frame_time();
+	if (!mask && (isNewName || now >= nextMaskLookupNs)) {
+		mask.reset(obs_get_source_by_name(name.c_str()));
+		maskSourceName = name;
+		maskWeakSource.reset(mask ? obs_source_get_weak_source(mask.get()) : nullptr);
+		nextMaskLookupNs = mask ? 0 : now + MaskLookupRetryNs;
+	}
+
+	// Rendering the filtered source as its own mask would recurse.
+	if (mask && mask.get() == obs_filter_get_parent(source)) {
+		return nullptr;
+	}
+	return mask;
+}
+
+void MainPluginContext::updateDrawingActivity(const obs_source_frame *frame, const Preset &preset)
+{
+	// Frames without a readable luma plane are never gated.
+	const std::optional<LumaPlaneView> luma = getSourceFrameLuma(frame);
+	const std::optional<bool> changed =
+		preset.staticSceneGatingEnabled && luma
+			? activityGate.update(*luma, frame->timestamp, preset.staticSceneHoldTime)
+			: activityGate.reset();
+	if (!changed) {
+		return;
+	}
+
+	logger.info("Drawing became {}", *changed ? "active" : "static");
+
+	calldata_t cd;
+	calldata_init(&cd);
+	calldata_set_ptr(&cd, "source", source);
+	calldata_set_bool(&cd, "active", *changed);
+	signal_handler_signal(obs_source_get_signal_handler(source), "drawing_activity_changed", &cd);
+	calldata_free(&cd);
+}
+
+void MainPluginContext::updateQualityGovernor(const Preset &preset)
+{
+	if (!preset.qualityGovernorEnabled) {
+		const QualityLevel previous = qualityGovernor.reset();
+		if (previous != QualityLevel::Full) {
+			logger.info("Quality raised from {} to Full: the governor was disabled",
+				    getQualityLevelName(previous));
+			publishQualityLevel(QualityLevel::Full);
+		}
+		return;
+	}
+
+	// Only a new measurement of the pipeline can move the quality.
+	if (stageProfiler.getPipelineSampleCount() == governedSampleCount) {
+		return;
+	}
+	governedSampleCount = stageProfiler.getPipelineSampleCount();
+
+	const auto budgetPercent = static_cast<std::uint64_t>(std::clamp(preset.qualityGovernorBudget, 1, 100));
+	const std::uint64_t budgetNs = obs_get_frame_interval_ns() * budgetPercent / 100;
+	const std::optional<QualityTransition> transition =
+		qualityGovernor.update(stageProfiler.getLastPipelineNs(), budgetNs);
+	if (!transition) {
+		return;
+	}
+
+	logger.info("Quality {} from {} to {}: the pipeline took {:.2f} ms of a {:.2f} ms budget",
+		    transition->to > transition->from ? "lowered" : "raised", getQualityLevelName(transition->from),
+		    getQualityLevelName(transition->to), static_cast<double>(transition->pipelineNs) / 1e6,
+		    static_cast<double>(transition->budgetNs) / 1e6);
+	publishQualityLevel(transition->to);
+}
+
+void MainPluginContext::publishQualityLevel(QualityLevel level)
+{
+	std::lock_guard<std::mutex> lock(requestedPresetMutex);
+	qualityLevel.store(level);
+	presetStore.publish(QualityGovernor::degrade(requestedPreset, level, obs_get_frame_interval_ns()));
+}
+
+void MainPluginContext::handleResetStageTimings(void *data, calldata_t *)
+{
+	static_cast<MainPluginContext *>(data)->stageProfiler.reset();
+}
+
+void MainPluginContext::handleGetStageTimings(void *data, calldata_t *cd)
+{
+	auto timings = static_cast<StageTimings *>(calldata_ptr(cd, "timings"));
+	if (timings) {
+		*timings = static_cast<MainPluginContext *>(data)->stageProfiler.getTimings();
 	}
 }
 
@@ -151,20 +442,32 @@ try {
 		return nullptr;
 	}
 
+	frameWidth.store(frame->width);
+	frameHeight.store(frame->height);
 	if (frame->width == 0 || frame->height == 0) {
-		renderingContext.reset();
+		renderingContexts.acquire(std::nullopt);
 		return frame;
 	}
 
-	if (!renderingContext || frame->width != renderingContext->width || frame->height != renderingContext->height) {
-		GraphicsContextGuard guard;
-		renderingContext =
-			std::make_shared<RenderingContext>(source, logger, mainEffect, frame->width, frame->height);
-		GsUnique::drain();
+	const PresetSnapshot &snapshot = filterPresetReader.get();
+	updateDrawingActivity(frame, snapshot.preset);
+
+	const bool isCpuLuma = snapshot.preset.processingBackend == ProcessingBackend::CpuLuma &&
+			       cpuLumaBackend.filterVideo(frame, snapshot, activityGate.isActive());
+	isCpuLumaFrame.store(isCpuLuma);
+	if (isCpuLuma) {
+		// The CPU backend needs no graphics resources, so no rendering context is built or kept for it.
+		renderingContexts.acquire(std::nullopt);
+		return frame;
 	}
 
+	const RenderingLayout layout = RenderingLayout::fromPreset(snapshot.preset, frame->width, frame->height,
+								   getYuvFormat(frame->format).has_value());
+	// Null until video_render has built the context for this frame, which passes through unprocessed meanwhile.
+	const std::shared_ptr<RenderingContext> renderingContext =
+		renderingContexts.acquire(RenderingContextSpec{frame->width, frame->height, layout});
 	if (renderingContext) {
-		return renderingContext->filterVideo(frame);
+		return renderingContext->filterVideo(frame, snapshot, activityGate.isActive());
 	} else {
 		return frame;
 	}
@@ -34,12 +34,20 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
 
 #include "../BridgeUtils/ILogger.hpp"
+#include "../BridgeUtils/ObsUnique.hpp"
 #include "../BridgeUtils/ThrottledTaskQueue.hpp"
 
+#include "ActivityGate.hpp"
+#include "ContextRebuilder.hpp"
+#include "CpuLumaBackend.hpp"
 #include "Preset.hpp"
+#include "PresetStore.hpp"
+#include "QualityGovernor.hpp"
 #include "RenderingContext.hpp"
+#include "StageProfiler.hpp"
 #include "MainEffect.hpp"
 
 namespace KaitoTokyo {
@@ -56,8 +64,49 @@ public:
 	obs_source_t *const source;
 	const MainEffect mainEffect;
 
-	std::shared_ptr<const Preset> preset;
-	std::shared_ptr<RenderingContext> renderingContext = nullptr;
+	PresetStore presetStore;
+	StageProfiler stageProfiler;
+	// Runs canvas detection off the render thread; only the latest request matters.
+	KaitoTokyo::BridgeUtils::ThrottledTaskQueue canvasTaskQueue;
+	// Requested by the filter thread when the frame needs another context, and built on the render thread.
+	ContextRebuilder<RenderingContext, RenderingContextSpec> renderingContexts;
+
+private:
+	PresetReader renderPresetReader;
+	PresetReader filterPresetReader;
+
+	// Filter thread only.
+	ActivityGate activityGate;
+	CpuLumaBackend cpuLumaBackend;
+	// Whether the latest frame was processed by the CPU backend and only needs to be drawn as is.
+	std::atomic<bool> isCpuLumaFrame = false;
+	// The size of the latest frame, which is the size of the filter whether or not a rendering context exists.
+	std::atomic<std::uint32_t> frameWidth = 0;
+	std::atomic<std::uint32_t> frameHeight = 0;
+
+	// The preset as configured, from which the published one is degraded to the quality level.
+	std::mutex requestedPresetMutex;
+	Preset requestedPreset;
+	std::atomic<QualityLevel> qualityLevel = QualityLevel::Full;
+
+	// Render thread only.
+	std::string maskSourceName;
+	KaitoTokyo::BridgeUtils::unique_obs_weak_source_t maskWeakSource;
+	// When a mask source that was not found may be looked up again.
+	std::uint64_t nextMaskLookupNs = 0;
+	QualityGovernor qualityGovernor;
+	std::uint64_t governedSampleCount = 0;
+
+	KaitoTokyo::BridgeUtils::unique_obs_source_t getMaskSource(const std::string &name);
+
+	void updateDrawingActivity(const obs_source_frame *frame, const Preset &preset);
+	void updateQualityGovernor(const Preset &preset);
+	void publishQualityLevel(QualityLevel level);
+
+	static void handleResetStageTimings(void *data, calldata_t *cd);
+	static void handleGetStageTimings(void *data, calldata_t *cd);
+
+public:
 
 	MainPluginContext(const BridgeUtils::ILogger &_logger, obs_data_t *settings, obs_source_t *source);
 	~MainPluginContext() noexcept;
@@ -30,12 +30,17 @@ using namespace KaitoTokyo::BridgeUtils;
 
 namespace {
 
-inline const ILogger &logger()
+ObsLogger &getObsLogger()
 {
-	static const ObsLogger instance("[" PLUGIN_NAME "] ");
+	static ObsLogger instance("[" PLUGIN_NAME "] ");
 	return instance;
 }
 
+inline const ILogger &logger()
+{
+	return getObsLogger();
+}
+
 } // namespace
 
 const char *main_plugin_context_get_name(void *)
@@ -198,8 +203,13 @@ bool main_plugin_context_module_load()
 
 void main_plugin_context_module_unload()
 try {
-	GraphicsContextGuard guard;
-	GsUnique::drain();
+	{
+		GraphicsContextGuard guard;
+		GsUnique::drain();
+	}
+	// The logger's thread runs code of this module, so it is joined here rather than by the destructor of its
+	// static, which runs as the module is unloaded: under the loader lock on Windows, where joining can deadlock.
+	getObsLogger().stop();
 } catch (const std::exception &e) {
 	logger().logException(e, "Failed to unload main plugin context");
 } catch (...) {
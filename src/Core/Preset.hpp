@@ -18,6 +18,11 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
 namespace KaitoTokyo {
 namespace ShowDraw {
 
@@ -29,6 +34,42 @@ enum class ExtractionMode {
 	SobelMagnitude = 400,
 };
 
+enum class ProcessingBackend {
+	Gpu = 100,
+	CpuLuma = 200,
+};
+
+enum class RoiOutsideMode {
+	Passthrough = 100,
+	Blank = 200,
+};
+
+enum class OutputMode {
+	Grayscale = 100,
+	// The ink multiplied onto the color source.
+	Multiply = 200,
+	// The ink drawn over the color source.
+	Overlay = 300,
+	// The ink alone, with the extracted image as its alpha.
+	AlphaMask = 400,
+};
+
+/**
+ * @brief A rectangle in pixels of the frame.
+ */
+struct RoiRect {
+	std::uint32_t x;
+	std::uint32_t y;
+	std::uint32_t width;
+	std::uint32_t height;
+
+	bool operator==(const RoiRect &other) const noexcept
+	{
+		return x == other.x && y == other.y && width == other.width && height == other.height;
+	}
+	bool operator!=(const RoiRect &other) const noexcept { return !(*this == other); }
+};
+
 struct DecibelField {
 	double db;
 	double linear;
@@ -44,14 +85,130 @@ private:
 struct Preset {
 public:
 	ExtractionMode extractionMode = ExtractionMode::Default;
+	// CpuLuma processes the Y plane of YUV camera frames in place; other formats stay on the GPU.
+	ProcessingBackend processingBackend = ProcessingBackend::Gpu;
 
 	bool medianFilterEnabled = true;
 
 	double motionAdaptiveFilteringStrength = 0.5;
 	double motionAdaptiveFilteringMotionThreshold = 0.3;
 
+	// The number of frames, 3 or 5, whose per-pixel median replaces the current frame; 0 disables the stage.
+	int temporalMedianFrames = 0;
+	// Lowered by the quality governor, never set by the user: the median runs over at most this many of the latest
+	// frames, 3 or 5, or not at all at 0. All temporalMedianFrames frames are still kept.
+	int temporalMedianFramesLimit = 5;
+
 	bool sobelUseLog = true;
 	DecibelField sobelScalingFactor = DecibelField::fromDbPow(10.0);
+
+	// Keeps edges that stay unchanged and motion-free for this many frames as committed ink, shows it where
+	// the hand moves over the page, and stops recomputing edges in tiles that have settled. Needs the motion map
+	// of motion adaptive filtering.
+	bool inkCommitEnabled = false;
+	int inkCommitFrames = 5;
+
+	// Replaces the Sobel scaling factor and the motion threshold with values measured from the image.
+	bool autoCalibrationEnabled = false;
+
+	// The highest rate in Hz at which new frames run the pipeline; 0 processes every frame.
+	int maxProcessingRate = 0;
+
+	// The size, in percent of the ROI or of the rectified canvas, at which the stages after the source copy run.
+	int processingScale = 100;
+
+	// Steps the quality down when the pipeline takes more GPU time per processed frame than this percentage of
+	// the frame interval, and back up once there is headroom again.
+	bool qualityGovernorEnabled = false;
+	int qualityGovernorBudget = 25;
+
+	// Stops processing while the drawing is unchanged and keeps showing the last output.
+	bool staticSceneGatingEnabled = false;
+	// Seconds the pipeline keeps running after the last change, so that the temporal filters settle.
+	double staticSceneHoldTime = 2.0;
+
+	// The region of interest, as percentages of the frame cropped from each edge.
+	bool roiEnabled = false;
+	double roiCropLeft = 0.0;
+	double roiCropTop = 0.0;
+	double roiCropRight = 0.0;
+	double roiCropBottom = 0.0;
+	RoiOutsideMode roiOutsideMode = RoiOutsideMode::Passthrough;
+	// The name of a source whose luminance times alpha limits the output inside the ROI; empty for none.
+	std::string roiMaskSourceName;
+
+	// How the extracted image is drawn. The composited modes draw the ink where it is bright in a single pass,
+	// without another copy of the source.
+	OutputMode outputMode = OutputMode::Grayscale;
+	// The color of the ink, as 0xAABBGGRR like OBS color properties.
+	std::uint32_t inkColor = 0xFF000000;
+
+	// Warps the detected sheet of paper to a straight-on 16:9 texture of this width ahead of the other stages.
+	bool canvasRectificationEnabled = false;
+	int canvasWorkingWidth = 960;
+	// Seconds between canvas detections.
+	double canvasDetectionInterval = 2.0;
+
+	/**
+	 * @brief Gets the region of interest in a frame of the given size. The whole frame if the ROI is disabled.
+	 *
+	 * The crop on each axis is capped so that at least one pixel remains.
+	 */
+	RoiRect getRoiRect(std::uint32_t frameWidth, std::uint32_t frameHeight) const noexcept
+	{
+		if (!roiEnabled) {
+			return {0, 0, frameWidth, frameHeight};
+		}
+
+		const auto cropPixels = [](double percent, std::uint32_t size) {
+			return static_cast<std::uint32_t>(std::lround(std::clamp(percent, 0.0, 100.0) / 100.0 * size));
+		};
+		const auto fitAxis = [&](double startPercent, double endPercent, std::uint32_t size,
+					 std::uint32_t &start, std::uint32_t &length) {
+			start = std::min(cropPixels(startPercent, size), size > 0 ? size - 1 : 0);
+			const std::uint32_t endCrop = std::min(cropPixels(endPercent, size), size);
+			const std::uint32_t end = std::max(size - endCrop, start + 1);
+			length = std::min(end, size) - start;
+		};
+
+		RoiRect rect;
+		fitAxis(roiCropLeft, roiCropRight, frameWidth, rect.x, rect.width);
+		fitAxis(roiCropTop, roiCropBottom, frameHeight, rect.y, rect.height);
+		return rect;
+	}
+};
+
+/**
+ * @brief The uniform values derived from a Preset, computed once when the preset is published.
+ */
+struct PresetConstants {
+	float motionAdaptiveFilteringStrength;
+	float motionAdaptiveFilteringMotionThreshold;
+	bool sobelUseLog;
+	float sobelScalingFactor;
+
+	static PresetConstants fromPreset(const Preset &p) noexcept
+	{
+		return {static_cast<float>(p.motionAdaptiveFilteringStrength),
+			static_cast<float>(p.motionAdaptiveFilteringMotionThreshold), p.sobelUseLog,
+			static_cast<float>(p.sobelScalingFactor.linear)};
+	}
+};
+
+/**
+ * @brief An immutable Preset tagged with the epoch in which it was published.
+ */
+struct PresetSnapshot {
+	const Preset preset;
+	const std::uint64_t epoch;
+	const PresetConstants constants;
+
+	PresetSnapshot(const Preset &_preset, std::uint64_t _epoch)
+		: preset(_preset),
+		  epoch(_epoch),
+		  constants(PresetConstants::fromPreset(_preset))
+	{
+	}
 };
 
 } // namespace ShowDraw
@@ -0,0 +1,96 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "Preset.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @class PresetStore
+ * @brief Publishes PresetSnapshots from the settings thread to the render thread.
+ *
+ * Writers are serialized and bump a published epoch after swapping the snapshot in.
+ * Readers compare that epoch with the snapshot they already hold, so an unchanged preset
+ * costs a single atomic load per frame and no reference-count traffic.
+ */
+class PresetStore {
+public:
+	PresetStore() : current(std::make_shared<const PresetSnapshot>(Preset{}, 1)) {}
+
+	PresetStore(const PresetStore &) = delete;
+	PresetStore &operator=(const PresetStore &) = delete;
+	PresetStore(PresetStore &&) = delete;
+	PresetStore &operator=(PresetStore &&) = delete;
+
+	/**
+	 * @brief Gets the most recently published snapshot.
+	 */
+	std::shared_ptr<const PresetSnapshot> load() const { return std::atomic_load(&current); }
+
+	/**
+	 * @brief Publishes a new snapshot of the preset with the next epoch.
+	 */
+	void publish(const Preset &preset)
+	{
+		std::lock_guard<std::mutex> lock(writerMutex);
+		const std::uint64_t epoch = publishedEpoch.load(std::memory_order_relaxed) + 1;
+		std::atomic_store(&current, std::make_shared<const PresetSnapshot>(preset, epoch));
+		publishedEpoch.store(epoch, std::memory_order_release);
+	}
+
+	std::uint64_t getPublishedEpoch() const noexcept { return publishedEpoch.load(std::memory_order_acquire); }
+
+private:
+	std::shared_ptr<const PresetSnapshot> current;
+	std::atomic<std::uint64_t> publishedEpoch{1};
+	std::mutex writerMutex;
+};
+
+/**
+ * @class PresetReader
+ * @brief A single-threaded cache of the latest snapshot in a PresetStore.
+ *
+ * Owned by the reading thread. The snapshot is reloaded only when the store's epoch moves.
+ */
+class PresetReader {
+public:
+	explicit PresetReader(const PresetStore &_store) : store(_store), cached(_store.load()) {}
+
+	const PresetSnapshot &get()
+	{
+		if (store.getPublishedEpoch() != cached->epoch) {
+			cached = store.load();
+		}
+		return *cached;
+	}
+
+private:
+	const PresetStore &store;
+	std::shared_ptr<const PresetSnapshot> cached;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
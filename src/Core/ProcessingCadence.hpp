@@ -0,0 +1,84 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @class ProcessingCadence
+ * @brief Decides which incoming frames run the pipeline when the processing rate is capped.
+ *
+ * Owned by the thread that calls filter_video. A frame is processed once at least one processing interval has
+ * elapsed since the last processed frame, with an eighth of an interval of slack so that timestamp jitter
+ * does not turn a 60 fps camera capped at 30 Hz into an uneven 2-1-3 pattern.
+ */
+class ProcessingCadence {
+public:
+	/**
+	 * @brief Registers a new source frame.
+	 * @param maxProcessingRate The cap in Hz, or 0 to process every frame.
+	 * @return The number of source frames the processed frame stands for, or 0 if the frame is skipped.
+	 */
+	std::uint32_t onNewFrame(std::uint64_t timestamp, int maxProcessingRate) noexcept
+	{
+		framesSinceLastProcessed++;
+
+		if (maxProcessingRate > 0 && hasProcessedFrame && timestamp >= lastProcessedTimestamp) {
+			const std::uint64_t intervalNs = 1000000000ULL / static_cast<std::uint64_t>(maxProcessingRate);
+			if (timestamp - lastProcessedTimestamp + intervalNs / 8 < intervalNs) {
+				return 0;
+			}
+		}
+
+		const std::uint32_t steps = framesSinceLastProcessed;
+		hasProcessedFrame = true;
+		lastProcessedTimestamp = timestamp;
+		framesSinceLastProcessed = 0;
+		return steps;
+	}
+
+	/**
+	 * @brief Gets the motion-adaptive strength that spans `steps` source frames in one blend.
+	 *
+	 * Blending with weight s once per frame keeps (1 - s)^k of the history after k frames,
+	 * so one blend over k frames needs the weight 1 - (1 - s)^k to converge at the same speed.
+	 */
+	static float scaleTemporalStrength(float strength, std::uint32_t steps) noexcept
+	{
+		if (steps <= 1 || strength <= 0.0f) {
+			return strength;
+		}
+		if (strength >= 1.0f) {
+			return 1.0f;
+		}
+		return 1.0f - std::pow(1.0f - strength, static_cast<float>(steps));
+	}
+
+private:
+	std::uint64_t lastProcessedTimestamp = 0;
+	std::uint32_t framesSinceLastProcessed = 0;
+	bool hasProcessedFrame = false;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
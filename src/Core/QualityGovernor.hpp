@@ -0,0 +1,165 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+#include "Preset.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @brief The rungs of the quality ladder, from the preset as configured down. Each rung keeps those above it.
+ *
+ * No rung changes the RenderingLayout, since rebuilding the context while the GPU is over budget would cost more
+ * than the rung saves and would drop the histories of the temporal stages. This is why the processing scale, the
+ * size of every texture, is not a rung.
+ */
+enum class QualityLevel : int {
+	Full,
+	SmallerMedian,
+	NoMotionAdaptiveFiltering,
+	ReducedRate,
+};
+
+inline const char *getQualityLevelName(QualityLevel level) noexcept
+{
+	switch (level) {
+	case QualityLevel::Full:
+		return "Full";
+	case QualityLevel::SmallerMedian:
+		return "SmallerMedian";
+	case QualityLevel::NoMotionAdaptiveFiltering:
+		return "NoMotionAdaptiveFiltering";
+	case QualityLevel::ReducedRate:
+		return "ReducedRate";
+	}
+	return "Unknown";
+}
+
+/**
+ * @brief A step of the governor, with the measurement that caused it.
+ */
+struct QualityTransition {
+	QualityLevel from;
+	QualityLevel to;
+	std::uint64_t pipelineNs;
+	std::uint64_t budgetNs;
+};
+
+/**
+ * @class QualityGovernor
+ * @brief Walks the quality ladder to keep the GPU time of the pipeline within a budget per processed frame.
+ *
+ * Fed one measurement of the pipeline at a time. The quality steps down after OverBudgetSamples measurements in a
+ * row over the budget, and back up only after HeadroomSamples in a row under HeadroomRatio of it. The gap between
+ * the two thresholds and the longer wait upward keep a load near the budget from flapping between rungs.
+ */
+class QualityGovernor {
+public:
+	static constexpr std::uint32_t OverBudgetSamples = 2;
+	static constexpr std::uint32_t HeadroomSamples = 10;
+	static constexpr double HeadroomRatio = 0.6;
+
+	/**
+	 * @param pipelineNs The GPU time of a frame that ran the pipeline.
+	 * @param budgetNs The GPU time that a frame may take.
+	 * @return The transition, if the measurement moved the quality to another rung.
+	 */
+	std::optional<QualityTransition> update(std::uint64_t pipelineNs, std::uint64_t budgetNs) noexcept
+	{
+		if (pipelineNs > budgetNs) {
+			headroomCount = 0;
+			if (++overBudgetCount >= OverBudgetSamples && level != QualityLevel::ReducedRate) {
+				return step(1, pipelineNs, budgetNs);
+			}
+		} else if (static_cast<double>(pipelineNs) < static_cast<double>(budgetNs) * HeadroomRatio) {
+			overBudgetCount = 0;
+			if (++headroomCount >= HeadroomSamples && level != QualityLevel::Full) {
+				return step(-1, pipelineNs, budgetNs);
+			}
+		} else {
+			overBudgetCount = 0;
+			headroomCount = 0;
+		}
+		return std::nullopt;
+	}
+
+	/**
+	 * @brief Returns to full quality.
+	 * @return The previous rung.
+	 */
+	QualityLevel reset() noexcept
+	{
+		const QualityLevel previous = level;
+		level = QualityLevel::Full;
+		overBudgetCount = 0;
+		headroomCount = 0;
+		return previous;
+	}
+
+	QualityLevel getLevel() const noexcept { return level; }
+
+	/**
+	 * @brief Applies the rungs down to the level to a preset.
+	 * @param frameIntervalNs The interval of the output frames, from which ReducedRate halves the rate.
+	 */
+	static Preset degrade(const Preset &preset, QualityLevel level, std::uint64_t frameIntervalNs) noexcept
+	{
+		Preset degraded = preset;
+		if (level >= QualityLevel::SmallerMedian) {
+			degraded.temporalMedianFramesLimit = preset.temporalMedianFrames >= 5 ? 3 : 0;
+			degraded.medianFilterEnabled = false;
+		}
+		if (level >= QualityLevel::NoMotionAdaptiveFiltering) {
+			degraded.motionAdaptiveFilteringStrength = 0.0;
+		}
+		if (level >= QualityLevel::ReducedRate && frameIntervalNs > 0) {
+			const int outputRate = static_cast<int>((1000000000 + frameIntervalNs / 2) / frameIntervalNs);
+			const int rate = preset.maxProcessingRate > 0 ? std::min(preset.maxProcessingRate, outputRate)
+								      : outputRate;
+			degraded.maxProcessingRate = std::max(rate / 2, 1);
+		}
+		return degraded;
+	}
+
+private:
+	/**
+	 * @param direction 1 to step down the ladder, -1 to step up.
+	 */
+	QualityTransition step(int direction, std::uint64_t pipelineNs, std::uint64_t budgetNs) noexcept
+	{
+		const QualityLevel to = static_cast<QualityLevel>(static_cast<int>(level) + direction);
+		const QualityTransition transition{level, to, pipelineNs, budgetNs};
+		level = to;
+		overBudgetCount = 0;
+		headroomCount = 0;
+		return transition;
+	}
+
+	QualityLevel level = QualityLevel::Full;
+	std::uint32_t overBudgetCount = 0;
+	std::uint32_t headroomCount = 0;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
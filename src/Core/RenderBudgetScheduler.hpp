@@ -0,0 +1,117 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @class RenderBudgetScheduler
+ * @brief Spreads the deferrable stages of every filter across render ticks under a GPU budget per tick.
+ *
+ * When several filters get a new frame on the same tick, their pipelines all run in one video_render cycle. The
+ * stages whose results can wait a frame, such as the statistics read back for calibration, are asked for here
+ * first. One stage opens each tick whatever its cost, and the others run while the measured cost of the tick stays
+ * within the budget; a stage of unknown cost counts as the whole budget. Only a stage that has waited as long as
+ * any deferred on the previous tick may open a tick, so the filters take turns rather than the one that renders
+ * first always winning. A stage that has waited maxDeferrals times runs regardless, which bounds the latency that
+ * each filter sees.
+ */
+class RenderBudgetScheduler {
+public:
+	RenderBudgetScheduler(std::uint64_t _tickBudgetNs, std::uint32_t _maxDeferrals) noexcept
+		: tickBudgetNs(_tickBudgetNs),
+		  maxDeferrals(_maxDeferrals)
+	{
+	}
+
+	/**
+	 * @param tick Identifies the render tick, such as the video frame time, which every filter shares.
+	 * @param costNs The recent GPU time of the stage, or nullopt if it has not been measured.
+	 * @param deferrals How many times in a row the stage has been deferred.
+	 * @return Whether the stage may run on this tick, in which case its cost is charged to the tick.
+	 */
+	bool tryRun(std::uint64_t tick, std::optional<std::uint64_t> costNs, std::uint32_t deferrals)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (tick != currentTick) {
+			currentTick = tick;
+			spentNs = 0;
+			hasRun = false;
+			previousLongestWait = longestWait;
+			longestWait = 0;
+		}
+
+		const std::uint64_t cost = costNs.value_or(tickBudgetNs);
+		const bool fits = hasRun ? spentNs <= tickBudgetNs && cost <= tickBudgetNs - spentNs
+					 : deferrals >= previousLongestWait;
+		if (!fits && deferrals < maxDeferrals) {
+			longestWait = std::max(longestWait, deferrals + 1);
+			return false;
+		}
+		spentNs += cost;
+		hasRun = true;
+		return true;
+	}
+
+private:
+	const std::uint64_t tickBudgetNs;
+	const std::uint32_t maxDeferrals;
+
+	std::mutex mutex;
+	std::uint64_t currentTick = 0;
+	std::uint64_t spentNs = 0;
+	bool hasRun = false;
+	// The longest wait, counting the deferral, of the stages deferred on this tick and on the previous one.
+	std::uint32_t longestWait = 0;
+	std::uint32_t previousLongestWait = 0;
+};
+
+/**
+ * @class DeferrableStage
+ * @brief Counts how long one filter's stage has been waiting for the render budget.
+ */
+class DeferrableStage {
+public:
+	/**
+	 * @return Whether the stage runs now. Otherwise it should be asked for again on the next frame.
+	 */
+	bool tryRun(RenderBudgetScheduler &scheduler, std::uint64_t tick, std::optional<std::uint64_t> costNs)
+	{
+		if (scheduler.tryRun(tick, costNs, deferrals)) {
+			deferrals = 0;
+			return true;
+		}
+		deferrals++;
+		return false;
+	}
+
+	std::uint32_t getDeferrals() const noexcept { return deferrals; }
+
+private:
+	std::uint32_t deferrals = 0;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
@@ -18,32 +18,184 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #include "RenderingContext.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <vector>
+
 #include <obs.h>
+#include <util/platform.h>
 
 #include "../BridgeUtils/GsUnique.hpp"
 #include "../BridgeUtils/ILogger.hpp"
 
+#include "SourceFrameLuma.hpp"
+
 using namespace KaitoTokyo::BridgeUtils;
 
 namespace KaitoTokyo {
 namespace ShowDraw {
 
+namespace {
+
+// Once a tick has run one deferrable stage, the others of every filter may add this much GPU time to it.
+constexpr std::uint64_t DeferrableTickBudgetNs = 1000000;
+// A deferrable stage waits at most this many processed frames for the budget.
+constexpr std::uint32_t MaxStageDeferrals = 3;
+
+/**
+ * @brief The budget that staggers the deferrable stages of every filter of the process across render ticks.
+ */
+RenderBudgetScheduler &getRenderBudgetScheduler()
+{
+	static RenderBudgetScheduler scheduler(DeferrableTickBudgetNs, MaxStageDeferrals);
+	return scheduler;
+}
+
+// Detection runs on a copy this wide, which is plenty to find a sheet that covers a tenth of the view.
+constexpr std::uint32_t CanvasDetectionWidth = 160;
+
+unique_gs_texture_t makeProcessingTexture(const RenderingLayout &layout, gs_color_format format)
+{
+	return make_unique_gs_texture(layout.processingWidth, layout.processingHeight, format, 1, nullptr,
+				      GS_RENDER_TARGET);
+}
+
+std::vector<unique_gs_texture_t> makeTemporalHistory(const RenderingLayout &layout)
+{
+	std::vector<unique_gs_texture_t> history;
+	for (std::uint32_t i = 0; i < layout.temporalMedianFrames; i++) {
+		history.push_back(makeProcessingTexture(layout, GS_R8));
+	}
+	return history;
+}
+
+/**
+ * @brief Gets how many of the latest frames of a history of the given length the temporal median runs over.
+ */
+std::size_t getTemporalMedianFrames(const Preset &preset, std::size_t historyLength) noexcept
+{
+	if (preset.temporalMedianFramesLimit >= 5) {
+		return historyLength;
+	} else if (preset.temporalMedianFramesLimit >= 3) {
+		return std::min<std::size_t>(historyLength, 3);
+	} else {
+		return 0;
+	}
+}
+
+std::uint32_t getCanvasDetectionHeight(const RoiRect &roi) noexcept
+{
+	return std::max<std::uint32_t>(4, CanvasDetectionWidth * roi.height / roi.width);
+}
+
+/**
+ * @brief Expands limited-range luma, 16 to 235, to the full range that the BGRX copy of the source would have.
+ */
+std::array<std::uint8_t, 256> makeLimitedToFullRangeTable() noexcept
+{
+	std::array<std::uint8_t, 256> table;
+	for (int i = 0; i < 256; i++) {
+		const double value = std::round((i - 16) * 255.0 / 219.0);
+		table[i] = static_cast<std::uint8_t>(std::clamp(value, 0.0, 255.0));
+	}
+	return table;
+}
+
+// Reductions stop once the statistics are at most this many blocks on a side, which still gives stable percentiles.
+constexpr std::uint32_t MaxBlockStatsSize = 32;
+
+std::vector<unique_gs_texture_t> makeReductionChain(const RenderingLayout &layout, bool isNeeded)
+{
+	std::vector<unique_gs_texture_t> chain;
+	if (!isNeeded) {
+		return chain;
+	}
+
+	std::uint32_t chainWidth = layout.processingWidth;
+	std::uint32_t chainHeight = layout.processingHeight;
+	do {
+		chainWidth = (chainWidth + 3) / 4;
+		chainHeight = (chainHeight + 3) / 4;
+		chain.push_back(
+			make_unique_gs_texture(chainWidth, chainHeight, GS_RGBA32F, 1, nullptr, GS_RENDER_TARGET));
+	} while (std::max(chainWidth, chainHeight) > MaxBlockStatsSize);
+	return chain;
+}
+
+std::unique_ptr<AsyncTextureReader> makeBlockStatsReader(const std::vector<unique_gs_texture_t> &chain)
+{
+	if (chain.empty()) {
+		return nullptr;
+	}
+	gs_texture_t *const stats = chain.back().get();
+	return std::make_unique<AsyncTextureReader>(gs_texture_get_width(stats), gs_texture_get_height(stats),
+						    GS_RGBA32F);
+}
+
+void readBlockStats(AsyncTextureReader &reader, std::vector<BlockStats> &blocks)
+{
+	reader.sync();
+
+	blocks.clear();
+	const std::uint8_t *const buffer = reader.getBuffer().data();
+	for (std::uint32_t y = 0; y < reader.getHeight(); y++) {
+		const std::uint8_t *const row = buffer + static_cast<std::size_t>(y) * reader.getBufferLinesize();
+		for (std::uint32_t x = 0; x < reader.getWidth(); x++) {
+			float pixel[4];
+			std::memcpy(pixel, row + static_cast<std::size_t>(x) * sizeof(pixel), sizeof(pixel));
+			blocks.push_back({pixel[0], pixel[1], pixel[2]});
+		}
+	}
+}
+
+} // namespace
+
 RenderingContext::RenderingContext(obs_source_t *_source, const KaitoTokyo::BridgeUtils::ILogger &_logger,
-				   const MainEffect &_mainEffect, std::uint32_t _width, std::uint32_t _height)
+				   const MainEffect &_mainEffect, ThrottledTaskQueue &_canvasTaskQueue,
+				   std::uint32_t _width, std::uint32_t _height, const RenderingLayout &_layout)
 	: source(_source),
 	  logger(_logger),
 	  mainEffect(_mainEffect),
 	  width(_width),
 	  height(_height),
+	  layout(_layout),
 	  bgrxSource(make_unique_gs_texture(width, height, GS_BGRX, 1, nullptr, GS_RENDER_TARGET)),
-	  r8SourceGrayscale(make_unique_gs_texture(width, height, GS_R8, 1, nullptr, GS_RENDER_TARGET)),
-	  r8MedianFilteredGrayscale(make_unique_gs_texture(width, height, GS_R8, 1, nullptr, GS_RENDER_TARGET)),
-	  r8MotionMap(make_unique_gs_texture(width, height, GS_R8, 1, nullptr, GS_RENDER_TARGET)),
-	  r8MotionAdaptiveGrayscales{make_unique_gs_texture(width, height, GS_R8, 1, nullptr, GS_RENDER_TARGET),
-				     make_unique_gs_texture(width, height, GS_R8, 1, nullptr, GS_RENDER_TARGET)},
-	  bgrxComplexSobel(make_unique_gs_texture(width, height, GS_BGRX, 1, nullptr, GS_RENDER_TARGET)),
-	  r8FinalSobelMagnitude(make_unique_gs_texture(width, height, GS_R8, 1, nullptr, GS_RENDER_TARGET)),
-	  r32fIntermediate(make_unique_gs_texture(width, height, GS_R32F, 1, nullptr, GS_RENDER_TARGET))
+	  r8SourceGrayscale(makeProcessingTexture(layout, GS_R8)),
+	  r8MedianFilteredGrayscale(makeProcessingTexture(layout, GS_R8)),
+	  r8MotionMap(makeProcessingTexture(layout, GS_R8)),
+	  r8MotionAdaptiveGrayscales{makeProcessingTexture(layout, GS_R8), makeProcessingTexture(layout, GS_R8)},
+	  r8TemporalHistory(makeTemporalHistory(layout)),
+	  r8TemporalMedian(layout.temporalMedianFrames > 0 ? makeProcessingTexture(layout, GS_R8) : nullptr),
+	  bgrxComplexSobel(makeProcessingTexture(layout, GS_BGRX)),
+	  r8FinalSobelMagnitude(makeProcessingTexture(layout, GS_R8)),
+	  rgbaInkStates{layout.commitsInk ? makeProcessingTexture(layout, GS_RGBA) : nullptr,
+			layout.commitsInk ? makeProcessingTexture(layout, GS_RGBA) : nullptr},
+	  r8CommittedInk(layout.commitsInk ? makeProcessingTexture(layout, GS_R8) : nullptr),
+	  bgraRoiMask(layout.usesMask ? make_unique_gs_texture(layout.roi.width, layout.roi.height, GS_BGRA, 1,
+							       nullptr, GS_RENDER_TARGET)
+				      : nullptr),
+	  r8CanvasDetection(layout.rectifiesCanvas
+				    ? make_unique_gs_texture(CanvasDetectionWidth, getCanvasDetectionHeight(layout.roi),
+							     GS_R8, 1, nullptr, GS_RENDER_TARGET)
+				    : nullptr),
+	  r8SourceLuma(layout.uploadsLuma ? make_unique_gs_texture(width, height, GS_R8, 1, nullptr, GS_DYNAMIC)
+					  : nullptr),
+	  r32fIntermediate(makeProcessingTexture(layout, GS_R32F)),
+	  canvasTaskQueue(_canvasTaskQueue),
+	  canvasReader(layout.rectifiesCanvas
+			       ? std::make_unique<AsyncTextureReader>(CanvasDetectionWidth,
+								      getCanvasDetectionHeight(layout.roi), GS_R8)
+			       : nullptr),
+	  canvasDetector(std::make_shared<CanvasDetector>()),
+	  canvasTracker(std::make_shared<CanvasTracker>()),
+	  rgba32fSobelStats(makeReductionChain(layout, layout.autoCalibrates)),
+	  rgba32fMotionStats(makeReductionChain(layout, layout.autoCalibrates || layout.commitsInk)),
+	  sobelStatsReader(makeBlockStatsReader(rgba32fSobelStats)),
+	  motionStatsReader(makeBlockStatsReader(rgba32fMotionStats))
 {
 }
 
@@ -51,67 +203,396 @@ RenderingContext::~RenderingContext() noexcept {}
 
 void RenderingContext::videoTick(float) {}
 
-obs_source_frame *RenderingContext::filterVideo(obs_source_frame *frame)
+obs_source_frame *RenderingContext::filterVideo(obs_source_frame *frame, const PresetSnapshot &snapshot,
+					       bool isSceneActive)
 {
-	if (frame && frame->timestamp != lastFrameTimestamp) {
+	// Frames of a static scene would reproduce the last output, so they are not even counted by the cadence.
+	if (frame && isSceneActive && frame->timestamp != lastFrameTimestamp) {
 		lastFrameTimestamp = frame->timestamp;
-		doesNextVideoRenderReceiveNewFrame = true;
+		const std::uint32_t steps =
+			processingCadence.onNewFrame(frame->timestamp, snapshot.preset.maxProcessingRate);
+		if (steps > 0) {
+			if (layout.uploadsLuma) {
+				stageSourceLuma(frame);
+			}
+			// Accumulate so that a video_render that falls behind still blends over every frame it skipped.
+			pendingFrameSteps.fetch_add(steps);
+		}
 	}
 
 	return frame;
 }
 
-void RenderingContext::videoRender(const std::shared_ptr<const Preset> &preset)
+void RenderingContext::videoRender(const PresetSnapshot &snapshot, StageProfiler &profiler, obs_source_t *maskSource)
 {
-	ExtractionMode extractionMode = getExtractionMode(*preset);
+	using ScopedStage = StageProfiler::ScopedStage;
+
+	const Preset &preset = snapshot.preset;
+	const PresetConstants &constants = snapshot.constants;
+	ExtractionMode extractionMode = getExtractionMode(preset);
 
-	bool isProcessingNewFrame = doesNextVideoRenderReceiveNewFrame.exchange(false);
+	if (layout.uploadsLuma) {
+		uploadSourceLuma();
+		// A context built for a new size renders before filter_video has staged a frame into it. Processing the
+		// empty r8SourceLuma would seed the history with garbage, so nothing is processed or drawn until then.
+		if (!lumaHandoff.hasTakenFrame()) {
+			return;
+		}
+	}
+
+	// Frames skipped by the processing cadence keep showing the last output.
+	std::uint32_t frameSteps = pendingFrameSteps.exchange(0);
+	if (processedEpoch != snapshot.epoch) {
+		// Edges outside the recomputed tiles would keep the scaling of the previous preset.
+		inkTileTracker.reset();
+	}
+	if (frameSteps == 0 && processedEpoch != snapshot.epoch) {
+		// A new preset must show even while the scene is static and no new frame arrives.
+		frameSteps = 1;
+	}
+	processedEpoch = snapshot.epoch;
+	bool isProcessingNewFrame = frameSteps > 0;
+
+	// Every filter rendering on this tick sees the same video frame time.
+	const std::uint64_t tick = obs_get_video_frame_time();
 
-	const unique_gs_texture_t *grayscaleResult;
+	float motionThreshold = constants.motionAdaptiveFilteringMotionThreshold;
+	float sobelScalingFactor = constants.sobelScalingFactor;
+	if (layout.autoCalibrates) {
+		motionThreshold = autoCalibrator.getMotionThreshold().value_or(motionThreshold);
+		sobelScalingFactor = autoCalibrator.getSobelScalingFactor().value_or(sobelScalingFactor);
+	}
 
 	if (isProcessingNewFrame) {
-		if (extractionMode >= ExtractionMode::Passthrough) {
+		if (extractionMode >= ExtractionMode::Passthrough && !layout.uploadsLuma) {
+			ScopedStage stage(profiler, RenderStage::DrawSource);
 			mainEffect.drawSource(bgrxSource, source);
 		}
 
 		if (extractionMode >= ExtractionMode::ConvertToGrayscale) {
-			mainEffect.applyConvertToGrayscale(r8SourceGrayscale, bgrxSource);
-			grayscaleResult = &r8SourceGrayscale;
+			if (layout.rectifiesCanvas) {
+				updateCanvasDetection(preset, profiler, tick);
+			}
 
-			if (preset->medianFilterEnabled) {
-				mainEffect.applyMedianFilter(r8MedianFilteredGrayscale, r32fIntermediate,
-							     *grayscaleResult);
-				grayscaleResult = &r8MedianFilteredGrayscale;
+			// The stage ahead of the temporal median writes straight into the oldest history slot, so the
+			// history is kept without copying frames.
+			const unique_gs_texture_t *const historySlot =
+				r8TemporalHistory.empty() ? nullptr : &r8TemporalHistory[temporalHistoryNext];
+			const unique_gs_texture_t &grayscaleTarget =
+				historySlot && !preset.medianFilterEnabled ? *historySlot : r8SourceGrayscale;
+			{
+				ScopedStage stage(profiler, RenderStage::ConvertGrayscale);
+				grayscaleResult = convertToGrayscale(preset, grayscaleTarget);
 			}
 
-			if (preset->motionAdaptiveFilteringStrength > 0.0) {
+			if (preset.medianFilterEnabled) {
+				ScopedStage stage(profiler, RenderStage::MedianFilter);
+				const unique_gs_texture_t &medianTarget =
+					historySlot ? *historySlot : r8MedianFilteredGrayscale;
+				mainEffect.applyMedianFilter(medianTarget, r32fIntermediate, *grayscaleResult);
+				grayscaleResult = &medianTarget;
+			}
+
+			if (historySlot) {
+				ScopedStage stage(profiler, RenderStage::TemporalMedian);
+				temporalHistoryNext = (temporalHistoryNext + 1) % r8TemporalHistory.size();
+				temporalHistoryCount = std::min(temporalHistoryCount + 1, r8TemporalHistory.size());
+				// Until the history is full, the current frame passes through unfiltered. The limit set
+				// by the quality governor runs the median over only the latest frames, or skips it.
+				const std::size_t size = r8TemporalHistory.size();
+				const std::size_t medianFrames = getTemporalMedianFrames(preset, size);
+				if (medianFrames > 0 && temporalHistoryCount == size) {
+					temporalMedianInputs.clear();
+					for (std::size_t i = 1; i <= medianFrames; i++) {
+						temporalMedianInputs.push_back(
+							&r8TemporalHistory[(temporalHistoryNext + size - i) % size]);
+					}
+					mainEffect.applyTemporalMedian(r8TemporalMedian, temporalMedianInputs);
+					grayscaleResult = &r8TemporalMedian;
+				}
+			}
+
+			if (preset.motionAdaptiveFilteringStrength > 0.0) {
+				ScopedStage stage(profiler, RenderStage::MotionAdaptiveFilter);
+				const float strength = ProcessingCadence::scaleTemporalStrength(
+					constants.motionAdaptiveFilteringStrength, frameSteps);
 				std::swap(r8MotionAdaptiveGrayscales[0], r8MotionAdaptiveGrayscales[1]);
-				mainEffect.applyMotionAdaptiveFilter(
-					r8MotionAdaptiveGrayscales[0], r8MotionMap, r32fIntermediate, *grayscaleResult,
-					r8MotionAdaptiveGrayscales[1],
-					static_cast<float>(preset->motionAdaptiveFilteringStrength),
-					static_cast<float>(preset->motionAdaptiveFilteringMotionThreshold));
+				mainEffect.applyMotionAdaptiveFilter(r8MotionAdaptiveGrayscales[0], r8MotionMap,
+								     r32fIntermediate, *grayscaleResult,
+								     r8MotionAdaptiveGrayscales[1], strength,
+								     motionThreshold);
 				grayscaleResult = &r8MotionAdaptiveGrayscales[0];
 			}
 		}
 
+		const bool hasMotion = extractionMode >= ExtractionMode::ConvertToGrayscale &&
+				       preset.motionAdaptiveFilteringStrength > 0.0;
 		if (extractionMode >= ExtractionMode::SobelMagnitude) {
-			mainEffect.applySobel(bgrxComplexSobel, *grayscaleResult);
-			mainEffect.applyFinalizeSobelMagnitude(r8FinalSobelMagnitude, bgrxComplexSobel,
-							       preset->sobelUseLog,
-							       static_cast<float>(preset->sobelScalingFactor.linear));
+			// Committed ink needs the motion map. Settled tiles keep the edges of earlier frames.
+			const bool commitsInk = layout.commitsInk && hasMotion;
+			const std::uint32_t processingWidth = layout.processingWidth;
+			const std::uint32_t processingHeight = layout.processingHeight;
+			std::optional<RoiRect> dirtyRect = RoiRect{0, 0, processingWidth, processingHeight};
+			if (commitsInk) {
+				// Each level of the reduction chain summarizes 4x4 texels of the level before.
+				const std::uint32_t blockSize = 1u << (2 * rgba32fMotionStats.size());
+				dirtyRect = inkTileTracker.getDirtyRect(processingWidth, processingHeight, blockSize);
+			}
+
+			if (dirtyRect) {
+				const gs_rect scissor{static_cast<int>(dirtyRect->x), static_cast<int>(dirtyRect->y),
+						      static_cast<int>(dirtyRect->width),
+						      static_cast<int>(dirtyRect->height)};
+				const gs_rect *const scissorOrNull = commitsInk ? &scissor : nullptr;
+				{
+					ScopedStage stage(profiler, RenderStage::Sobel);
+					mainEffect.applySobel(bgrxComplexSobel, *grayscaleResult, scissorOrNull);
+				}
+				ScopedStage stage(profiler, RenderStage::FinalizeSobelMagnitude);
+				mainEffect.applyFinalizeSobelMagnitude(r8FinalSobelMagnitude, bgrxComplexSobel,
+								       constants.sobelUseLog, sobelScalingFactor,
+								       scissorOrNull);
+			}
+
+			edgeResult = &r8FinalSobelMagnitude;
+			if (commitsInk) {
+				ScopedStage stage(profiler, RenderStage::CommitInk);
+				std::swap(rgbaInkStates[0], rgbaInkStates[1]);
+				mainEffect.applyCommitInk(r8CommittedInk, rgbaInkStates[0], r8FinalSobelMagnitude,
+							  rgbaInkStates[1], r8MotionMap, motionThreshold,
+							  static_cast<float>(preset.inkCommitFrames));
+				edgeResult = &r8CommittedInk;
+			}
+		}
+
+		// Calibration can wait a few frames for its statistics, but ink commitment finds the tiles it skips
+		// from them, so it never defers them.
+		if ((layout.autoCalibrates || layout.commitsInk) &&
+		    (layout.commitsInk ||
+		     blockStatsStage.tryRun(getRenderBudgetScheduler(), tick,
+					    profiler.getRecentStageNs(RenderStage::AutoCalibration)))) {
+			ScopedStage stage(profiler, RenderStage::AutoCalibration);
+			updateBlockStats(preset, constants, motionThreshold,
+					 extractionMode >= ExtractionMode::SobelMagnitude, hasMotion);
 		}
 	}
 
+	const bool hasMask = bgraRoiMask && maskSource;
+	if (isProcessingNewFrame && hasMask && extractionMode >= ExtractionMode::ConvertToGrayscale) {
+		mainEffect.drawMaskSource(bgraRoiMask, maskSource, width, height, layout.roi.x, layout.roi.y);
+	}
+
+	ScopedStage stage(profiler, RenderStage::Output);
 	if (extractionMode == ExtractionMode::Passthrough) {
 		mainEffect.drawTexture(bgrxSource);
 	} else if (extractionMode == ExtractionMode::ConvertToGrayscale) {
-		mainEffect.drawGrayscaleTexture(*grayscaleResult);
+		drawOutput(preset, *grayscaleResult, hasMask);
 	} else if (extractionMode == ExtractionMode::MotionMapCalculation) {
-		mainEffect.drawGrayscaleTexture(r8MotionMap);
+		drawOutput(preset, r8MotionMap, hasMask);
 	} else if (extractionMode == ExtractionMode::SobelMagnitude) {
-		mainEffect.drawGrayscaleTexture(r8FinalSobelMagnitude);
+		drawOutput(preset, *edgeResult, hasMask);
+	}
+}
+
+const unique_gs_texture_t *RenderingContext::convertToGrayscale(const Preset &preset, const unique_gs_texture_t &target)
+{
+	const RoiRect &roi = layout.roi;
+	if (layout.uploadsLuma) {
+		// The uploaded luma is already the grayscale image; only a partial or scaled ROI, or a history slot,
+		// which must own its frame, needs a pass to crop it.
+		if (layout.processingWidth == width && layout.processingHeight == height &&
+		    &target == &r8SourceGrayscale) {
+			return &r8SourceLuma;
+		}
+		mainEffect.applyCropGrayscale(target, r8SourceLuma, roi.x, roi.y, roi.width, roi.height);
+		return &target;
+	}
+
+	if (!layout.rectifiesCanvas) {
+		mainEffect.applyConvertToGrayscale(target, bgrxSource, roi.x, roi.y, roi.width, roi.height);
+		return &target;
+	}
+
+	// The quad is found in ROI coordinates; the warp samples the whole source texture.
+	CanvasQuad quad = canvasTracker->get().value_or(CanvasQuad::fullImage());
+	for (CanvasPoint &corner : quad.corners) {
+		corner.x = (static_cast<float>(roi.x) + corner.x * static_cast<float>(roi.width)) /
+			   static_cast<float>(width);
+		corner.y = (static_cast<float>(roi.y) + corner.y * static_cast<float>(roi.height)) /
+			   static_cast<float>(height);
+	}
+	const std::optional<Homography> homography = computeUnitSquareToQuad(quad);
+	if (!homography) {
+		mainEffect.applyConvertToGrayscale(target, bgrxSource, roi.x, roi.y, roi.width, roi.height);
+	} else {
+		mainEffect.applyWarpConvertToGrayscale(target, bgrxSource, *homography);
+	}
+	return &target;
+}
+
+void RenderingContext::stageSourceLuma(obs_source_frame *frame)
+{
+	const std::optional<YuvFrameView> yuv = getSourceFrameYuv(frame);
+	if (!yuv || yuv->width != width || yuv->height != height) {
+		return;
+	}
+
+	const CpuKernels::ConstLumaView luma = extractLuma(*yuv, lumaScratch);
+	std::vector<std::uint8_t> &staging = lumaHandoff.getStaging(static_cast<std::size_t>(width) * height);
+	if (frame->full_range) {
+		for (std::size_t y = 0; y < height; y++) {
+			std::memcpy(staging.data() + y * width, luma.row(y), width);
+		}
+	} else {
+		static const std::array<std::uint8_t, 256> table = makeLimitedToFullRangeTable();
+		for (std::size_t y = 0; y < height; y++) {
+			CpuKernels::applyTableRow(luma.row(y), staging.data() + y * width, width, table);
+		}
+	}
+	lumaHandoff.publish();
+}
+
+void RenderingContext::uploadSourceLuma()
+{
+	if (const std::vector<std::uint8_t> *luma = lumaHandoff.take()) {
+		gs_texture_set_image(r8SourceLuma.get(), luma->data(), width, false);
+	}
+}
+
+void RenderingContext::updateCanvasDetection(const Preset &preset, StageProfiler &profiler, std::uint64_t tick)
+{
+	// The copy staged on an earlier frame is read back first, so the render thread never waits for the GPU.
+	if (isCanvasReadbackPending) {
+		isCanvasReadbackPending = false;
+		canvasReader->sync();
+
+		auto image =
+			std::make_shared<CpuKernels::LumaImage>(canvasReader->getWidth(), canvasReader->getHeight());
+		AsyncTextureReaderDetail::copyRows(image->pixels.data(), image->width, canvasReader->getBuffer().data(),
+						   canvasReader->getBufferLinesize(), image->width,
+						   canvasReader->getHeight());
+		canvasTaskQueue.push([detector = canvasDetector, tracker = canvasTracker,
+				      image](const ThrottledTaskQueue::CancellationToken &token) {
+			if (!token->load()) {
+				tracker->update(detector->detect(image->view()));
+			}
+		});
+	}
+
+	const std::uint64_t now = os_gettime_ns();
+	const auto intervalNs = static_cast<std::uint64_t>(std::max(preset.canvasDetectionInterval, 0.1) * 1e9);
+	if (lastCanvasDetectionNs != 0 && now - lastCanvasDetectionNs < intervalNs) {
+		return;
+	}
+	// A refresh that does not fit the budget of this tick is retried on the next frame.
+	if (!canvasDetectionStage.tryRun(getRenderBudgetScheduler(), tick,
+					 profiler.getRecentStageNs(RenderStage::CanvasDetection))) {
+		return;
+	}
+	lastCanvasDetectionNs = now;
+
+	StageProfiler::ScopedStage stage(profiler, RenderStage::CanvasDetection);
+	const RoiRect &roi = layout.roi;
+	mainEffect.applyConvertToGrayscale(r8CanvasDetection, bgrxSource, roi.x, roi.y, roi.width, roi.height);
+	canvasReader->stage(r8CanvasDetection.get());
+	isCanvasReadbackPending = true;
+}
+
+void RenderingContext::updateBlockStats(const Preset &preset, const PresetConstants &constants,
+				       float motionThreshold, bool hasSobel, bool hasMotion)
+{
+	// Statistics staged on the previous processed frame are read first, so the GPU has had a frame to finish them.
+	if (isSobelStatsPending) {
+		isSobelStatsPending = false;
+		readBlockStats(*sobelStatsReader, blockStats);
+		autoCalibrator.updateSobel(blockStats, constants.sobelUseLog);
+	}
+	if (isMotionStatsPending) {
+		isMotionStatsPending = false;
+		readBlockStats(*motionStatsReader, blockStats);
+		if (layout.autoCalibrates) {
+			autoCalibrator.updateMotion(blockStats);
+		}
+		if (layout.commitsInk) {
+			inkTileTracker.update(blockStats, motionStatsReader->getWidth(), motionThreshold,
+					      static_cast<std::uint32_t>(std::max(preset.inkCommitFrames, 1)));
+		}
+	}
+
+	if (hasSobel && layout.autoCalibrates) {
+		mainEffect.applyReduceToBlockStats(rgba32fSobelStats, bgrxComplexSobel);
+		sobelStatsReader->stage(rgba32fSobelStats.back().get());
+		isSobelStatsPending = true;
+	}
+	if (hasMotion) {
+		mainEffect.applyReduceToBlockStats(rgba32fMotionStats, r8MotionMap);
+		motionStatsReader->stage(rgba32fMotionStats.back().get());
+		isMotionStatsPending = true;
+	}
+}
+
+void RenderingContext::drawOutput(const Preset &preset, const unique_gs_texture_t &output, bool hasMask) const
+{
+	const RoiRect &roi = layout.roi;
+
+	if (layout.rectifiesCanvas) {
+		// The straight-on canvas is stretched over the whole frame. The color source does not line up with it,
+		// so there is nothing to composite onto.
+		gs_matrix_push();
+		gs_matrix_scale3f(static_cast<float>(width) / static_cast<float>(layout.processingWidth),
+				  static_cast<float>(height) / static_cast<float>(layout.processingHeight), 1.0f);
+		if (preset.outputMode == OutputMode::AlphaMask) {
+			mainEffect.drawGrayscaleAsAlpha(output, preset.inkColor, nullptr);
+		} else {
+			mainEffect.drawGrayscaleTexture(output);
+		}
+		gs_matrix_pop();
+		return;
+	}
+
+	// The alpha mask leaves everything but the ink transparent, and the composited modes draw the color source
+	// under the mask themselves.
+	const bool coversFrame = roi.width == width && roi.height == height;
+	const bool drawsSurroundings = preset.outputMode != OutputMode::AlphaMask &&
+				       (!coversFrame || (hasMask && preset.outputMode == OutputMode::Grayscale));
+	if (drawsSurroundings) {
+		if (preset.roiOutsideMode == RoiOutsideMode::Blank) {
+			mainEffect.drawSolidColor(width, height, 0xFF000000);
+		} else {
+			mainEffect.drawTexture(bgrxSource);
+		}
+	}
+
+	gs_matrix_push();
+	gs_matrix_translate3f(static_cast<float>(roi.x), static_cast<float>(roi.y), 0.0f);
+	// A scaled output is stretched back over the ROI; the mask covers the ROI at any scale.
+	gs_matrix_scale3f(static_cast<float>(roi.width) / static_cast<float>(layout.processingWidth),
+			  static_cast<float>(roi.height) / static_cast<float>(layout.processingHeight), 1.0f);
+	const unique_gs_texture_t *const mask = hasMask ? &bgraRoiMask : nullptr;
+	const float frameWidth = static_cast<float>(width);
+	const float frameHeight = static_cast<float>(height);
+	const std::array<float, 4> sourceRegion{
+		static_cast<float>(roi.x) / frameWidth, static_cast<float>(roi.y) / frameHeight,
+		static_cast<float>(roi.width) / frameWidth, static_cast<float>(roi.height) / frameHeight};
+	switch (preset.outputMode) {
+	case OutputMode::Multiply:
+		mainEffect.drawGrayscaleMultiplied(output, bgrxSource, sourceRegion, preset.inkColor, mask);
+		break;
+	case OutputMode::Overlay:
+		mainEffect.drawGrayscaleOverlaid(output, bgrxSource, sourceRegion, preset.inkColor, mask);
+		break;
+	case OutputMode::AlphaMask:
+		mainEffect.drawGrayscaleAsAlpha(output, preset.inkColor, mask);
+		break;
+	default:
+		if (hasMask) {
+			mainEffect.drawGrayscaleTextureMasked(output, bgraRoiMask);
+		} else {
+			mainEffect.drawGrayscaleTexture(output);
+		}
+		break;
 	}
+	gs_matrix_pop();
 }
 
 } // namespace ShowDraw
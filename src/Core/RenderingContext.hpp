@@ -22,13 +22,25 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <atomic>
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <vector>
 
 #include <obs.h>
 
+#include "../BridgeUtils/AsyncTextureReader.hpp"
 #include "../BridgeUtils/GsUnique.hpp"
+#include "../BridgeUtils/ThrottledTaskQueue.hpp"
+#include "../CpuEngine/CanvasDetector.hpp"
 
+#include "AutoCalibrator.hpp"
+#include "InkTileTracker.hpp"
+#include "LumaHandoff.hpp"
 #include "MainEffect.hpp"
 #include "Preset.hpp"
+#include "ProcessingCadence.hpp"
+#include "RenderBudgetScheduler.hpp"
+#include "RenderingLayout.hpp"
+#include "StageProfiler.hpp"
 
 namespace KaitoTokyo {
 namespace ShowDraw {
@@ -41,33 +53,111 @@ public:
 
 	const std::uint32_t width;
 	const std::uint32_t height;
+	const RenderingLayout layout;
 
 	const KaitoTokyo::BridgeUtils::unique_gs_texture_t bgrxSource;
 	const KaitoTokyo::BridgeUtils::unique_gs_texture_t r8SourceGrayscale;
 	const KaitoTokyo::BridgeUtils::unique_gs_texture_t r8MedianFilteredGrayscale;
 	const KaitoTokyo::BridgeUtils::unique_gs_texture_t r8MotionMap;
 	std::array<KaitoTokyo::BridgeUtils::unique_gs_texture_t, 2> r8MotionAdaptiveGrayscales;
+	// Empty unless the layout has the temporal median: a ring of the last frames entering the stage.
+	const std::vector<KaitoTokyo::BridgeUtils::unique_gs_texture_t> r8TemporalHistory;
+	// Null unless the layout has the temporal median.
+	const KaitoTokyo::BridgeUtils::unique_gs_texture_t r8TemporalMedian;
 
 	const KaitoTokyo::BridgeUtils::unique_gs_texture_t bgrxComplexSobel;
 	const KaitoTokyo::BridgeUtils::unique_gs_texture_t r8FinalSobelMagnitude;
+	// Null unless the layout commits ink: the ping-pong state of UpdateCommittedInk and the edges shown.
+	std::array<KaitoTokyo::BridgeUtils::unique_gs_texture_t, 2> rgbaInkStates;
+	const KaitoTokyo::BridgeUtils::unique_gs_texture_t r8CommittedInk;
+	// Null unless the layout uses a mask source.
+	const KaitoTokyo::BridgeUtils::unique_gs_texture_t bgraRoiMask;
+	// Null unless the layout rectifies the canvas.
+	const KaitoTokyo::BridgeUtils::unique_gs_texture_t r8CanvasDetection;
+	// Null unless the layout uploads luma: the whole frame's luma, written from the staged frame on render.
+	const KaitoTokyo::BridgeUtils::unique_gs_texture_t r8SourceLuma;
 
 private:
 	const KaitoTokyo::BridgeUtils::unique_gs_texture_t r32fIntermediate;
+	// The last grayscale stage, kept so that frames skipped by the cadence can still draw it.
+	const KaitoTokyo::BridgeUtils::unique_gs_texture_t *grayscaleResult = &r8SourceGrayscale;
+	// The history slot that the next frame overwrites, just after the latest one, and how many slots hold a frame.
+	std::size_t temporalHistoryNext = 0;
+	std::size_t temporalHistoryCount = 0;
+	// The history slots that the temporal median runs over, kept to avoid an allocation per frame.
+	std::vector<const KaitoTokyo::BridgeUtils::unique_gs_texture_t *> temporalMedianInputs;
+	// The last edge stage, kept like grayscaleResult.
+	const KaitoTokyo::BridgeUtils::unique_gs_texture_t *edgeResult = &r8FinalSobelMagnitude;
+
+	KaitoTokyo::BridgeUtils::ThrottledTaskQueue &canvasTaskQueue;
+	std::unique_ptr<KaitoTokyo::BridgeUtils::AsyncTextureReader> canvasReader;
+	// Shared with detection tasks, which may outlive the context.
+	const std::shared_ptr<CanvasDetector> canvasDetector;
+	const std::shared_ptr<CanvasTracker> canvasTracker;
+	bool isCanvasReadbackPending = false;
+	std::uint64_t lastCanvasDetectionNs = 0;
+	DeferrableStage canvasDetectionStage;
+
+	// Empty unless the layout needs them: RGBA32F 4x4 reduction chains ending in the block statistics. The Sobel
+	// chain serves auto-calibration; the motion chain also serves ink commitment.
+	const std::vector<KaitoTokyo::BridgeUtils::unique_gs_texture_t> rgba32fSobelStats;
+	const std::vector<KaitoTokyo::BridgeUtils::unique_gs_texture_t> rgba32fMotionStats;
+	std::unique_ptr<KaitoTokyo::BridgeUtils::AsyncTextureReader> sobelStatsReader;
+	std::unique_ptr<KaitoTokyo::BridgeUtils::AsyncTextureReader> motionStatsReader;
+	bool isSobelStatsPending = false;
+	bool isMotionStatsPending = false;
+	DeferrableStage blockStatsStage;
+	AutoCalibrator autoCalibrator;
+	InkTileTracker inkTileTracker;
+	std::vector<BlockStats> blockStats;
+
+	CpuKernels::LumaImage lumaScratch;
+	LumaHandoff lumaHandoff;
 
 private:
 	std::uint64_t lastFrameTimestamp = 0;
-	std::atomic<bool> doesNextVideoRenderReceiveNewFrame = false;
+	ProcessingCadence processingCadence;
+	// Source frames represented by the frame awaiting video_render, or 0 if there is none.
+	std::atomic<std::uint32_t> pendingFrameSteps = 0;
+	// Render thread only: the epoch of the preset that produced the current output.
+	std::optional<std::uint64_t> processedEpoch;
 
 public:
 	RenderingContext(obs_source_t *source, const KaitoTokyo::BridgeUtils::ILogger &logger,
-			 const MainEffect &mainEffect, std::uint32_t width, std::uint32_t height);
+			 const MainEffect &mainEffect, KaitoTokyo::BridgeUtils::ThrottledTaskQueue &canvasTaskQueue,
+			 std::uint32_t width, std::uint32_t height, const RenderingLayout &layout);
 	~RenderingContext() noexcept;
 
 	void videoTick(float seconds);
-	obs_source_frame *filterVideo(obs_source_frame *frame);
-	void videoRender(const std::shared_ptr<const Preset> &preset);
+	/**
+	 * @param isSceneActive False while the drawing is static, in which case the frame is not processed.
+	 */
+	obs_source_frame *filterVideo(obs_source_frame *frame, const PresetSnapshot &snapshot, bool isSceneActive);
+	/**
+	 * @param maskSource The source named by the preset's ROI mask, or null to process the whole ROI.
+	 */
+	void videoRender(const PresetSnapshot &snapshot, StageProfiler &profiler, obs_source_t *maskSource);
 
 private:
+	/**
+	 * @param target Where to write the grayscale image. Only r8SourceGrayscale may be bypassed by returning
+	 * the uploaded luma when that needs no pass.
+	 * @return The texture holding the grayscale image.
+	 */
+	const KaitoTokyo::BridgeUtils::unique_gs_texture_t *
+	convertToGrayscale(const Preset &preset, const KaitoTokyo::BridgeUtils::unique_gs_texture_t &target);
+	void stageSourceLuma(obs_source_frame *frame);
+	void uploadSourceLuma();
+	/**
+	 * @param tick The render tick, whose budget a refresh of the detection copy waits for.
+	 */
+	void updateCanvasDetection(const Preset &preset, StageProfiler &profiler, std::uint64_t tick);
+	void updateBlockStats(const Preset &preset, const PresetConstants &constants, float motionThreshold,
+			      bool hasSobel, bool hasMotion);
+
+	void drawOutput(const Preset &preset, const KaitoTokyo::BridgeUtils::unique_gs_texture_t &output,
+			bool hasMask) const;
+
 	static ExtractionMode getExtractionMode(const Preset &p) noexcept
 	{
 		return p.extractionMode == ExtractionMode::Default ? ExtractionMode::SobelMagnitude : p.extractionMode;
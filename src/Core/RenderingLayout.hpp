@@ -0,0 +1,118 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Preset.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @brief The texture sizes and optional stages of a RenderingContext. A change of layout rebuilds the context.
+ */
+struct RenderingLayout {
+	RoiRect roi;
+	// The size of every texture after the source copy: the ROI, or the working size of the rectified canvas,
+	// scaled by the processing scale.
+	std::uint32_t processingWidth;
+	std::uint32_t processingHeight;
+	bool rectifiesCanvas;
+	bool usesMask;
+	bool autoCalibrates;
+	// Whether the chain starts from the luma plane of the source frame instead of a BGRX copy of the source.
+	bool uploadsLuma;
+	// The length of the temporal median history: 3, 5, or 0 without the stage.
+	std::uint32_t temporalMedianFrames;
+	bool commitsInk;
+
+	/**
+	 * @param hasNativeLuma Whether the source frames have a luma plane that can be uploaded as is.
+	 */
+	static RenderingLayout fromPreset(const Preset &preset, std::uint32_t frameWidth, std::uint32_t frameHeight,
+					  bool hasNativeLuma = false) noexcept
+	{
+		RenderingLayout layout;
+		layout.roi = preset.getRoiRect(frameWidth, frameHeight);
+		layout.rectifiesCanvas = preset.canvasRectificationEnabled;
+		const std::uint32_t scale = static_cast<std::uint32_t>(std::clamp(preset.processingScale, 10, 100));
+		if (layout.rectifiesCanvas) {
+			const int workingWidth = std::clamp(preset.canvasWorkingWidth * static_cast<int>(scale) / 100,
+							    64, 3840);
+			layout.processingWidth = static_cast<std::uint32_t>(workingWidth);
+			layout.processingHeight = layout.processingWidth * 9 / 16;
+		} else {
+			layout.processingWidth = std::max<std::uint32_t>(layout.roi.width * scale / 100, 1);
+			layout.processingHeight = std::max<std::uint32_t>(layout.roi.height * scale / 100, 1);
+		}
+		// The rectified canvas fills the frame, so there is nothing for a mask to composite over.
+		layout.usesMask = !preset.roiMaskSourceName.empty() && !layout.rectifiesCanvas;
+		layout.autoCalibrates = preset.autoCalibrationEnabled;
+		layout.commitsInk = preset.inkCommitEnabled;
+		if (preset.temporalMedianFrames >= 5) {
+			layout.temporalMedianFrames = 5;
+		} else if (preset.temporalMedianFrames >= 3) {
+			layout.temporalMedianFrames = 3;
+		} else {
+			layout.temporalMedianFrames = 0;
+		}
+
+		// The color image is still needed to warp the canvas, to show around the ROI and to composite onto.
+		const bool coversFrame = layout.roi.width == frameWidth && layout.roi.height == frameHeight;
+		const bool showsSurroundings = (!coversFrame || layout.usesMask) &&
+					       preset.roiOutsideMode == RoiOutsideMode::Passthrough &&
+					       preset.outputMode != OutputMode::AlphaMask;
+		const bool showsColor = showsSurroundings || preset.outputMode == OutputMode::Multiply ||
+					preset.outputMode == OutputMode::Overlay;
+		const bool isGrayscaleMode = preset.extractionMode == ExtractionMode::Default ||
+					     preset.extractionMode >= ExtractionMode::ConvertToGrayscale;
+		layout.uploadsLuma = hasNativeLuma && isGrayscaleMode && !layout.rectifiesCanvas && !showsColor;
+		return layout;
+	}
+
+	bool operator==(const RenderingLayout &other) const noexcept
+	{
+		return roi == other.roi && processingWidth == other.processingWidth &&
+		       processingHeight == other.processingHeight && rectifiesCanvas == other.rectifiesCanvas &&
+		       usesMask == other.usesMask && autoCalibrates == other.autoCalibrates &&
+		       uploadsLuma == other.uploadsLuma && temporalMedianFrames == other.temporalMedianFrames &&
+		       commitsInk == other.commitsInk;
+	}
+	bool operator!=(const RenderingLayout &other) const noexcept { return !(*this == other); }
+};
+
+/**
+ * @brief What a RenderingContext is built for; a frame that needs another spec needs another context.
+ */
+struct RenderingContextSpec {
+	std::uint32_t width;
+	std::uint32_t height;
+	RenderingLayout layout;
+
+	bool operator==(const RenderingContextSpec &other) const noexcept
+	{
+		return width == other.width && height == other.height && layout == other.layout;
+	}
+	bool operator!=(const RenderingContextSpec &other) const noexcept { return !(*this == other); }
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
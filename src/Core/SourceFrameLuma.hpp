@@ -0,0 +1,131 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <optional>
+
+#include <obs.h>
+
+#include "../CpuEngine/YuvFrame.hpp"
+
+#include "ActivityGate.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @brief Gets the luma plane of an asynchronous source frame without converting it.
+ *
+ * Planar and semi-planar YUV formats expose their Y plane directly; MSB-aligned 10- and 16-bit formats are read
+ * through their high byte, so the LSB-aligned I010 and I210 are not supported. Packed RGB formats expose their
+ * green channel, which is close enough to luma to see change.
+ * @return std::nullopt for formats without a usable plane.
+ */
+inline std::optional<LumaPlaneView> getSourceFrameLuma(const obs_source_frame *frame) noexcept
+{
+	const auto plane = [frame](std::uint32_t offset, std::uint32_t pixelStride) {
+		return LumaPlaneView{frame->data[0] + offset, frame->linesize[0], frame->width, frame->height,
+				     pixelStride};
+	};
+
+	if (!frame->data[0]) {
+		return std::nullopt;
+	}
+
+	switch (frame->format) {
+	case VIDEO_FORMAT_I420:
+	case VIDEO_FORMAT_NV12:
+	case VIDEO_FORMAT_I422:
+	case VIDEO_FORMAT_I444:
+	case VIDEO_FORMAT_I40A:
+	case VIDEO_FORMAT_I42A:
+	case VIDEO_FORMAT_YUVA:
+	case VIDEO_FORMAT_Y800:
+		return plane(0, 1);
+	case VIDEO_FORMAT_YUY2:
+	case VIDEO_FORMAT_YVYU:
+		return plane(0, 2);
+	case VIDEO_FORMAT_UYVY:
+		return plane(1, 2);
+	case VIDEO_FORMAT_P010:
+	case VIDEO_FORMAT_P216:
+	case VIDEO_FORMAT_P416:
+		return plane(1, 2);
+	case VIDEO_FORMAT_RGBA:
+	case VIDEO_FORMAT_BGRA:
+	case VIDEO_FORMAT_BGRX:
+		return plane(1, 4);
+	case VIDEO_FORMAT_BGR3:
+		return plane(1, 3);
+	default:
+		return std::nullopt;
+	}
+}
+
+/**
+ * @brief Maps a libobs video format to the YUV format of the CPU engine, if it is one it can work on in place.
+ */
+inline std::optional<YuvFormat> getYuvFormat(video_format format) noexcept
+{
+	switch (format) {
+	case VIDEO_FORMAT_I420:
+		return YuvFormat::I420;
+	case VIDEO_FORMAT_NV12:
+		return YuvFormat::NV12;
+	case VIDEO_FORMAT_I422:
+		return YuvFormat::I422;
+	case VIDEO_FORMAT_I444:
+		return YuvFormat::I444;
+	case VIDEO_FORMAT_Y800:
+		return YuvFormat::Y800;
+	case VIDEO_FORMAT_YUY2:
+		return YuvFormat::YUY2;
+	case VIDEO_FORMAT_YVYU:
+		return YuvFormat::YVYU;
+	case VIDEO_FORMAT_UYVY:
+		return YuvFormat::UYVY;
+	case VIDEO_FORMAT_P010:
+		return YuvFormat::P010;
+	case VIDEO_FORMAT_P216:
+		return YuvFormat::P216;
+	case VIDEO_FORMAT_P416:
+		return YuvFormat::P416;
+	default:
+		return std::nullopt;
+	}
+}
+
+/**
+ * @brief Gets a view of an asynchronous source frame in a YUV format the CPU engine supports.
+ */
+inline std::optional<YuvFrameView> getSourceFrameYuv(obs_source_frame *frame) noexcept
+{
+	const std::optional<YuvFormat> format = getYuvFormat(frame->format);
+	if (!format || !frame->data[0]) {
+		return std::nullopt;
+	}
+	return YuvFrameView{*format,
+			    {frame->data[0], frame->data[1], frame->data[2]},
+			    {frame->linesize[0], frame->linesize[1], frame->linesize[2]},
+			    frame->width,
+			    frame->height};
+}
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
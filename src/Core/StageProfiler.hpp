@@ -0,0 +1,344 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+#include <obs.h>
+
+#include "../BridgeUtils/GsUnique.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @brief The GPU stages of RenderingContext::videoRender in the order they run.
+ */
+enum class RenderStage : std::size_t {
+	DrawSource,
+	ConvertGrayscale,
+	MedianFilter,
+	TemporalMedian,
+	MotionAdaptiveFilter,
+	Sobel,
+	FinalizeSobelMagnitude,
+	CommitInk,
+	// The copy of the source staged for canvas detection, on the frames that refresh it.
+	CanvasDetection,
+	// The block statistics, which feed both auto-calibration and the settled tiles of ink commitment.
+	AutoCalibration,
+	Output,
+};
+
+constexpr std::size_t RenderStageCount = static_cast<std::size_t>(RenderStage::Output) + 1;
+
+inline const char *getRenderStageName(RenderStage stage) noexcept
+{
+	switch (stage) {
+	case RenderStage::DrawSource:
+		return "DrawSource";
+	case RenderStage::ConvertGrayscale:
+		return "ConvertGrayscale";
+	case RenderStage::MedianFilter:
+		return "MedianFilter";
+	case RenderStage::TemporalMedian:
+		return "TemporalMedian";
+	case RenderStage::MotionAdaptiveFilter:
+		return "MotionAdaptiveFilter";
+	case RenderStage::Sobel:
+		return "Sobel";
+	case RenderStage::FinalizeSobelMagnitude:
+		return "FinalizeSobelMagnitude";
+	case RenderStage::CommitInk:
+		return "CommitInk";
+	case RenderStage::CanvasDetection:
+		return "CanvasDetection";
+	case RenderStage::AutoCalibration:
+		return "AutoCalibration";
+	case RenderStage::Output:
+		return "Output";
+	}
+	return "Unknown";
+}
+
+/**
+ * @brief Totals accumulated since profiling was last reset.
+ *
+ * Filled by the "get_stage_timings" procedure of the filter, so the layout is shared with callers.
+ * Times are in nanoseconds; divide by the frame counts to get per-frame averages.
+ */
+struct StageTimings {
+	std::uint64_t renderedFrames = 0;      // videoRender calls that were profiled
+	std::uint64_t renderCpuNs = 0;         // wall time spent in those calls on the render thread
+	std::uint64_t resolvedFrames = 0;      // frames whose GPU queries have been read back
+	std::uint64_t disjointFrames = 0;      // frames dropped because the GPU clock was disjoint
+	std::array<std::uint64_t, RenderStageCount> stageGpuNs{};
+	std::array<std::uint64_t, RenderStageCount> stageFrames{}; // resolved frames that ran each stage
+};
+
+/**
+ * @class StageProfiler
+ * @brief Measures each stage of the render pipeline with GPU timer queries.
+ *
+ * The totals are disabled until reset() is called. Otherwise only one frame in CostSampleInterval is measured,
+ * which keeps the recent stage costs that the render budget schedules with at a negligible cost.
+ * Queries are kept in a ring of QueryLatency frames and read back when their slot comes around again,
+ * which hides the query latency without ever stalling the render thread. A frame whose slot is still
+ * in flight is simply not profiled.
+ * beginFrame(), endFrame(), beginStage() and endStage() must be called within the graphics context.
+ */
+class StageProfiler {
+public:
+	static constexpr std::size_t QueryLatency = 3;
+	static constexpr std::size_t CostSampleInterval = 30;
+
+	StageProfiler() = default;
+
+	StageProfiler(const StageProfiler &) = delete;
+	StageProfiler &operator=(const StageProfiler &) = delete;
+	StageProfiler(StageProfiler &&) = delete;
+	StageProfiler &operator=(StageProfiler &&) = delete;
+
+	/**
+	 * @brief Enables profiling and clears the totals. Safe to call from any thread.
+	 */
+	void reset() noexcept
+	{
+		resetRequested.store(true, std::memory_order_release);
+		enabled.store(true, std::memory_order_release);
+	}
+
+	bool isEnabled() const noexcept { return enabled.load(std::memory_order_acquire); }
+
+	/**
+	 * @brief Gets a copy of the totals. Safe to call from any thread.
+	 */
+	StageTimings getTimings() const
+	{
+		std::lock_guard<std::mutex> lock(timingsMutex);
+		return timings;
+	}
+
+	/**
+	 * @brief Gets the recent GPU time of a stage on the frames that ran it. Render thread only.
+	 * @return nullopt until a frame running the stage has been measured.
+	 */
+	std::optional<std::uint64_t> getRecentStageNs(RenderStage stage) const noexcept
+	{
+		const std::optional<double> &cost = recentStageNs[static_cast<std::size_t>(stage)];
+		return cost ? std::optional<std::uint64_t>(static_cast<std::uint64_t>(*cost)) : std::nullopt;
+	}
+
+	/**
+	 * @brief Counts the measured frames that ran the pipeline rather than only drawing its output. Render thread
+	 * only.
+	 */
+	std::uint64_t getPipelineSampleCount() const noexcept { return pipelineSampleCount; }
+
+	/**
+	 * @brief Gets the GPU time of every stage of the latest measured frame that ran the pipeline. Render thread
+	 * only.
+	 */
+	std::uint64_t getLastPipelineNs() const noexcept { return lastPipelineNs; }
+
+	void beginFrame()
+	{
+		frameActive = false;
+		const bool countsTotals = isEnabled();
+		if (!countsTotals && sampleCountdown-- > 0) {
+			return;
+		}
+		sampleCountdown = CostSampleInterval - 1;
+
+		if (resetRequested.exchange(false, std::memory_order_acq_rel)) {
+			for (Slot &slot : slots) {
+				slot.pending = false;
+			}
+			std::lock_guard<std::mutex> lock(timingsMutex);
+			timings = StageTimings{};
+		}
+
+		Slot &slot = slots[frameIndex % QueryLatency];
+		if (slot.pending && !resolve(slot)) {
+			return;
+		}
+
+		if (!slot.range) {
+			slot.range = BridgeUtils::make_unique_gs_timer_range();
+			for (auto &timer : slot.timers) {
+				timer = BridgeUtils::make_unique_gs_timer();
+			}
+		}
+
+		slot.used.fill(false);
+		slot.countsTotals = countsTotals;
+		gs_timer_range_begin(slot.range.get());
+		frameStartNs = os_gettime_ns();
+		frameActive = true;
+	}
+
+	void endFrame()
+	{
+		if (!frameActive) {
+			return;
+		}
+		frameActive = false;
+
+		Slot &slot = slots[frameIndex % QueryLatency];
+		gs_timer_range_end(slot.range.get());
+		slot.pending = true;
+		frameIndex++;
+		if (!slot.countsTotals) {
+			return;
+		}
+
+		const std::uint64_t elapsedNs = os_gettime_ns() - frameStartNs;
+		std::lock_guard<std::mutex> lock(timingsMutex);
+		timings.renderedFrames++;
+		timings.renderCpuNs += elapsedNs;
+	}
+
+	void beginStage(RenderStage stage)
+	{
+		if (frameActive) {
+			Slot &slot = slots[frameIndex % QueryLatency];
+			slot.used[static_cast<std::size_t>(stage)] = true;
+			gs_timer_begin(slot.timers[static_cast<std::size_t>(stage)].get());
+		}
+	}
+
+	void endStage(RenderStage stage)
+	{
+		if (frameActive) {
+			gs_timer_end(slots[frameIndex % QueryLatency].timers[static_cast<std::size_t>(stage)].get());
+		}
+	}
+
+	/**
+	 * @brief Times one stage for the lifetime of the object.
+	 */
+	class ScopedStage {
+	public:
+		ScopedStage(StageProfiler &_profiler, RenderStage _stage) : profiler(_profiler), stage(_stage)
+		{
+			profiler.beginStage(stage);
+		}
+		~ScopedStage() { profiler.endStage(stage); }
+
+		ScopedStage(const ScopedStage &) = delete;
+		ScopedStage &operator=(const ScopedStage &) = delete;
+
+	private:
+		StageProfiler &profiler;
+		const RenderStage stage;
+	};
+
+private:
+	struct Slot {
+		BridgeUtils::unique_gs_timer_range_t range;
+		std::array<BridgeUtils::unique_gs_timer_t, RenderStageCount> timers;
+		std::array<bool, RenderStageCount> used{};
+		bool pending = false;
+		// Whether the frame was profiled for the totals rather than only sampled for the recent costs.
+		bool countsTotals = false;
+	};
+
+	/**
+	 * @return false if the queries of the slot are not available yet.
+	 */
+	bool resolve(Slot &slot)
+	{
+		bool disjoint = false;
+		std::uint64_t frequency = 0;
+		if (!gs_timer_range_get_data(slot.range.get(), &disjoint, &frequency)) {
+			return false;
+		}
+
+		std::array<std::uint64_t, RenderStageCount> ticks{};
+		for (std::size_t i = 0; i < RenderStageCount; i++) {
+			if (slot.used[i] && !gs_timer_get_data(slot.timers[i].get(), &ticks[i])) {
+				return false;
+			}
+		}
+		slot.pending = false;
+
+		const bool isValid = !disjoint && frequency != 0;
+		std::array<std::uint64_t, RenderStageCount> stageNs{};
+		std::uint64_t frameNs = 0;
+		bool ranPipeline = false;
+		for (std::size_t i = 0; i < RenderStageCount && isValid; i++) {
+			if (slot.used[i]) {
+				stageNs[i] = static_cast<std::uint64_t>(static_cast<double>(ticks[i]) * 1e9 /
+									static_cast<double>(frequency));
+				// An exponential average, so that a single slow frame does not starve a stage.
+				std::optional<double> &cost = recentStageNs[i];
+				cost = cost ? *cost + (static_cast<double>(stageNs[i]) - *cost) * 0.25
+					    : static_cast<double>(stageNs[i]);
+				frameNs += stageNs[i];
+				ranPipeline = ranPipeline || i != static_cast<std::size_t>(RenderStage::Output);
+			}
+		}
+		if (ranPipeline) {
+			lastPipelineNs = frameNs;
+			pipelineSampleCount++;
+		}
+		if (!slot.countsTotals) {
+			return true;
+		}
+
+		std::lock_guard<std::mutex> lock(timingsMutex);
+		if (!isValid) {
+			timings.disjointFrames++;
+			return true;
+		}
+
+		timings.resolvedFrames++;
+		for (std::size_t i = 0; i < RenderStageCount; i++) {
+			if (slot.used[i]) {
+				timings.stageGpuNs[i] += stageNs[i];
+				timings.stageFrames[i]++;
+			}
+		}
+		return true;
+	}
+
+	std::atomic<bool> enabled{false};
+	std::atomic<bool> resetRequested{false};
+
+	// Owned by the render thread.
+	std::array<Slot, QueryLatency> slots;
+	std::size_t frameIndex = 0;
+	bool frameActive = false;
+	std::uint64_t frameStartNs = 0;
+	std::size_t sampleCountdown = 0;
+	std::array<std::optional<double>, RenderStageCount> recentStageNs{};
+	std::uint64_t pipelineSampleCount = 0;
+	std::uint64_t lastPipelineNs = 0;
+
+	mutable std::mutex timingsMutex;
+	StageTimings timings;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
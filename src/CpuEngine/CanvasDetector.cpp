@@ -0,0 +1,288 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "CanvasDetector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+namespace {
+
+std::uint8_t computeOtsuThreshold(const ConstLumaView &luma)
+{
+	std::array<std::uint32_t, 256> histogram{};
+	for (std::size_t y = 0; y < luma.height; y++) {
+		const std::uint8_t *row = luma.row(y);
+		for (std::size_t x = 0; x < luma.width; x++) {
+			histogram[row[x]]++;
+		}
+	}
+
+	const double total = static_cast<double>(luma.width * luma.height);
+	double sumAll = 0.0;
+	for (int i = 0; i < 256; i++) {
+		sumAll += i * static_cast<double>(histogram[i]);
+	}
+
+	double sumBackground = 0.0;
+	double weightBackground = 0.0;
+	double bestVariance = -1.0;
+	int bestThreshold = 0;
+	for (int t = 0; t < 256; t++) {
+		weightBackground += histogram[t];
+		if (weightBackground == 0.0) {
+			continue;
+		}
+		const double weightForeground = total - weightBackground;
+		if (weightForeground == 0.0) {
+			break;
+		}
+		sumBackground += t * static_cast<double>(histogram[t]);
+		const double meanBackground = sumBackground / weightBackground;
+		const double meanForeground = (sumAll - sumBackground) / weightForeground;
+		const double variance = weightBackground * weightForeground * (meanBackground - meanForeground) *
+					(meanBackground - meanForeground);
+		if (variance > bestVariance) {
+			bestVariance = variance;
+			bestThreshold = t;
+		}
+	}
+	return static_cast<std::uint8_t>(bestThreshold);
+}
+
+float getQuadArea(const std::array<CanvasPoint, 4> &c) noexcept
+{
+	float twiceArea = 0.0f;
+	for (std::size_t i = 0; i < 4; i++) {
+		const CanvasPoint &a = c[i];
+		const CanvasPoint &b = c[(i + 1) % 4];
+		twiceArea += a.x * b.y - b.x * a.y;
+	}
+	return std::abs(twiceArea) * 0.5f;
+}
+
+bool isConvex(const std::array<CanvasPoint, 4> &c) noexcept
+{
+	int sign = 0;
+	for (std::size_t i = 0; i < 4; i++) {
+		const CanvasPoint &a = c[i];
+		const CanvasPoint &b = c[(i + 1) % 4];
+		const CanvasPoint &d = c[(i + 2) % 4];
+		const float cross = (b.x - a.x) * (d.y - b.y) - (b.y - a.y) * (d.x - b.x);
+		const int s = cross > 0.0f ? 1 : cross < 0.0f ? -1 : 0;
+		if (s == 0 || (sign != 0 && s != sign)) {
+			return false;
+		}
+		sign = s;
+	}
+	return true;
+}
+
+/**
+ * @brief Orders corners clockwise on screen, starting from the one closest to the top-left.
+ */
+std::array<CanvasPoint, 4> orderCorners(std::array<CanvasPoint, 4> c) noexcept
+{
+	float cx = 0.0f;
+	float cy = 0.0f;
+	for (const CanvasPoint &p : c) {
+		cx += p.x / 4.0f;
+		cy += p.y / 4.0f;
+	}
+	// With y pointing down, increasing atan2 runs clockwise on screen.
+	std::sort(c.begin(), c.end(), [&](const CanvasPoint &a, const CanvasPoint &b) {
+		return std::atan2(a.y - cy, a.x - cx) < std::atan2(b.y - cy, b.x - cx);
+	});
+	const auto topLeft = std::min_element(c.begin(), c.end(), [](const CanvasPoint &a, const CanvasPoint &b) {
+		return a.x + a.y < b.x + b.y;
+	});
+	std::rotate(c.begin(), topLeft, c.end());
+	return c;
+}
+
+} // namespace
+
+std::optional<Homography> computeUnitSquareToQuad(const CanvasQuad &quad) noexcept
+{
+	const auto &[p0, p1, p2, p3] = quad.corners;
+	const float sx = p0.x - p1.x + p2.x - p3.x;
+	const float sy = p0.y - p1.y + p2.y - p3.y;
+	const float dx1 = p1.x - p2.x;
+	const float dx2 = p3.x - p2.x;
+	const float dy1 = p1.y - p2.y;
+	const float dy2 = p3.y - p2.y;
+	const float den = dx1 * dy2 - dx2 * dy1;
+	if (std::abs(den) < 1e-9f) {
+		return std::nullopt;
+	}
+
+	const float g = (sx * dy2 - dx2 * sy) / den;
+	const float h = (dx1 * sy - sx * dy1) / den;
+	const Homography m{p1.x - p0.x + g * p1.x, p3.x - p0.x + h * p3.x, p0.x,
+			   p1.y - p0.y + g * p1.y, p3.y - p0.y + h * p3.y, p0.y,
+			   g,                      h,                      1.0f};
+
+	const float det = m[0] * (m[4] * m[8] - m[5] * m[7]) - m[1] * (m[3] * m[8] - m[5] * m[6]) +
+			  m[2] * (m[3] * m[7] - m[4] * m[6]);
+	if (std::abs(det) < 1e-9f) {
+		return std::nullopt;
+	}
+	return m;
+}
+
+CanvasPoint applyHomography(const Homography &h, CanvasPoint p) noexcept
+{
+	const float w = h[6] * p.x + h[7] * p.y + h[8];
+	return {(h[0] * p.x + h[1] * p.y + h[2]) / w, (h[3] * p.x + h[4] * p.y + h[5]) / w};
+}
+
+std::optional<CanvasQuad> CanvasDetector::detect(const ConstLumaView &luma)
+{
+	const std::size_t width = luma.width;
+	const std::size_t height = luma.height;
+	if (width < 4 || height < 4) {
+		return std::nullopt;
+	}
+
+	const std::uint8_t threshold = computeOtsuThreshold(luma);
+	visited.assign(width * height, 0);
+
+	// The extreme pixels of the largest component along +-(x + y), +-(x - y), +-x and +-y.
+	std::size_t bestArea = 0;
+	std::array<std::uint32_t, 8> bestExtremes{};
+
+	for (std::size_t seedY = 0; seedY < height; seedY++) {
+		for (std::size_t seedX = 0; seedX < width; seedX++) {
+			const std::size_t seed = seedY * width + seedX;
+			if (visited[seed] || luma.row(seedY)[seedX] <= threshold) {
+				continue;
+			}
+
+			std::size_t area = 0;
+			std::array<std::uint32_t, 8> extremes;
+			extremes.fill(static_cast<std::uint32_t>(seed));
+			std::array<long, 8> extremeScores;
+			extremeScores.fill(std::numeric_limits<long>::min());
+
+			visited[seed] = 1;
+			stack.assign(1, static_cast<std::uint32_t>(seed));
+			while (!stack.empty()) {
+				const std::uint32_t index = stack.back();
+				stack.pop_back();
+				area++;
+
+				const long x = static_cast<long>(index % width);
+				const long y = static_cast<long>(index / width);
+				const std::array<long, 8> scores{x + y, -x - y, x - y, y - x, x, -x, y, -y};
+				for (std::size_t i = 0; i < 8; i++) {
+					if (scores[i] > extremeScores[i]) {
+						extremeScores[i] = scores[i];
+						extremes[i] = index;
+					}
+				}
+
+				const auto visit = [&](std::size_t nx, std::size_t ny) {
+					const std::size_t neighbor = ny * width + nx;
+					if (!visited[neighbor] && luma.row(ny)[nx] > threshold) {
+						visited[neighbor] = 1;
+						stack.push_back(static_cast<std::uint32_t>(neighbor));
+					}
+				};
+				if (x > 0) {
+					visit(static_cast<std::size_t>(x - 1), static_cast<std::size_t>(y));
+				}
+				if (static_cast<std::size_t>(x) + 1 < width) {
+					visit(static_cast<std::size_t>(x + 1), static_cast<std::size_t>(y));
+				}
+				if (y > 0) {
+					visit(static_cast<std::size_t>(x), static_cast<std::size_t>(y - 1));
+				}
+				if (static_cast<std::size_t>(y) + 1 < height) {
+					visit(static_cast<std::size_t>(x), static_cast<std::size_t>(y + 1));
+				}
+			}
+
+			if (area > bestArea) {
+				bestArea = area;
+				bestExtremes = extremes;
+			}
+		}
+	}
+
+	if (bestArea == 0) {
+		return std::nullopt;
+	}
+
+	const auto toPoint = [&](std::uint32_t index) {
+		return CanvasPoint{(static_cast<float>(index % width) + 0.5f) / static_cast<float>(width),
+				   (static_cast<float>(index / width) + 0.5f) / static_cast<float>(height)};
+	};
+	// Top-left, top-right, bottom-right and bottom-left from the diagonals; top, right, bottom, left from the axes.
+	const std::array<CanvasPoint, 4> diagonal{toPoint(bestExtremes[1]), toPoint(bestExtremes[2]),
+						  toPoint(bestExtremes[0]), toPoint(bestExtremes[3])};
+	const std::array<CanvasPoint, 4> axial{toPoint(bestExtremes[7]), toPoint(bestExtremes[4]),
+					       toPoint(bestExtremes[6]), toPoint(bestExtremes[5])};
+	const std::array<CanvasPoint, 4> diagonalCorners = orderCorners(diagonal);
+	const std::array<CanvasPoint, 4> axialCorners = orderCorners(axial);
+	const std::array<CanvasPoint, 4> &corners =
+		getQuadArea(diagonalCorners) >= getQuadArea(axialCorners) ? diagonalCorners : axialCorners;
+
+	const float quadArea = getQuadArea(corners);
+	const float componentArea = static_cast<float>(bestArea) / static_cast<float>(width * height);
+	if (!isConvex(corners) || quadArea < MinAreaRatio || componentArea < MinFillRatio * quadArea) {
+		return std::nullopt;
+	}
+	return CanvasQuad{corners};
+}
+
+void CanvasTracker::update(const std::optional<CanvasQuad> &detected) noexcept
+{
+	if (!detected) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (quad) {
+		bool moved = false;
+		for (std::size_t i = 0; i < 4; i++) {
+			const float dx = detected->corners[i].x - quad->corners[i].x;
+			const float dy = detected->corners[i].y - quad->corners[i].y;
+			moved = moved || std::abs(dx) > MinCornerShift || std::abs(dy) > MinCornerShift;
+		}
+		if (!moved) {
+			return;
+		}
+	}
+	quad = detected;
+}
+
+std::optional<CanvasQuad> CanvasTracker::get() const noexcept
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return quad;
+}
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
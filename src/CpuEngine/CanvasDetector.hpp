@@ -0,0 +1,105 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "../CpuKernels/CpuKernels.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+struct CanvasPoint {
+	float x;
+	float y;
+};
+
+/**
+ * @brief A quadrilateral in normalized image coordinates, ordered top-left, top-right, bottom-right, bottom-left.
+ */
+struct CanvasQuad {
+	std::array<CanvasPoint, 4> corners;
+
+	static CanvasQuad fullImage() noexcept { return {{{{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}}}}; }
+};
+
+/**
+ * @brief A row-major 3x3 projective transform of (x, y, 1).
+ */
+using Homography = std::array<float, 9>;
+
+/**
+ * @brief Gets the homography that maps (0, 0), (1, 0), (1, 1) and (0, 1) to the corners of the quad, in order.
+ * @return std::nullopt if three of the corners are collinear.
+ */
+std::optional<Homography> computeUnitSquareToQuad(const CanvasQuad &quad) noexcept;
+
+/**
+ * @brief Applies a homography to a point.
+ */
+CanvasPoint applyHomography(const Homography &h, CanvasPoint p) noexcept;
+
+/**
+ * @class CanvasDetector
+ * @brief Finds a sheet of paper in a low-resolution luma image.
+ *
+ * The image is binarized with Otsu's threshold and the largest bright 4-connected component is taken as the
+ * paper. Its corners are the extreme points along either the diagonals or the axes, whichever spans the larger
+ * area, so both straight and strongly rotated sheets are found. The result is rejected if it covers less than
+ * a tenth of the image or if the component fills too little of the quad to be a sheet.
+ * Keeps scratch buffers between calls; use one detector per thread.
+ */
+class CanvasDetector {
+public:
+	static constexpr float MinAreaRatio = 0.1f;
+	static constexpr float MinFillRatio = 0.8f;
+
+	std::optional<CanvasQuad> detect(const CpuKernels::ConstLumaView &luma);
+
+private:
+	std::vector<std::uint8_t> visited;
+	std::vector<std::uint32_t> stack;
+};
+
+/**
+ * @class CanvasTracker
+ * @brief Holds the latest canvas quad shared between the detection worker and the render thread.
+ *
+ * Detections that move no corner by more than MinCornerShift are ignored so that the warp stays still while
+ * the paper does. A failed detection, e.g. while a hand covers the sheet, keeps the previous quad.
+ */
+class CanvasTracker {
+public:
+	static constexpr float MinCornerShift = 0.01f;
+
+	void update(const std::optional<CanvasQuad> &detected) noexcept;
+
+	std::optional<CanvasQuad> get() const noexcept;
+
+private:
+	mutable std::mutex mutex;
+	std::optional<CanvasQuad> quad;
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
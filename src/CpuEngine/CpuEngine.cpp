@@ -0,0 +1,271 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "CpuEngine.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+namespace {
+
+std::size_t chooseBandCount(std::size_t height, const BridgeUtils::WorkStealingThreadPool *threadPool) noexcept
+{
+	if (!threadPool || threadPool->getThreadCount() == 1) {
+		return 1;
+	}
+	const std::size_t bands = threadPool->getThreadCount() * CpuEngine::BandsPerThread;
+	return std::clamp<std::size_t>(height / CpuEngine::MinBandRows, 1, bands);
+}
+
+} // namespace
+
+CpuEngine::CpuEngine(std::size_t _width, std::size_t _height, const KernelSet &_kernels,
+		     BridgeUtils::WorkStealingThreadPool *_threadPool)
+	: width(_width),
+	  height(_height),
+	  kernels(_kernels),
+	  threadPool(_threadPool),
+	  bandCount(chooseBandCount(_height, _threadPool)),
+	  grayscale(_width, _height),
+	  medianFiltered(_width, _height),
+	  motionMap(_width, _height),
+	  motionAdaptiveGrayscales{LumaImage(_width, _height), LumaImage(_width, _height)},
+	  finalSobelMagnitude(_width, _height),
+	  lineBuffers(bandCount, LineBuffers(_width))
+{
+	if (width == 0 || height == 0) {
+		throw std::invalid_argument("CpuEngine requires a non-empty frame");
+	}
+}
+
+CpuEngine::LineBuffers::LineBuffers(std::size_t width)
+	: source(width),
+	  horizontalMedian(width),
+	  median(width),
+	  motionSums(width),
+	  motion(width),
+	  filtered(width),
+	  sobelMagnitude(width)
+{
+}
+
+void CpuEngine::reset() noexcept
+{
+	for (LumaImage &image : motionAdaptiveGrayscales) {
+		std::fill(image.pixels.begin(), image.pixels.end(), std::uint8_t{0});
+	}
+	std::fill(motionMap.pixels.begin(), motionMap.pixels.end(), std::uint8_t{0});
+}
+
+void CpuEngine::updateTables(const PresetSnapshot &snapshot)
+{
+	if (snapshot.epoch == tablesEpoch) {
+		return;
+	}
+	const PresetConstants &constants = snapshot.constants;
+	motionAdaptiveTable = MotionAdaptiveTable::create(constants.motionAdaptiveFilteringStrength,
+							  constants.motionAdaptiveFilteringMotionThreshold);
+	finalizeTable = FinalizeTable::create(constants.sobelUseLog, constants.sobelScalingFactor);
+	tablesEpoch = snapshot.epoch;
+}
+
+void CpuEngine::forEachBand(const std::function<void(std::size_t, std::size_t, std::size_t)> &body)
+{
+	if (bandCount == 1) {
+		body(0, height, 0);
+		return;
+	}
+	threadPool->parallelFor(bandCount, [&](std::size_t band) {
+		body(band * height / bandCount, (band + 1) * height / bandCount, band);
+	});
+}
+
+ConstLumaView CpuEngine::processBgra(const ImageView<const std::uint8_t> &bgra, const PresetSnapshot &snapshot)
+{
+	const Preset &preset = snapshot.preset;
+	const bool hasFilters = preset.medianFilterEnabled || preset.motionAdaptiveFilteringStrength > 0.0;
+	if (preset.extractionMode == ExtractionMode::Passthrough ||
+	    (preset.extractionMode == ExtractionMode::ConvertToGrayscale && !hasFilters)) {
+		forEachBand([&](std::size_t rowBegin, std::size_t rowEnd, std::size_t) {
+			convertBgraToLuma(kernels, bgra.rows(rowBegin, rowEnd), grayscale.view().rows(rowBegin, rowEnd));
+		});
+		return grayscale.view();
+	}
+
+	Stream stream{};
+	stream.bgra = bgra;
+	return process(stream, snapshot);
+}
+
+ConstLumaView CpuEngine::processLuma(const ConstLumaView &luma, const PresetSnapshot &snapshot)
+{
+	if (luma.width != width || luma.height != height) {
+		throw std::invalid_argument("Frame size does not match the CpuEngine");
+	}
+
+	Stream stream{};
+	stream.luma = luma;
+	return process(stream, snapshot);
+}
+
+ConstLumaView CpuEngine::process(Stream stream, const PresetSnapshot &snapshot)
+{
+	const Preset &preset = snapshot.preset;
+	stream.extractionMode = preset.extractionMode == ExtractionMode::Default ? ExtractionMode::SobelMagnitude
+										 : preset.extractionMode;
+	stream.medianFilterEnabled = preset.medianFilterEnabled;
+	stream.motionAdaptiveFilteringEnabled = preset.motionAdaptiveFilteringStrength > 0.0;
+	if (stream.extractionMode <= ExtractionMode::Passthrough) {
+		return stream.luma;
+	}
+
+	switch (stream.extractionMode) {
+	case ExtractionMode::ConvertToGrayscale:
+		// With the motion-adaptive filter, the output is its new state, chosen below.
+		if (stream.motionAdaptiveFilteringEnabled) {
+			break;
+		} else if (stream.medianFilterEnabled) {
+			stream.output = medianFiltered.view();
+		} else if (stream.bgra.data) {
+			stream.output = grayscale.view();
+		} else {
+			return stream.luma;
+		}
+		break;
+	case ExtractionMode::MotionMapCalculation:
+		// Without the motion-adaptive filter no motion map is made, and the last one is shown as is.
+		if (!stream.motionAdaptiveFilteringEnabled) {
+			return motionMap.view();
+		}
+		stream.output = motionMap.view();
+		break;
+	default:
+		stream.output = finalSobelMagnitude.view();
+		break;
+	}
+
+	updateTables(snapshot);
+
+	if (stream.motionAdaptiveFilteringEnabled) {
+		std::swap(motionAdaptiveGrayscales[0], motionAdaptiveGrayscales[1]);
+		stream.previous = motionAdaptiveGrayscales[1].view();
+		stream.filtered = motionAdaptiveGrayscales[0].view();
+		if (stream.extractionMode == ExtractionMode::ConvertToGrayscale) {
+			stream.output = stream.filtered;
+		}
+	}
+
+	forEachBand([&](std::size_t rowBegin, std::size_t rowEnd, std::size_t band) {
+		streamBand(stream, lineBuffers[band], rowBegin, rowEnd);
+	});
+	return stream.output;
+}
+
+void CpuEngine::streamBand(const Stream &stream, LineBuffers &lines, std::size_t rowBegin, std::size_t rowEnd)
+{
+	const KernelSet &k = kernels;
+	const std::size_t w = width;
+	const auto above = [](std::size_t y) { return y == 0 ? y : y - 1; };
+	const auto below = [this](std::size_t y) { return std::min(y + 1, height - 1); };
+
+	lines.source.invalidate();
+	lines.horizontalMedian.invalidate();
+	lines.median.invalidate();
+	lines.motionSums.invalidate();
+	lines.motion.invalidate();
+	lines.filtered.invalidate();
+
+	// Each stage pulls the rows it needs from the stage before, so a row is produced just before it is consumed.
+	const auto sourceRow = [&](std::size_t y) {
+		if (!stream.bgra.data) {
+			return stream.luma.row(y);
+		}
+		return lines.source.get(y, [&](std::size_t i, std::uint8_t *row) {
+			k.bgraToLuma(stream.bgra.row(i), row, w);
+		});
+	};
+	const auto medianRow = [&](std::size_t y) {
+		if (!stream.medianFilterEnabled) {
+			return sourceRow(y);
+		}
+		return lines.median.get(y, [&](std::size_t i, std::uint8_t *row) {
+			const auto horizontal = [&](std::size_t j) {
+				return lines.horizontalMedian.get(j, [&](std::size_t, std::uint8_t *dst) {
+					horizontalMedian3Row(k, sourceRow(j), dst, w);
+				});
+			};
+			const std::uint8_t *row0 = horizontal(above(i));
+			const std::uint8_t *row1 = horizontal(i);
+			const std::uint8_t *row2 = horizontal(below(i));
+			k.median3(row0, row1, row2, row, w);
+		});
+	};
+	const auto motionRow = [&](std::size_t y) {
+		return lines.motion.get(y, [&](std::size_t i, std::uint8_t *row) {
+			const auto sums = [&](std::size_t j) {
+				return lines.motionSums.get(j, [&](std::size_t, std::uint16_t *dst) {
+					horizontalMotionRow(k, medianRow(j), stream.previous.row(j), dst, w);
+				});
+			};
+			const std::uint16_t *row0 = sums(above(i));
+			const std::uint16_t *row1 = sums(i);
+			const std::uint16_t *row2 = sums(below(i));
+			k.average9(row0, row1, row2, row, w);
+		});
+	};
+	const auto filteredRow = [&](std::size_t y) {
+		if (!stream.motionAdaptiveFilteringEnabled) {
+			return medianRow(y);
+		}
+		return lines.filtered.get(y, [&](std::size_t i, std::uint8_t *row) {
+			const std::uint8_t *motion = motionRow(i);
+			const std::uint8_t *current = medianRow(i);
+			k.motionAdaptiveBlend(current, stream.previous.row(i), motion, row, w, motionAdaptiveTable);
+		});
+	};
+
+	for (std::size_t y = rowBegin; y < rowEnd; y++) {
+		// The filtered rows are the state of the next frame whatever is shown.
+		if (stream.motionAdaptiveFilteringEnabled) {
+			std::copy_n(filteredRow(y), w, stream.filtered.row(y));
+		}
+
+		if (stream.extractionMode == ExtractionMode::ConvertToGrayscale) {
+			if (!stream.motionAdaptiveFilteringEnabled) {
+				std::copy_n(filteredRow(y), w, stream.output.row(y));
+			}
+		} else if (stream.extractionMode == ExtractionMode::MotionMapCalculation) {
+			std::copy_n(motionRow(y), w, stream.output.row(y));
+		} else {
+			const std::uint8_t *row0 = filteredRow(above(y));
+			const std::uint8_t *row1 = filteredRow(y);
+			const std::uint8_t *row2 = filteredRow(below(y));
+			sobelMagnitudeRow(k, row0, row1, row2, lines.sobelMagnitude.data(), w);
+			applyTableRow(lines.sobelMagnitude.data(), stream.output.row(y), w, finalizeTable.values);
+		}
+	}
+}
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
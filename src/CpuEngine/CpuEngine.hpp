@@ -0,0 +1,156 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "../BridgeUtils/WorkStealingThreadPool.hpp"
+#include "../Core/Preset.hpp"
+#include "../CpuKernels/CpuKernels.hpp"
+
+#include "RollingRows.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @class CpuEngine
+ * @brief Runs the preset-driven pipeline of RenderingContext::videoRender on the CPU.
+ *
+ * Stages run in the same order and are enabled by the same preset fields as on the GPU, so results match
+ * the filter within the tolerances documented in CpuKernels.hpp. The engine keeps the previous
+ * motion-adaptive output between frames, exactly as RenderingContext keeps r8MotionAdaptiveGrayscales.
+ *
+ * Stages are not run one after another over whole frames. Each input row is streamed through every stage while
+ * it is still in cache: every stage keeps its last three rows in a RollingRows line buffer, and only the output
+ * plane and the motion-adaptive state are written to memory. The result is identical to composing the frame
+ * operations of CpuKernels stage by stage.
+ *
+ * Given a thread pool, the frame is split into row bands that are streamed in parallel, each recomputing the few
+ * rows around it as the halo of the 3x3 kernels. Not thread-safe; use one engine per stream. A pool may be shared.
+ */
+class CpuEngine {
+public:
+	const std::size_t width;
+	const std::size_t height;
+
+	// Bands shorter than this spend more on the halo and the scheduling than they gain from parallelism.
+	static constexpr std::size_t MinBandRows = 32;
+	// More bands than threads, so that a thread that falls behind has its work stolen.
+	static constexpr std::size_t BandsPerThread = 4;
+
+	/**
+	 * @param threadPool Runs the bands of each stage, or nullptr to process on the calling thread only.
+	 * Must outlive the engine.
+	 */
+	CpuEngine(std::size_t width, std::size_t height,
+		  const CpuKernels::KernelSet &kernels = CpuKernels::getKernels(),
+		  BridgeUtils::WorkStealingThreadPool *threadPool = nullptr);
+
+	CpuEngine(const CpuEngine &) = delete;
+	CpuEngine &operator=(const CpuEngine &) = delete;
+	CpuEngine(CpuEngine &&) = delete;
+	CpuEngine &operator=(CpuEngine &&) = delete;
+
+	/**
+	 * @brief Processes a BGRA frame, starting from ConvertGrayscale as the filter does.
+	 * @param bgra Addressed in bytes per row; its width and height must match those of the engine.
+	 * @return The plane selected by the extraction mode, valid until the next call.
+	 */
+	CpuKernels::ConstLumaView processBgra(const CpuKernels::ImageView<const std::uint8_t> &bgra,
+					      const PresetSnapshot &snapshot);
+
+	/**
+	 * @brief Processes a frame that is already a luma plane, such as the Y plane of a video file.
+	 * @return The plane selected by the extraction mode, valid until the next call. Passthrough returns the input.
+	 */
+	CpuKernels::ConstLumaView processLuma(const CpuKernels::ConstLumaView &luma, const PresetSnapshot &snapshot);
+
+	/**
+	 * @brief Forgets the previous frame, as after a seek. The next frame is blended with black,
+	 * as the first frame after the filter's textures are created.
+	 */
+	void reset() noexcept;
+
+	std::size_t getBandCount() const noexcept { return bandCount; }
+
+private:
+	// The tables only depend on the preset, so they are rebuilt when a snapshot of another epoch arrives.
+	void updateTables(const PresetSnapshot &snapshot);
+
+	/**
+	 * @brief What one frame streams through and where its rows go.
+	 */
+	struct Stream {
+		ExtractionMode extractionMode;
+		bool medianFilterEnabled;
+		bool motionAdaptiveFilteringEnabled;
+		// The input is converted from bgra when its data is set, and read from luma otherwise.
+		CpuKernels::ConstLumaView luma;
+		CpuKernels::ImageView<const std::uint8_t> bgra;
+		CpuKernels::ConstLumaView previous;
+		CpuKernels::LumaView filtered;
+		CpuKernels::LumaView output;
+	};
+
+	/**
+	 * @brief The line buffers of one band, so that bands can be streamed concurrently.
+	 */
+	struct LineBuffers {
+		RollingRows<std::uint8_t> source;
+		RollingRows<std::uint8_t> horizontalMedian;
+		RollingRows<std::uint8_t> median;
+		RollingRows<std::uint16_t> motionSums;
+		RollingRows<std::uint8_t> motion;
+		RollingRows<std::uint8_t> filtered;
+		std::vector<std::uint8_t> sobelMagnitude;
+
+		explicit LineBuffers(std::size_t width);
+	};
+
+	// Runs body(rowBegin, rowEnd, band) for every band and returns when all of them are done.
+	void forEachBand(const std::function<void(std::size_t, std::size_t, std::size_t)> &body);
+
+	CpuKernels::ConstLumaView process(Stream stream, const PresetSnapshot &snapshot);
+
+	void streamBand(const Stream &stream, LineBuffers &lines, std::size_t rowBegin, std::size_t rowEnd);
+
+	const CpuKernels::KernelSet &kernels;
+	BridgeUtils::WorkStealingThreadPool *const threadPool;
+	const std::size_t bandCount;
+
+	CpuKernels::LumaImage grayscale;
+	CpuKernels::LumaImage medianFiltered;
+	CpuKernels::LumaImage motionMap;
+	CpuKernels::LumaImage motionAdaptiveGrayscales[2];
+	CpuKernels::LumaImage finalSobelMagnitude;
+	std::vector<LineBuffers> lineBuffers;
+
+	// The epoch of the snapshot the tables were built from, or nullopt before the first.
+	std::optional<std::uint64_t> tablesEpoch;
+	CpuKernels::MotionAdaptiveTable motionAdaptiveTable{};
+	CpuKernels::FinalizeTable finalizeTable{};
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
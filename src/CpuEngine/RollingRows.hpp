@@ -0,0 +1,70 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @brief A line buffer that holds the last three rows produced by one stage of a streaming pipeline.
+ *
+ * Row y lives in slot y % 3, so any three consecutive rows are resident together, which is exactly the window
+ * a 3x3 kernel reads. Consumers must request rows in non-decreasing windows; a row is produced on first request
+ * and then served from the buffer until a row three further down replaces it.
+ */
+template<typename T> class RollingRows {
+public:
+	static constexpr std::size_t Depth = 3;
+
+	RollingRows() = default;
+	explicit RollingRows(std::size_t _width) : width(_width), pixels(_width * Depth) { invalidate(); }
+
+	/**
+	 * @brief Forgets every row, as at the start of a band.
+	 */
+	void invalidate() noexcept { keys.fill(std::numeric_limits<std::size_t>::max()); }
+
+	/**
+	 * @param produce Called as produce(y, row) to fill row y if it is not resident.
+	 * @return Row y, valid until row y + 3 is requested.
+	 */
+	template<typename Producer> const T *get(std::size_t y, Producer &&produce)
+	{
+		const std::size_t slot = y % Depth;
+		T *row = pixels.data() + slot * width;
+		if (keys[slot] != y) {
+			produce(y, row);
+			keys[slot] = y;
+		}
+		return row;
+	}
+
+private:
+	std::size_t width = 0;
+	std::vector<T> pixels;
+	std::array<std::size_t, Depth> keys{};
+};
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
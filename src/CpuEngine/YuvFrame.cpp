@@ -0,0 +1,166 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "YuvFrame.hpp"
+
+#include <cstring>
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+namespace {
+
+struct LumaSampling {
+	std::size_t offset;
+	std::size_t pixelStride;
+};
+
+bool isPlanar8(YuvFormat format) noexcept
+{
+	return format == YuvFormat::I420 || format == YuvFormat::NV12 || format == YuvFormat::I422 ||
+	       format == YuvFormat::I444 || format == YuvFormat::Y800;
+}
+
+// The luma byte of each pixel in plane 0; 16-bit formats are little-endian, so the high byte comes second.
+LumaSampling getLumaSampling(YuvFormat format) noexcept
+{
+	switch (format) {
+	case YuvFormat::YUY2:
+	case YuvFormat::YVYU:
+		return {0, 2};
+	case YuvFormat::UYVY:
+	case YuvFormat::P010:
+	case YuvFormat::P216:
+	case YuvFormat::P416:
+		return {1, 2};
+	default:
+		return {0, 1};
+	}
+}
+
+void fillRows(std::uint8_t *plane, std::size_t linesize, std::size_t rowBytes, std::size_t rows,
+	      std::uint8_t value) noexcept
+{
+	for (std::size_t y = 0; y < rows; y++) {
+		std::memset(plane + y * linesize, value, rowBytes);
+	}
+}
+
+void fill16Rows(std::uint8_t *plane, std::size_t linesize, std::size_t samples, std::size_t rows,
+		std::uint16_t value) noexcept
+{
+	const std::uint8_t bytes[2] = {static_cast<std::uint8_t>(value & 0xFF), static_cast<std::uint8_t>(value >> 8)};
+	for (std::size_t y = 0; y < rows; y++) {
+		std::uint8_t *row = plane + y * linesize;
+		for (std::size_t x = 0; x < samples; x++) {
+			row[2 * x] = bytes[0];
+			row[2 * x + 1] = bytes[1];
+		}
+	}
+}
+
+void writeNeutralChroma(const YuvFrameView &frame) noexcept
+{
+	const std::size_t halfWidth = (frame.width + 1) / 2;
+	const std::size_t halfHeight = (frame.height + 1) / 2;
+
+	switch (frame.format) {
+	case YuvFormat::I420:
+		fillRows(frame.planes[1], frame.linesizes[1], halfWidth, halfHeight, 128);
+		fillRows(frame.planes[2], frame.linesizes[2], halfWidth, halfHeight, 128);
+		break;
+	case YuvFormat::NV12:
+		fillRows(frame.planes[1], frame.linesizes[1], halfWidth * 2, halfHeight, 128);
+		break;
+	case YuvFormat::I422:
+		fillRows(frame.planes[1], frame.linesizes[1], halfWidth, frame.height, 128);
+		fillRows(frame.planes[2], frame.linesizes[2], halfWidth, frame.height, 128);
+		break;
+	case YuvFormat::I444:
+		fillRows(frame.planes[1], frame.linesizes[1], frame.width, frame.height, 128);
+		fillRows(frame.planes[2], frame.linesizes[2], frame.width, frame.height, 128);
+		break;
+	case YuvFormat::P010:
+		fill16Rows(frame.planes[1], frame.linesizes[1], halfWidth * 2, halfHeight, 0x8000);
+		break;
+	case YuvFormat::P216:
+		fill16Rows(frame.planes[1], frame.linesizes[1], halfWidth * 2, frame.height, 0x8000);
+		break;
+	case YuvFormat::P416:
+		fill16Rows(frame.planes[1], frame.linesizes[1], frame.width * 2, frame.height, 0x8000);
+		break;
+	default:
+		// Y800 has no chroma, and packed formats set theirs along with the luma.
+		break;
+	}
+}
+
+} // namespace
+
+ConstLumaView extractLuma(const YuvFrameView &frame, LumaImage &scratch)
+{
+	if (isPlanar8(frame.format)) {
+		return {frame.planes[0], frame.width, frame.height, frame.linesizes[0]};
+	}
+
+	if (scratch.width != frame.width || scratch.height != frame.height) {
+		scratch = LumaImage(frame.width, frame.height);
+	}
+	const LumaSampling sampling = getLumaSampling(frame.format);
+	for (std::size_t y = 0; y < frame.height; y++) {
+		const std::uint8_t *src = frame.planes[0] + y * frame.linesizes[0] + sampling.offset;
+		std::uint8_t *dst = scratch.pixels.data() + y * frame.width;
+		for (std::size_t x = 0; x < frame.width; x++) {
+			dst[x] = src[x * sampling.pixelStride];
+		}
+	}
+	return scratch.view();
+}
+
+void writeLumaWithNeutralChroma(const YuvFrameView &frame, const ConstLumaView &luma)
+{
+	if (isPlanar8(frame.format)) {
+		for (std::size_t y = 0; y < frame.height; y++) {
+			std::uint8_t *dst = frame.planes[0] + y * frame.linesizes[0];
+			if (dst != luma.row(y)) {
+				std::memcpy(dst, luma.row(y), frame.width);
+			}
+		}
+		writeNeutralChroma(frame);
+		return;
+	}
+
+	const bool isPacked = frame.format == YuvFormat::YUY2 || frame.format == YuvFormat::YVYU ||
+			      frame.format == YuvFormat::UYVY;
+	const LumaSampling sampling = getLumaSampling(frame.format);
+	for (std::size_t y = 0; y < frame.height; y++) {
+		std::uint8_t *dst = frame.planes[0] + y * frame.linesizes[0];
+		const std::uint8_t *src = luma.row(y);
+		for (std::size_t x = 0; x < frame.width; x++) {
+			// Packed chroma is interleaved with the luma; 16-bit samples repeat the byte to span the range.
+			dst[x * 2 + sampling.offset] = src[x];
+			dst[x * 2 + 1 - sampling.offset] = isPacked ? 128 : src[x];
+		}
+	}
+	writeNeutralChroma(frame);
+}
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
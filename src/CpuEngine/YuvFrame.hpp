@@ -0,0 +1,77 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "../CpuKernels/CpuKernels.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+
+/**
+ * @brief The native camera formats whose luma the CPU engine reads and writes in place.
+ */
+enum class YuvFormat {
+	// 8-bit planar and semi-planar: the Y plane is a luma plane as is.
+	I420,
+	NV12,
+	I422,
+	I444,
+	Y800,
+	// 8-bit packed 4:2:2.
+	YUY2,
+	YVYU,
+	UYVY,
+	// 16-bit little-endian semi-planar with the value in the high bits, which covers 10-bit P010.
+	P010,
+	P216,
+	P416,
+};
+
+/**
+ * @brief A mutable view of a YUV frame laid out as libobs lays out obs_source_frame.
+ */
+struct YuvFrameView {
+	YuvFormat format;
+	std::array<std::uint8_t *, 3> planes;
+	std::array<std::size_t, 3> linesizes;
+	std::size_t width;
+	std::size_t height;
+};
+
+/**
+ * @brief Gets the 8-bit luma of a frame.
+ *
+ * 8-bit planar formats are viewed in place; packed and 16-bit formats are unpacked into scratch, keeping the high
+ * byte of 16-bit samples.
+ * @return A view of the Y plane or of scratch, valid while both are.
+ */
+CpuKernels::ConstLumaView extractLuma(const YuvFrameView &frame, CpuKernels::LumaImage &scratch);
+
+/**
+ * @brief Writes an 8-bit luma plane into the frame and sets the chroma to neutral gray.
+ * @param luma Must match the size of the frame. May be the view returned by extractLuma.
+ */
+void writeLumaWithNeutralChroma(const YuvFrameView &frame, const CpuKernels::ConstLumaView &luma);
+
+} // namespace ShowDraw
+} // namespace KaitoTokyo
@@ -0,0 +1,343 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "CpuKernels.hpp"
+#include "CpuKernelsDetail.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if SHOWDRAW_CPU_KERNELS_X86 && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels::CpuKernelsDetail;
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace CpuKernels {
+
+namespace {
+
+#if SHOWDRAW_CPU_KERNELS_X86
+
+#if defined(_MSC_VER) && !defined(__clang__)
+
+bool isSse41Supported() noexcept
+{
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 19)) != 0;
+}
+
+bool isAvx2Supported() noexcept
+{
+	int info[4];
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+}
+
+#else
+
+bool isSse41Supported() noexcept
+{
+	return __builtin_cpu_supports("sse4.1");
+}
+
+bool isAvx2Supported() noexcept
+{
+	// libgcc and compiler-rt also check that the OS saves the YMM registers.
+	return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+#endif
+
+float smoothstep(float edge0, float edge1, float x) noexcept
+{
+	if (edge1 <= edge0) {
+		return x >= edge1 ? 1.0f : 0.0f;
+	}
+	const float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+	return t * t * (3.0f - 2.0f * t);
+}
+
+const KernelSet &selectBestKernels() noexcept
+{
+	for (KernelIsa isa : {KernelIsa::Avx2, KernelIsa::Sse41, KernelIsa::Neon}) {
+		if (const KernelSet *kernels = getKernels(isa)) {
+			return *kernels;
+		}
+	}
+	return getScalarKernels();
+}
+
+} // namespace
+
+MotionAdaptiveTable MotionAdaptiveTable::create(float strength, float motionThreshold) noexcept
+{
+	MotionAdaptiveTable table{};
+	for (int m = 0; m < 256; m++) {
+		const float blend = strength * smoothstep(0.0f, motionThreshold, static_cast<float>(m) / 255.0f);
+		const long q15 = std::lround(std::clamp(blend, 0.0f, 1.0f) * 32768.0f);
+		table.blendQ15[m] = static_cast<std::int16_t>(std::min(q15, 32767L));
+	}
+	return table;
+}
+
+FinalizeTable FinalizeTable::create(bool useLog, float scalingFactor) noexcept
+{
+	FinalizeTable table{};
+	for (int v = 0; v < 256; v++) {
+		float magnitude = static_cast<float>(v) / 255.0f;
+		if (useLog) {
+			magnitude = std::log2(1.0f + magnitude);
+		}
+		magnitude = std::clamp(magnitude * scalingFactor, 0.0f, 1.0f);
+		table.values[v] = static_cast<std::uint8_t>(std::lround(magnitude * 255.0f));
+	}
+	return table;
+}
+
+const KernelSet &getKernels() noexcept
+{
+	static const KernelSet &kernels = selectBestKernels();
+	return kernels;
+}
+
+const KernelSet *getKernels(KernelIsa isa) noexcept
+{
+	switch (isa) {
+	case KernelIsa::Scalar:
+		return &getScalarKernels();
+#if SHOWDRAW_CPU_KERNELS_X86
+	case KernelIsa::Sse41:
+		return isSse41Supported() ? getSse41Kernels() : nullptr;
+	case KernelIsa::Avx2:
+		return isAvx2Supported() ? getAvx2Kernels() : nullptr;
+#endif
+	case KernelIsa::Neon:
+		// Advanced SIMD is mandatory on AArch64.
+		return getNeonKernels();
+	default:
+		return nullptr;
+	}
+}
+
+void convertBgraToLumaRow(const KernelSet &k, const std::uint8_t *bgra, std::uint8_t *dst, std::size_t width)
+{
+	k.bgraToLuma(bgra, dst, width);
+}
+
+namespace {
+
+using ElementwiseKernel = void (*)(const std::uint8_t *, const std::uint8_t *, const std::uint8_t *,
+				   std::uint8_t *, std::size_t);
+
+template<typename PixelOp>
+void horizontal3Row(ElementwiseKernel kernel, PixelOp op, const std::uint8_t *src, std::uint8_t *dst,
+		    std::size_t width)
+{
+	if (width == 1) {
+		dst[0] = op(src[0], src[0], src[0]);
+		return;
+	}
+	dst[0] = op(src[0], src[0], src[1]);
+	if (width > 2) {
+		kernel(src, src + 1, src + 2, dst + 1, width - 2);
+	}
+	dst[width - 1] = op(src[width - 2], src[width - 1], src[width - 1]);
+}
+
+template<typename RowOp>
+void separable3x3(const KernelSet &k, ElementwiseKernel vertical, RowOp horizontalRow, const ConstLumaView &src,
+		  const LumaView &dst, std::size_t rowBegin, std::size_t rowEnd)
+{
+	// The horizontal pass covers the halo rows above and below the band, clamped as the vertical pass expects.
+	LumaImage intermediate(src.width, rowEnd - rowBegin + 2);
+	const LumaView mid = intermediate.view();
+	for (std::size_t i = 0; i < mid.height; i++) {
+		const auto iy = static_cast<std::ptrdiff_t>(rowBegin + i) - 1;
+		horizontalRow(k, src.clampedRow(iy), mid.row(i), src.width);
+	}
+	for (std::size_t y = rowBegin; y < rowEnd; y++) {
+		const std::size_t i = y - rowBegin;
+		vertical(mid.row(i), mid.row(i + 1), mid.row(i + 2), dst.row(y), src.width);
+	}
+}
+
+} // namespace
+
+void horizontalMedian3Row(const KernelSet &k, const std::uint8_t *src, std::uint8_t *dst, std::size_t width)
+{
+	horizontal3Row(k.median3, median3Pixel, src, dst, width);
+}
+
+void horizontalErosion3Row(const KernelSet &k, const std::uint8_t *src, std::uint8_t *dst, std::size_t width)
+{
+	horizontal3Row(k.min3, min3Pixel, src, dst, width);
+}
+
+void horizontalDilation3Row(const KernelSet &k, const std::uint8_t *src, std::uint8_t *dst, std::size_t width)
+{
+	horizontal3Row(k.max3, max3Pixel, src, dst, width);
+}
+
+void horizontalMotionRow(const KernelSet &k, const std::uint8_t *current, const std::uint8_t *previous,
+			 std::uint16_t *dst, std::size_t width)
+{
+	const int first = absDiff(current[0], previous[0]);
+	if (width == 1) {
+		dst[0] = static_cast<std::uint16_t>(first * 3);
+		return;
+	}
+	const int last = absDiff(current[width - 1], previous[width - 1]);
+	dst[0] = static_cast<std::uint16_t>(first * 2 + absDiff(current[1], previous[1]));
+	if (width > 2) {
+		k.absDiffSum3(current, previous, dst + 1, width - 2);
+	}
+	dst[width - 1] = static_cast<std::uint16_t>(absDiff(current[width - 2], previous[width - 2]) + last * 2);
+}
+
+void sobelMagnitudeRow(const KernelSet &k, const std::uint8_t *row0, const std::uint8_t *row1,
+		       const std::uint8_t *row2, std::uint8_t *dst, std::size_t width)
+{
+	const std::size_t last = width - 1;
+	dst[0] = sobelPixel(row0, row1, row2, 0, 0, std::min<std::size_t>(1, last));
+	if (width > 2) {
+		k.sobelMagnitude(row0, row1, row2, dst + 1, width - 2);
+	}
+	if (width > 1) {
+		dst[last] = sobelPixel(row0, row1, row2, last - 1, last, last);
+	}
+}
+
+void applyTableRow(const std::uint8_t *src, std::uint8_t *dst, std::size_t width,
+		   const std::array<std::uint8_t, 256> &table)
+{
+	for (std::size_t i = 0; i < width; i++) {
+		dst[i] = table[src[i]];
+	}
+}
+
+void convertBgraToLuma(const KernelSet &k, const ImageView<const std::uint8_t> &bgra, const LumaView &dst)
+{
+	for (std::size_t y = 0; y < dst.height; y++) {
+		k.bgraToLuma(bgra.row(y), dst.row(y), dst.width);
+	}
+}
+
+void applyMedian3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst)
+{
+	applyMedian3x3(k, src, dst, 0, src.height);
+}
+
+void applyMedian3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst, std::size_t rowBegin,
+		    std::size_t rowEnd)
+{
+	separable3x3(k, k.median3, horizontalMedian3Row, src, dst, rowBegin, rowEnd);
+}
+
+void applyErosion3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst)
+{
+	applyErosion3x3(k, src, dst, 0, src.height);
+}
+
+void applyErosion3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst, std::size_t rowBegin,
+		     std::size_t rowEnd)
+{
+	separable3x3(k, k.min3, horizontalErosion3Row, src, dst, rowBegin, rowEnd);
+}
+
+void applyDilation3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst)
+{
+	applyDilation3x3(k, src, dst, 0, src.height);
+}
+
+void applyDilation3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst, std::size_t rowBegin,
+		      std::size_t rowEnd)
+{
+	separable3x3(k, k.max3, horizontalDilation3Row, src, dst, rowBegin, rowEnd);
+}
+
+void calculateMotionMap(const KernelSet &k, const ConstLumaView &current, const ConstLumaView &previous,
+			const LumaView &dst)
+{
+	calculateMotionMap(k, current, previous, dst, 0, current.height);
+}
+
+void calculateMotionMap(const KernelSet &k, const ConstLumaView &current, const ConstLumaView &previous,
+			const LumaView &dst, std::size_t rowBegin, std::size_t rowEnd)
+{
+	// The GPU keeps the horizontal pass in an R32F target, so the sums stay exact until the vertical pass.
+	const std::size_t midHeight = rowEnd - rowBegin + 2;
+	std::vector<std::uint16_t> sums(current.width * midHeight);
+	const ImageView<std::uint16_t> mid{sums.data(), current.width, midHeight, current.width};
+	for (std::size_t i = 0; i < midHeight; i++) {
+		const auto iy = static_cast<std::ptrdiff_t>(rowBegin + i) - 1;
+		horizontalMotionRow(k, current.clampedRow(iy), previous.clampedRow(iy), mid.row(i), current.width);
+	}
+	for (std::size_t y = rowBegin; y < rowEnd; y++) {
+		const std::size_t i = y - rowBegin;
+		k.average9(mid.row(i), mid.row(i + 1), mid.row(i + 2), dst.row(y), current.width);
+	}
+}
+
+void applyMotionAdaptiveFilter(const KernelSet &k, const ConstLumaView &current, const ConstLumaView &previous,
+			       const ConstLumaView &motionMap, const LumaView &dst, const MotionAdaptiveTable &table)
+{
+	for (std::size_t y = 0; y < current.height; y++) {
+		k.motionAdaptiveBlend(current.row(y), previous.row(y), motionMap.row(y), dst.row(y), current.width,
+				      table);
+	}
+}
+
+void applySobelMagnitude(const KernelSet &k, const ConstLumaView &src, const LumaView &dst)
+{
+	applySobelMagnitude(k, src, dst, 0, src.height);
+}
+
+void applySobelMagnitude(const KernelSet &k, const ConstLumaView &src, const LumaView &dst, std::size_t rowBegin,
+			 std::size_t rowEnd)
+{
+	for (std::size_t y = rowBegin; y < rowEnd; y++) {
+		const auto iy = static_cast<std::ptrdiff_t>(y);
+		sobelMagnitudeRow(k, src.clampedRow(iy - 1), src.row(y), src.clampedRow(iy + 1), dst.row(y),
+				  src.width);
+	}
+}
+
+void applyFinalizeSobelMagnitude(const ConstLumaView &src, const LumaView &dst, const FinalizeTable &table)
+{
+	for (std::size_t y = 0; y < src.height; y++) {
+		applyTableRow(src.row(y), dst.row(y), src.width, table.values);
+	}
+}
+
+} // namespace CpuKernels
+} // namespace ShowDraw
+} // namespace KaitoTokyo
@@ -0,0 +1,226 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+/**
+ * CPU implementations of every technique in data/effects/main.effect.
+ *
+ * Images are 8-bit planes that correspond to the R8 render targets used on the GPU.
+ * Borders are handled as with the Clamp sampler: samples outside the plane repeat the edge pixel.
+ *
+ * Every instruction-set variant produces bit-identical results; the scalar variant is the reference.
+ * Compared with the shaders evaluated in float32 and stored to 8-bit targets, each stage differs by
+ * at most 1 LSB:
+ * - ConvertGrayscale uses Q15 BT.709 weights (at most 1 LSB).
+ * - Median, erosion, dilation and the motion map are exact.
+ * - MotionAdaptiveFiltering quantizes the blend factor to Q15 (at most 1 LSB).
+ * - ApplySobel and FinalizeSobelMagnitude may round the other way at exact .5 boundaries (at most 1 LSB).
+ * ApplySobel only produces the magnitude channel; the gradient channels are never consumed downstream.
+ */
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace CpuKernels {
+
+enum class KernelIsa { Scalar, Sse41, Avx2, Neon };
+
+template<typename T> struct ImageView {
+	T *data;
+	std::size_t width;
+	std::size_t height;
+	std::size_t stride;
+
+	template<typename U = T, typename = std::enable_if_t<!std::is_const_v<U>>>
+	operator ImageView<const U>() const noexcept
+	{
+		return {data, width, height, stride};
+	}
+
+	T *row(std::size_t y) const noexcept { return data + y * stride; }
+
+	/**
+	 * @brief Gets the view of rows [begin, end), which shares the pixels of this view.
+	 */
+	ImageView rows(std::size_t begin, std::size_t end) const noexcept
+	{
+		return {row(begin), width, end - begin, stride};
+	}
+
+	/**
+	 * @brief Gets a row with the index clamped to the plane, as the Clamp sampler does.
+	 */
+	T *clampedRow(std::ptrdiff_t y) const noexcept
+	{
+		if (y < 0) {
+			return data;
+		}
+		if (static_cast<std::size_t>(y) >= height) {
+			return data + (height - 1) * stride;
+		}
+		return data + static_cast<std::size_t>(y) * stride;
+	}
+};
+
+using LumaView = ImageView<std::uint8_t>;
+using ConstLumaView = ImageView<const std::uint8_t>;
+
+/**
+ * @brief An owning, tightly packed 8-bit plane.
+ */
+struct LumaImage {
+	std::size_t width = 0;
+	std::size_t height = 0;
+	std::vector<std::uint8_t> pixels;
+
+	LumaImage() = default;
+	LumaImage(std::size_t _width, std::size_t _height, std::uint8_t fill = 0)
+		: width(_width),
+		  height(_height),
+		  pixels(_width * _height, fill)
+	{
+	}
+
+	LumaView view() noexcept { return {pixels.data(), width, height, width}; }
+	ConstLumaView view() const noexcept { return {pixels.data(), width, height, width}; }
+};
+
+/**
+ * @brief Q15 blend factors of MotionAdaptiveFiltering indexed by the 8-bit motion value.
+ */
+struct MotionAdaptiveTable {
+	std::array<std::int16_t, 256> blendQ15;
+
+	static MotionAdaptiveTable create(float strength, float motionThreshold) noexcept;
+};
+
+/**
+ * @brief The response of FinalizeSobelMagnitude for every 8-bit magnitude.
+ */
+struct FinalizeTable {
+	std::array<std::uint8_t, 256> values;
+
+	static FinalizeTable create(bool useLog, float scalingFactor) noexcept;
+};
+
+/**
+ * @brief The per-instruction-set primitives. All counts are in pixels.
+ *
+ * median3, min3 and max3 combine three arrays element-wise, which serves both the horizontal pass
+ * (three shifted pointers into one row) and the vertical pass (three rows).
+ * absDiffSum3 and sobelMagnitude read count + 2 columns, so callers pass pointers to the left neighbour
+ * of the first output.
+ */
+struct KernelSet {
+	KernelIsa isa;
+	const char *name;
+
+	void (*bgraToLuma)(const std::uint8_t *bgra, std::uint8_t *dst, std::size_t count);
+
+	void (*median3)(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c, std::uint8_t *dst,
+			std::size_t count);
+	void (*min3)(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c, std::uint8_t *dst,
+		     std::size_t count);
+	void (*max3)(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c, std::uint8_t *dst,
+		     std::size_t count);
+
+	// dst[i] = sum of |current[i + k] - previous[i + k]| for k = 0, 1, 2
+	void (*absDiffSum3)(const std::uint8_t *current, const std::uint8_t *previous, std::uint16_t *dst,
+			    std::size_t count);
+	// dst[i] = round((a[i] + b[i] + c[i]) / 9)
+	void (*average9)(const std::uint16_t *a, const std::uint16_t *b, const std::uint16_t *c, std::uint8_t *dst,
+			 std::size_t count);
+
+	void (*motionAdaptiveBlend)(const std::uint8_t *current, const std::uint8_t *previous,
+				    const std::uint8_t *motion, std::uint8_t *dst, std::size_t count,
+				    const MotionAdaptiveTable &table);
+
+	// dst[i] = Sobel magnitude centred at row1[i + 1]
+	void (*sobelMagnitude)(const std::uint8_t *row0, const std::uint8_t *row1, const std::uint8_t *row2,
+			       std::uint8_t *dst, std::size_t count);
+};
+
+/**
+ * @brief Gets the fastest kernel set supported by the running CPU. Selected once on first use.
+ */
+const KernelSet &getKernels() noexcept;
+
+/**
+ * @brief Gets the kernel set of a specific instruction set.
+ * @return nullptr if the variant was not compiled in or is not supported by the running CPU.
+ */
+const KernelSet *getKernels(KernelIsa isa) noexcept;
+
+// The variants themselves. These return nullptr only when the variant is not compiled for this architecture
+// and do not check the running CPU, so use getKernels(KernelIsa) unless support is already known.
+const KernelSet &getScalarKernels() noexcept;
+const KernelSet *getSse41Kernels() noexcept;
+const KernelSet *getAvx2Kernels() noexcept;
+const KernelSet *getNeonKernels() noexcept;
+
+// Row operations. Horizontal neighbours outside [0, width) repeat the edge pixel.
+
+void convertBgraToLumaRow(const KernelSet &k, const std::uint8_t *bgra, std::uint8_t *dst, std::size_t width);
+void horizontalMedian3Row(const KernelSet &k, const std::uint8_t *src, std::uint8_t *dst, std::size_t width);
+void horizontalErosion3Row(const KernelSet &k, const std::uint8_t *src, std::uint8_t *dst, std::size_t width);
+void horizontalDilation3Row(const KernelSet &k, const std::uint8_t *src, std::uint8_t *dst, std::size_t width);
+void horizontalMotionRow(const KernelSet &k, const std::uint8_t *current, const std::uint8_t *previous,
+			 std::uint16_t *dst, std::size_t width);
+void sobelMagnitudeRow(const KernelSet &k, const std::uint8_t *row0, const std::uint8_t *row1,
+		       const std::uint8_t *row2, std::uint8_t *dst, std::size_t width);
+void applyTableRow(const std::uint8_t *src, std::uint8_t *dst, std::size_t width,
+		   const std::array<std::uint8_t, 256> &table);
+
+// Frame operations mirroring the techniques of main.effect. Source and destination must not alias.
+
+// bgra is addressed in bytes per row; its width and height are ignored in favour of those of dst.
+void convertBgraToLuma(const KernelSet &k, const ImageView<const std::uint8_t> &bgra, const LumaView &dst);
+void applyMedian3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst);
+void applyErosion3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst);
+void applyDilation3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst);
+void calculateMotionMap(const KernelSet &k, const ConstLumaView &current, const ConstLumaView &previous,
+			const LumaView &dst);
+void applyMotionAdaptiveFilter(const KernelSet &k, const ConstLumaView &current, const ConstLumaView &previous,
+			       const ConstLumaView &motionMap, const LumaView &dst, const MotionAdaptiveTable &table);
+void applySobelMagnitude(const KernelSet &k, const ConstLumaView &src, const LumaView &dst);
+void applyFinalizeSobelMagnitude(const ConstLumaView &src, const LumaView &dst, const FinalizeTable &table);
+
+// Band operations. These write rows [rowBegin, rowEnd) of dst only and read the rows around the band from the
+// whole source as the halo, so bands of one frame can run concurrently and match the frame operation exactly.
+// Pointwise operations need no halo; pass them views made with ImageView::rows instead.
+
+void applyMedian3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst, std::size_t rowBegin,
+		    std::size_t rowEnd);
+void applyErosion3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst, std::size_t rowBegin,
+		     std::size_t rowEnd);
+void applyDilation3x3(const KernelSet &k, const ConstLumaView &src, const LumaView &dst, std::size_t rowBegin,
+		      std::size_t rowEnd);
+void calculateMotionMap(const KernelSet &k, const ConstLumaView &current, const ConstLumaView &previous,
+			const LumaView &dst, std::size_t rowBegin, std::size_t rowEnd);
+void applySobelMagnitude(const KernelSet &k, const ConstLumaView &src, const LumaView &dst, std::size_t rowBegin,
+			 std::size_t rowEnd);
+
+} // namespace CpuKernels
+} // namespace ShowDraw
+} // namespace KaitoTokyo
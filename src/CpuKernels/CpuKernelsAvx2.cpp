@@ -0,0 +1,246 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "CpuKernels.hpp"
+#include "CpuKernelsDetail.hpp"
+
+#if SHOWDRAW_CPU_KERNELS_X86
+
+#include <immintrin.h>
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels::CpuKernelsDetail;
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace CpuKernels {
+
+namespace {
+
+SHOWDRAW_TARGET_AVX2 inline __m256i loadu(const void *p)
+{
+	return _mm256_loadu_si256(static_cast<const __m256i *>(p));
+}
+
+SHOWDRAW_TARGET_AVX2 inline void storeu(void *p, __m256i v)
+{
+	_mm256_storeu_si256(static_cast<__m256i *>(p), v);
+}
+
+SHOWDRAW_TARGET_AVX2 inline __m256i loadWidened(const std::uint8_t *p)
+{
+	return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+/**
+ * @brief Narrows sixteen 16-bit lanes to bytes with unsigned saturation, keeping their order.
+ */
+SHOWDRAW_TARGET_AVX2 inline __m128i packU16ToU8(__m256i v)
+{
+	return _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+SHOWDRAW_TARGET_AVX2 inline __m256i absDiffU8(__m256i a, __m256i b)
+{
+	return _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+}
+
+SHOWDRAW_TARGET_AVX2 void median3Avx2(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c,
+				      std::uint8_t *dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		const __m256i va = loadu(a + i);
+		const __m256i vb = loadu(b + i);
+		const __m256i vc = loadu(c + i);
+		const __m256i lo = _mm256_min_epu8(va, vb);
+		const __m256i hi = _mm256_max_epu8(va, vb);
+		storeu(dst + i, _mm256_max_epu8(lo, _mm256_min_epu8(hi, vc)));
+	}
+	for (; i < count; i++) {
+		dst[i] = median3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+SHOWDRAW_TARGET_AVX2 void min3Avx2(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c,
+				   std::uint8_t *dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		storeu(dst + i, _mm256_min_epu8(loadu(a + i), _mm256_min_epu8(loadu(b + i), loadu(c + i))));
+	}
+	for (; i < count; i++) {
+		dst[i] = min3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+SHOWDRAW_TARGET_AVX2 void max3Avx2(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c,
+				   std::uint8_t *dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		storeu(dst + i, _mm256_max_epu8(loadu(a + i), _mm256_max_epu8(loadu(b + i), loadu(c + i))));
+	}
+	for (; i < count; i++) {
+		dst[i] = max3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+SHOWDRAW_TARGET_AVX2 void absDiffSum3Avx2(const std::uint8_t *current, const std::uint8_t *previous,
+					  std::uint16_t *dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		const __m256i d0 = absDiffU8(loadu(current + i), loadu(previous + i));
+		const __m256i d1 = absDiffU8(loadu(current + i + 1), loadu(previous + i + 1));
+		const __m256i d2 = absDiffU8(loadu(current + i + 2), loadu(previous + i + 2));
+		const __m256i lo = _mm256_add_epi16(
+			_mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(d0)),
+					 _mm256_cvtepu8_epi16(_mm256_castsi256_si128(d1))),
+			_mm256_cvtepu8_epi16(_mm256_castsi256_si128(d2)));
+		const __m256i hi = _mm256_add_epi16(
+			_mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(d0, 1)),
+					 _mm256_cvtepu8_epi16(_mm256_extracti128_si256(d1, 1))),
+			_mm256_cvtepu8_epi16(_mm256_extracti128_si256(d2, 1)));
+		storeu(dst + i, lo);
+		storeu(dst + i + 16, hi);
+	}
+	for (; i < count; i++) {
+		dst[i] = static_cast<std::uint16_t>(absDiff(current[i], previous[i]) +
+						    absDiff(current[i + 1], previous[i + 1]) +
+						    absDiff(current[i + 2], previous[i + 2]));
+	}
+}
+
+SHOWDRAW_TARGET_AVX2 void average9Avx2(const std::uint16_t *a, const std::uint16_t *b, const std::uint16_t *c,
+				       std::uint8_t *dst, std::size_t count)
+{
+	const __m256i bias = _mm256_set1_epi16(9);
+	const __m256i multiplier = _mm256_set1_epi16(Average9Multiplier);
+
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m256i sum = _mm256_add_epi16(_mm256_add_epi16(loadu(a + i), loadu(b + i)), loadu(c + i));
+		const __m256i result = _mm256_mulhi_epu16(_mm256_add_epi16(_mm256_add_epi16(sum, sum), bias), multiplier);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packU16ToU8(result));
+	}
+	for (; i < count; i++) {
+		dst[i] = average9Pixel(a[i] + b[i] + c[i]);
+	}
+}
+
+SHOWDRAW_TARGET_AVX2 void motionAdaptiveBlendAvx2(const std::uint8_t *current, const std::uint8_t *previous,
+						  const std::uint8_t *motion, std::uint8_t *dst, std::size_t count,
+						  const MotionAdaptiveTable &table)
+{
+	const std::int16_t *blend = table.blendQ15.data();
+
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const std::uint8_t *m = motion + i;
+		const __m256i factors = _mm256_setr_epi16(blend[m[0]], blend[m[1]], blend[m[2]], blend[m[3]],
+							  blend[m[4]], blend[m[5]], blend[m[6]], blend[m[7]],
+							  blend[m[8]], blend[m[9]], blend[m[10]], blend[m[11]],
+							  blend[m[12]], blend[m[13]], blend[m[14]], blend[m[15]]);
+		const __m256i cur = loadWidened(current + i);
+		const __m256i prev = loadWidened(previous + i);
+		const __m256i delta = _mm256_mulhrs_epi16(_mm256_sub_epi16(cur, prev), factors);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packU16ToU8(_mm256_add_epi16(prev, delta)));
+	}
+	for (; i < count; i++) {
+		dst[i] = blendPixel(current[i], previous[i], blend[motion[i]]);
+	}
+}
+
+/**
+ * @brief Computes the 8-bit magnitude from eight squared gradients, as sobelMagnitudeFromSquared does.
+ */
+SHOWDRAW_TARGET_AVX2 inline __m256i sobelMagnitudes(__m256i squared)
+{
+	const __m256 quotient = _mm256_div_ps(_mm256_cvtepi32_ps(squared), _mm256_set1_ps(20.0f));
+	return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_sqrt_ps(quotient), _mm256_set1_ps(0.5f)));
+}
+
+SHOWDRAW_TARGET_AVX2 void sobelMagnitudeAvx2(const std::uint8_t *row0, const std::uint8_t *row1,
+					     const std::uint8_t *row2, std::uint8_t *dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m256i a0 = loadWidened(row0 + i), a1 = loadWidened(row0 + i + 1), a2 = loadWidened(row0 + i + 2);
+		const __m256i b0 = loadWidened(row1 + i), b2 = loadWidened(row1 + i + 2);
+		const __m256i c0 = loadWidened(row2 + i), c1 = loadWidened(row2 + i + 1), c2 = loadWidened(row2 + i + 2);
+
+		const __m256i right = _mm256_add_epi16(_mm256_add_epi16(a2, c2), _mm256_add_epi16(b2, b2));
+		const __m256i left = _mm256_add_epi16(_mm256_add_epi16(a0, c0), _mm256_add_epi16(b0, b0));
+		const __m256i bottom = _mm256_add_epi16(_mm256_add_epi16(c0, c2), _mm256_add_epi16(c1, c1));
+		const __m256i top = _mm256_add_epi16(_mm256_add_epi16(a0, a2), _mm256_add_epi16(a1, a1));
+		const __m256i gx = _mm256_sub_epi16(right, left);
+		const __m256i gy = _mm256_sub_epi16(bottom, top);
+
+		// unpack and pack both work within 128-bit lanes, so the pair restores the original order.
+		const __m256i lo = _mm256_unpacklo_epi16(gx, gy);
+		const __m256i hi = _mm256_unpackhi_epi16(gx, gy);
+		const __m256i magnitudeLo = sobelMagnitudes(_mm256_madd_epi16(lo, lo));
+		const __m256i magnitudeHi = sobelMagnitudes(_mm256_madd_epi16(hi, hi));
+		const __m256i magnitudes = _mm256_packs_epi32(magnitudeLo, magnitudeHi);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packU16ToU8(magnitudes));
+	}
+	for (; i < count; i++) {
+		dst[i] = sobelPixel(row0, row1, row2, i, i + 1, i + 2);
+	}
+}
+
+} // namespace
+
+const KernelSet *getAvx2Kernels() noexcept
+{
+	// Luma conversion is bound by the horizontal adds of the deinterleave, so the SSE4.1 loop is kept.
+	static const KernelSet kernels{
+		KernelIsa::Avx2,
+		"avx2",
+		getSse41Kernels()->bgraToLuma,
+		median3Avx2,
+		min3Avx2,
+		max3Avx2,
+		absDiffSum3Avx2,
+		average9Avx2,
+		motionAdaptiveBlendAvx2,
+		sobelMagnitudeAvx2,
+	};
+	return &kernels;
+}
+
+} // namespace CpuKernels
+} // namespace ShowDraw
+} // namespace KaitoTokyo
+
+#else
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace CpuKernels {
+
+const KernelSet *getAvx2Kernels() noexcept
+{
+	return nullptr;
+}
+
+} // namespace CpuKernels
+} // namespace ShowDraw
+} // namespace KaitoTokyo
+
+#endif
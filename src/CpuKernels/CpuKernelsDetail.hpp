@@ -0,0 +1,125 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#include "CpuKernels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SHOWDRAW_CPU_KERNELS_X86 1
+#else
+#define SHOWDRAW_CPU_KERNELS_X86 0
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define SHOWDRAW_CPU_KERNELS_NEON 1
+#else
+#define SHOWDRAW_CPU_KERNELS_NEON 0
+#endif
+
+// Instruction sets are enabled per function rather than per file so that macOS universal builds,
+// which compile every file for both architectures, need no architecture-specific flags.
+#if defined(__GNUC__) || defined(__clang__)
+#define SHOWDRAW_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SHOWDRAW_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SHOWDRAW_TARGET_SSE41
+#define SHOWDRAW_TARGET_AVX2
+#endif
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace CpuKernels {
+namespace CpuKernelsDetail {
+
+// Q15 BT.709 luma weights. They sum to 32768 so that white maps to 255.
+constexpr int LumaWeightR = 6966;
+constexpr int LumaWeightG = 23436;
+constexpr int LumaWeightB = 2366;
+
+// round(m / 9) == ((2 * m + 9) * Average9Multiplier) >> 16 for every m <= 3 * 765.
+constexpr int Average9Multiplier = 3641;
+
+inline std::uint8_t lumaPixel(const std::uint8_t *bgra) noexcept
+{
+	const int sum = bgra[0] * LumaWeightB + bgra[1] * LumaWeightG + bgra[2] * LumaWeightR;
+	return static_cast<std::uint8_t>((sum + 16384) >> 15);
+}
+
+inline std::uint8_t median3Pixel(std::uint8_t a, std::uint8_t b, std::uint8_t c) noexcept
+{
+	return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+inline std::uint8_t min3Pixel(std::uint8_t a, std::uint8_t b, std::uint8_t c) noexcept
+{
+	return std::min(a, std::min(b, c));
+}
+
+inline std::uint8_t max3Pixel(std::uint8_t a, std::uint8_t b, std::uint8_t c) noexcept
+{
+	return std::max(a, std::max(b, c));
+}
+
+inline int absDiff(std::uint8_t a, std::uint8_t b) noexcept
+{
+	return std::abs(static_cast<int>(a) - static_cast<int>(b));
+}
+
+inline std::uint8_t average9Pixel(int sum) noexcept
+{
+	return static_cast<std::uint8_t>((2 * sum + 9) / 18);
+}
+
+inline std::uint8_t blendPixel(std::uint8_t current, std::uint8_t previous, std::int16_t blendQ15) noexcept
+{
+	const int difference = static_cast<int>(current) - static_cast<int>(previous);
+	return static_cast<std::uint8_t>(previous + ((difference * blendQ15 + 16384) >> 15));
+}
+
+/**
+ * @brief Converts a squared gradient to the 8-bit magnitude stored by ApplySobel.
+ *
+ * The SIMD variants perform the same IEEE operations in the same order, so the results are bit-identical.
+ */
+inline std::uint8_t sobelMagnitudeFromSquared(int squared) noexcept
+{
+	const int magnitude = static_cast<int>(std::sqrt(static_cast<float>(squared) / 20.0f) + 0.5f);
+	return static_cast<std::uint8_t>(std::min(magnitude, 255));
+}
+
+/**
+ * @brief Computes the Sobel magnitude from the 3x3 neighbourhood given by three rows and three columns.
+ */
+inline std::uint8_t sobelPixel(const std::uint8_t *row0, const std::uint8_t *row1, const std::uint8_t *row2,
+			       std::size_t left, std::size_t centre, std::size_t right) noexcept
+{
+	const int gx = (row0[right] + 2 * row1[right] + row2[right]) - (row0[left] + 2 * row1[left] + row2[left]);
+	const int gy = (row2[left] + 2 * row2[centre] + row2[right]) - (row0[left] + 2 * row0[centre] + row0[right]);
+	return sobelMagnitudeFromSquared(gx * gx + gy * gy);
+}
+
+} // namespace CpuKernelsDetail
+} // namespace CpuKernels
+} // namespace ShowDraw
+} // namespace KaitoTokyo
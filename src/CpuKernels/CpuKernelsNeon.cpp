@@ -0,0 +1,242 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "CpuKernels.hpp"
+#include "CpuKernelsDetail.hpp"
+
+#if SHOWDRAW_CPU_KERNELS_NEON
+
+#include <arm_neon.h>
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels::CpuKernelsDetail;
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace CpuKernels {
+
+namespace {
+
+void bgraToLumaNeon(const std::uint8_t *bgra, std::uint8_t *dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const uint8x8x4_t pixels = vld4_u8(bgra + i * 4);
+		const uint16x8_t b = vmovl_u8(pixels.val[0]);
+		const uint16x8_t g = vmovl_u8(pixels.val[1]);
+		const uint16x8_t r = vmovl_u8(pixels.val[2]);
+
+		uint32x4_t lo = vmull_n_u16(vget_low_u16(b), LumaWeightB);
+		lo = vmlal_n_u16(lo, vget_low_u16(g), LumaWeightG);
+		lo = vmlal_n_u16(lo, vget_low_u16(r), LumaWeightR);
+		uint32x4_t hi = vmull_n_u16(vget_high_u16(b), LumaWeightB);
+		hi = vmlal_n_u16(hi, vget_high_u16(g), LumaWeightG);
+		hi = vmlal_n_u16(hi, vget_high_u16(r), LumaWeightR);
+
+		const uint16x8_t luma = vcombine_u16(vrshrn_n_u32(lo, 15), vrshrn_n_u32(hi, 15));
+		vst1_u8(dst + i, vqmovn_u16(luma));
+	}
+	for (; i < count; i++) {
+		dst[i] = lumaPixel(bgra + i * 4);
+	}
+}
+
+void median3Neon(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c, std::uint8_t *dst,
+		 std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const uint8x16_t va = vld1q_u8(a + i);
+		const uint8x16_t vb = vld1q_u8(b + i);
+		const uint8x16_t vc = vld1q_u8(c + i);
+		vst1q_u8(dst + i, vmaxq_u8(vminq_u8(va, vb), vminq_u8(vmaxq_u8(va, vb), vc)));
+	}
+	for (; i < count; i++) {
+		dst[i] = median3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+void min3Neon(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c, std::uint8_t *dst,
+	      std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		vst1q_u8(dst + i, vminq_u8(vld1q_u8(a + i), vminq_u8(vld1q_u8(b + i), vld1q_u8(c + i))));
+	}
+	for (; i < count; i++) {
+		dst[i] = min3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+void max3Neon(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c, std::uint8_t *dst,
+	      std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		vst1q_u8(dst + i, vmaxq_u8(vld1q_u8(a + i), vmaxq_u8(vld1q_u8(b + i), vld1q_u8(c + i))));
+	}
+	for (; i < count; i++) {
+		dst[i] = max3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+void absDiffSum3Neon(const std::uint8_t *current, const std::uint8_t *previous, std::uint16_t *dst,
+		     std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const uint8x16_t d0 = vabdq_u8(vld1q_u8(current + i), vld1q_u8(previous + i));
+		const uint8x16_t d1 = vabdq_u8(vld1q_u8(current + i + 1), vld1q_u8(previous + i + 1));
+		const uint8x16_t d2 = vabdq_u8(vld1q_u8(current + i + 2), vld1q_u8(previous + i + 2));
+		const uint16x8_t lo =
+			vaddw_u8(vaddl_u8(vget_low_u8(d0), vget_low_u8(d1)), vget_low_u8(d2));
+		const uint16x8_t hi =
+			vaddw_u8(vaddl_u8(vget_high_u8(d0), vget_high_u8(d1)), vget_high_u8(d2));
+		vst1q_u16(dst + i, lo);
+		vst1q_u16(dst + i + 8, hi);
+	}
+	for (; i < count; i++) {
+		dst[i] = static_cast<std::uint16_t>(absDiff(current[i], previous[i]) +
+						    absDiff(current[i + 1], previous[i + 1]) +
+						    absDiff(current[i + 2], previous[i + 2]));
+	}
+}
+
+void average9Neon(const std::uint16_t *a, const std::uint16_t *b, const std::uint16_t *c, std::uint8_t *dst,
+		  std::size_t count)
+{
+	const uint16x8_t bias = vdupq_n_u16(9);
+
+	std::size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const uint16x8_t sum = vaddq_u16(vaddq_u16(vld1q_u16(a + i), vld1q_u16(b + i)), vld1q_u16(c + i));
+		const uint16x8_t biased = vaddq_u16(vaddq_u16(sum, sum), bias);
+		const uint32x4_t lo = vmull_n_u16(vget_low_u16(biased), Average9Multiplier);
+		const uint32x4_t hi = vmull_n_u16(vget_high_u16(biased), Average9Multiplier);
+		const uint16x8_t result = vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16));
+		vst1_u8(dst + i, vqmovn_u16(result));
+	}
+	for (; i < count; i++) {
+		dst[i] = average9Pixel(a[i] + b[i] + c[i]);
+	}
+}
+
+void motionAdaptiveBlendNeon(const std::uint8_t *current, const std::uint8_t *previous, const std::uint8_t *motion,
+			     std::uint8_t *dst, std::size_t count, const MotionAdaptiveTable &table)
+{
+	const std::int16_t *blend = table.blendQ15.data();
+
+	std::size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const std::uint8_t *m = motion + i;
+		const std::int16_t lookup[8] = {blend[m[0]], blend[m[1]], blend[m[2]], blend[m[3]],
+						blend[m[4]], blend[m[5]], blend[m[6]], blend[m[7]]};
+		const int16x8_t factors = vld1q_s16(lookup);
+		const int16x8_t cur = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(current + i)));
+		const int16x8_t prev = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(previous + i)));
+		// vqrdmulh computes (2ab + 2^15) >> 16, which equals the (ab + 2^14) >> 15 of the scalar path.
+		const int16x8_t delta = vqrdmulhq_s16(vsubq_s16(cur, prev), factors);
+		vst1_u8(dst + i, vqmovun_s16(vaddq_s16(prev, delta)));
+	}
+	for (; i < count; i++) {
+		dst[i] = blendPixel(current[i], previous[i], blend[motion[i]]);
+	}
+}
+
+inline int16x8_t loadWidened(const std::uint8_t *p)
+{
+	return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)));
+}
+
+/**
+ * @brief Computes the 8-bit magnitude from four squared gradients, as sobelMagnitudeFromSquared does.
+ */
+inline uint32x4_t sobelMagnitudes(int32x4_t squared)
+{
+	const float32x4_t quotient = vdivq_f32(vcvtq_f32_s32(squared), vdupq_n_f32(20.0f));
+	return vcvtq_u32_f32(vaddq_f32(vsqrtq_f32(quotient), vdupq_n_f32(0.5f)));
+}
+
+void sobelMagnitudeNeon(const std::uint8_t *row0, const std::uint8_t *row1, const std::uint8_t *row2,
+			std::uint8_t *dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const int16x8_t a0 = loadWidened(row0 + i), a1 = loadWidened(row0 + i + 1), a2 = loadWidened(row0 + i + 2);
+		const int16x8_t b0 = loadWidened(row1 + i), b2 = loadWidened(row1 + i + 2);
+		const int16x8_t c0 = loadWidened(row2 + i), c1 = loadWidened(row2 + i + 1), c2 = loadWidened(row2 + i + 2);
+
+		const int16x8_t right = vaddq_s16(vaddq_s16(a2, c2), vaddq_s16(b2, b2));
+		const int16x8_t left = vaddq_s16(vaddq_s16(a0, c0), vaddq_s16(b0, b0));
+		const int16x8_t bottom = vaddq_s16(vaddq_s16(c0, c2), vaddq_s16(c1, c1));
+		const int16x8_t top = vaddq_s16(vaddq_s16(a0, a2), vaddq_s16(a1, a1));
+		const int16x8_t gx = vsubq_s16(right, left);
+		const int16x8_t gy = vsubq_s16(bottom, top);
+
+		int32x4_t squaredLo = vmull_s16(vget_low_s16(gx), vget_low_s16(gx));
+		squaredLo = vmlal_s16(squaredLo, vget_low_s16(gy), vget_low_s16(gy));
+		int32x4_t squaredHi = vmull_s16(vget_high_s16(gx), vget_high_s16(gx));
+		squaredHi = vmlal_s16(squaredHi, vget_high_s16(gy), vget_high_s16(gy));
+
+		const uint16x8_t magnitudes =
+			vcombine_u16(vqmovn_u32(sobelMagnitudes(squaredLo)), vqmovn_u32(sobelMagnitudes(squaredHi)));
+		vst1_u8(dst + i, vqmovn_u16(magnitudes));
+	}
+	for (; i < count; i++) {
+		dst[i] = sobelPixel(row0, row1, row2, i, i + 1, i + 2);
+	}
+}
+
+} // namespace
+
+const KernelSet *getNeonKernels() noexcept
+{
+	static const KernelSet kernels{
+		KernelIsa::Neon,
+		"neon",
+		bgraToLumaNeon,
+		median3Neon,
+		min3Neon,
+		max3Neon,
+		absDiffSum3Neon,
+		average9Neon,
+		motionAdaptiveBlendNeon,
+		sobelMagnitudeNeon,
+	};
+	return &kernels;
+}
+
+} // namespace CpuKernels
+} // namespace ShowDraw
+} // namespace KaitoTokyo
+
+#else
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace CpuKernels {
+
+const KernelSet *getNeonKernels() noexcept
+{
+	return nullptr;
+}
+
+} // namespace CpuKernels
+} // namespace ShowDraw
+} // namespace KaitoTokyo
+
+#endif
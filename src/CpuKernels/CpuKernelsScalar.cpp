@@ -0,0 +1,116 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "CpuKernels.hpp"
+#include "CpuKernelsDetail.hpp"
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels::CpuKernelsDetail;
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace CpuKernels {
+
+namespace {
+
+void bgraToLumaScalar(const std::uint8_t *bgra, std::uint8_t *dst, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++) {
+		dst[i] = lumaPixel(bgra + i * 4);
+	}
+}
+
+void median3Scalar(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c, std::uint8_t *dst,
+		   std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++) {
+		dst[i] = median3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+void min3Scalar(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c, std::uint8_t *dst,
+		std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++) {
+		dst[i] = min3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+void max3Scalar(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c, std::uint8_t *dst,
+		std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++) {
+		dst[i] = max3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+void absDiffSum3Scalar(const std::uint8_t *current, const std::uint8_t *previous, std::uint16_t *dst,
+		       std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++) {
+		dst[i] = static_cast<std::uint16_t>(absDiff(current[i], previous[i]) +
+						    absDiff(current[i + 1], previous[i + 1]) +
+						    absDiff(current[i + 2], previous[i + 2]));
+	}
+}
+
+void average9Scalar(const std::uint16_t *a, const std::uint16_t *b, const std::uint16_t *c, std::uint8_t *dst,
+		    std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++) {
+		dst[i] = average9Pixel(a[i] + b[i] + c[i]);
+	}
+}
+
+void motionAdaptiveBlendScalar(const std::uint8_t *current, const std::uint8_t *previous, const std::uint8_t *motion,
+			       std::uint8_t *dst, std::size_t count, const MotionAdaptiveTable &table)
+{
+	for (std::size_t i = 0; i < count; i++) {
+		dst[i] = blendPixel(current[i], previous[i], table.blendQ15[motion[i]]);
+	}
+}
+
+void sobelMagnitudeScalar(const std::uint8_t *row0, const std::uint8_t *row1, const std::uint8_t *row2,
+			  std::uint8_t *dst, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++) {
+		dst[i] = sobelPixel(row0, row1, row2, i, i + 1, i + 2);
+	}
+}
+
+} // namespace
+
+const KernelSet &getScalarKernels() noexcept
+{
+	static const KernelSet kernels{
+		KernelIsa::Scalar,
+		"scalar",
+		bgraToLumaScalar,
+		median3Scalar,
+		min3Scalar,
+		max3Scalar,
+		absDiffSum3Scalar,
+		average9Scalar,
+		motionAdaptiveBlendScalar,
+		sobelMagnitudeScalar,
+	};
+	return kernels;
+}
+
+} // namespace CpuKernels
+} // namespace ShowDraw
+} // namespace KaitoTokyo
@@ -0,0 +1,266 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "CpuKernels.hpp"
+#include "CpuKernelsDetail.hpp"
+
+#if SHOWDRAW_CPU_KERNELS_X86
+
+#include <immintrin.h>
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels::CpuKernelsDetail;
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace CpuKernels {
+
+namespace {
+
+SHOWDRAW_TARGET_SSE41 inline __m128i loadu(const void *p)
+{
+	return _mm_loadu_si128(static_cast<const __m128i *>(p));
+}
+
+SHOWDRAW_TARGET_SSE41 inline void storeu(void *p, __m128i v)
+{
+	_mm_storeu_si128(static_cast<__m128i *>(p), v);
+}
+
+SHOWDRAW_TARGET_SSE41 inline __m128i absDiffU8(__m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+}
+
+/**
+ * @brief Converts four BGRA pixels to four Q15 luma sums in 32-bit lanes.
+ */
+SHOWDRAW_TARGET_SSE41 inline __m128i lumaSums(__m128i bgra, __m128i weights)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(bgra, zero), weights);
+	const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(bgra, zero), weights);
+	return _mm_hadd_epi32(lo, hi);
+}
+
+SHOWDRAW_TARGET_SSE41 void bgraToLumaSse41(const std::uint8_t *bgra, std::uint8_t *dst, std::size_t count)
+{
+	const __m128i weights = _mm_setr_epi16(LumaWeightB, LumaWeightG, LumaWeightR, 0, LumaWeightB, LumaWeightG,
+					       LumaWeightR, 0);
+	const __m128i rounding = _mm_set1_epi32(16384);
+
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const std::uint8_t *p = bgra + i * 4;
+		const __m128i s0 = _mm_srli_epi32(_mm_add_epi32(lumaSums(loadu(p), weights), rounding), 15);
+		const __m128i s1 = _mm_srli_epi32(_mm_add_epi32(lumaSums(loadu(p + 16), weights), rounding), 15);
+		const __m128i s2 = _mm_srli_epi32(_mm_add_epi32(lumaSums(loadu(p + 32), weights), rounding), 15);
+		const __m128i s3 = _mm_srli_epi32(_mm_add_epi32(lumaSums(loadu(p + 48), weights), rounding), 15);
+		storeu(dst + i, _mm_packus_epi16(_mm_packus_epi32(s0, s1), _mm_packus_epi32(s2, s3)));
+	}
+	for (; i < count; i++) {
+		dst[i] = lumaPixel(bgra + i * 4);
+	}
+}
+
+SHOWDRAW_TARGET_SSE41 void median3Sse41(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c,
+					std::uint8_t *dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m128i va = loadu(a + i);
+		const __m128i vb = loadu(b + i);
+		const __m128i vc = loadu(c + i);
+		const __m128i lo = _mm_min_epu8(va, vb);
+		const __m128i hi = _mm_max_epu8(va, vb);
+		storeu(dst + i, _mm_max_epu8(lo, _mm_min_epu8(hi, vc)));
+	}
+	for (; i < count; i++) {
+		dst[i] = median3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+SHOWDRAW_TARGET_SSE41 void min3Sse41(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c,
+				     std::uint8_t *dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		storeu(dst + i, _mm_min_epu8(loadu(a + i), _mm_min_epu8(loadu(b + i), loadu(c + i))));
+	}
+	for (; i < count; i++) {
+		dst[i] = min3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+SHOWDRAW_TARGET_SSE41 void max3Sse41(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c,
+				     std::uint8_t *dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		storeu(dst + i, _mm_max_epu8(loadu(a + i), _mm_max_epu8(loadu(b + i), loadu(c + i))));
+	}
+	for (; i < count; i++) {
+		dst[i] = max3Pixel(a[i], b[i], c[i]);
+	}
+}
+
+SHOWDRAW_TARGET_SSE41 void absDiffSum3Sse41(const std::uint8_t *current, const std::uint8_t *previous,
+					    std::uint16_t *dst, std::size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m128i d0 = absDiffU8(loadu(current + i), loadu(previous + i));
+		const __m128i d1 = absDiffU8(loadu(current + i + 1), loadu(previous + i + 1));
+		const __m128i d2 = absDiffU8(loadu(current + i + 2), loadu(previous + i + 2));
+		const __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(d0, zero), _mm_unpacklo_epi8(d1, zero)),
+						 _mm_unpacklo_epi8(d2, zero));
+		const __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(d0, zero), _mm_unpackhi_epi8(d1, zero)),
+						 _mm_unpackhi_epi8(d2, zero));
+		storeu(dst + i, lo);
+		storeu(dst + i + 8, hi);
+	}
+	for (; i < count; i++) {
+		dst[i] = static_cast<std::uint16_t>(absDiff(current[i], previous[i]) +
+						    absDiff(current[i + 1], previous[i + 1]) +
+						    absDiff(current[i + 2], previous[i + 2]));
+	}
+}
+
+SHOWDRAW_TARGET_SSE41 void average9Sse41(const std::uint16_t *a, const std::uint16_t *b, const std::uint16_t *c,
+					 std::uint8_t *dst, std::size_t count)
+{
+	const __m128i bias = _mm_set1_epi16(9);
+	const __m128i multiplier = _mm_set1_epi16(Average9Multiplier);
+
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m128i sumLo = _mm_add_epi16(_mm_add_epi16(loadu(a + i), loadu(b + i)), loadu(c + i));
+		const __m128i sumHi = _mm_add_epi16(_mm_add_epi16(loadu(a + i + 8), loadu(b + i + 8)), loadu(c + i + 8));
+		const __m128i lo = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(sumLo, sumLo), bias), multiplier);
+		const __m128i hi = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(sumHi, sumHi), bias), multiplier);
+		storeu(dst + i, _mm_packus_epi16(lo, hi));
+	}
+	for (; i < count; i++) {
+		dst[i] = average9Pixel(a[i] + b[i] + c[i]);
+	}
+}
+
+SHOWDRAW_TARGET_SSE41 void motionAdaptiveBlendSse41(const std::uint8_t *current, const std::uint8_t *previous,
+						    const std::uint8_t *motion, std::uint8_t *dst, std::size_t count,
+						    const MotionAdaptiveTable &table)
+{
+	const std::int16_t *blend = table.blendQ15.data();
+
+	std::size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const std::uint8_t *m = motion + i;
+		const __m128i factors = _mm_setr_epi16(blend[m[0]], blend[m[1]], blend[m[2]], blend[m[3]], blend[m[4]],
+						       blend[m[5]], blend[m[6]], blend[m[7]]);
+		const __m128i cur = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(current + i)));
+		const __m128i prev = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(previous + i)));
+		const __m128i delta = _mm_mulhrs_epi16(_mm_sub_epi16(cur, prev), factors);
+		const __m128i result = _mm_packus_epi16(_mm_add_epi16(prev, delta), _mm_setzero_si128());
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), result);
+	}
+	for (; i < count; i++) {
+		dst[i] = blendPixel(current[i], previous[i], blend[motion[i]]);
+	}
+}
+
+SHOWDRAW_TARGET_SSE41 inline __m128i loadWidened(const std::uint8_t *p)
+{
+	return _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+}
+
+/**
+ * @brief Computes the 8-bit magnitude from four squared gradients, as sobelMagnitudeFromSquared does.
+ */
+SHOWDRAW_TARGET_SSE41 inline __m128i sobelMagnitudes(__m128i squared)
+{
+	const __m128 quotient = _mm_div_ps(_mm_cvtepi32_ps(squared), _mm_set1_ps(20.0f));
+	return _mm_cvttps_epi32(_mm_add_ps(_mm_sqrt_ps(quotient), _mm_set1_ps(0.5f)));
+}
+
+SHOWDRAW_TARGET_SSE41 void sobelMagnitudeSse41(const std::uint8_t *row0, const std::uint8_t *row1,
+					       const std::uint8_t *row2, std::uint8_t *dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m128i a0 = loadWidened(row0 + i), a1 = loadWidened(row0 + i + 1), a2 = loadWidened(row0 + i + 2);
+		const __m128i b0 = loadWidened(row1 + i), b2 = loadWidened(row1 + i + 2);
+		const __m128i c0 = loadWidened(row2 + i), c1 = loadWidened(row2 + i + 1), c2 = loadWidened(row2 + i + 2);
+
+		const __m128i right = _mm_add_epi16(_mm_add_epi16(a2, c2), _mm_add_epi16(b2, b2));
+		const __m128i left = _mm_add_epi16(_mm_add_epi16(a0, c0), _mm_add_epi16(b0, b0));
+		const __m128i bottom = _mm_add_epi16(_mm_add_epi16(c0, c2), _mm_add_epi16(c1, c1));
+		const __m128i top = _mm_add_epi16(_mm_add_epi16(a0, a2), _mm_add_epi16(a1, a1));
+		const __m128i gx = _mm_sub_epi16(right, left);
+		const __m128i gy = _mm_sub_epi16(bottom, top);
+
+		const __m128i lo = _mm_unpacklo_epi16(gx, gy);
+		const __m128i hi = _mm_unpackhi_epi16(gx, gy);
+		const __m128i magnitudeLo = sobelMagnitudes(_mm_madd_epi16(lo, lo));
+		const __m128i magnitudeHi = sobelMagnitudes(_mm_madd_epi16(hi, hi));
+		const __m128i result = _mm_packus_epi16(_mm_packs_epi32(magnitudeLo, magnitudeHi), _mm_setzero_si128());
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), result);
+	}
+	for (; i < count; i++) {
+		dst[i] = sobelPixel(row0, row1, row2, i, i + 1, i + 2);
+	}
+}
+
+} // namespace
+
+const KernelSet *getSse41Kernels() noexcept
+{
+	static const KernelSet kernels{
+		KernelIsa::Sse41,
+		"sse4.1",
+		bgraToLumaSse41,
+		median3Sse41,
+		min3Sse41,
+		max3Sse41,
+		absDiffSum3Sse41,
+		average9Sse41,
+		motionAdaptiveBlendSse41,
+		sobelMagnitudeSse41,
+	};
+	return &kernels;
+}
+
+} // namespace CpuKernels
+} // namespace ShowDraw
+} // namespace KaitoTokyo
+
+#else
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace CpuKernels {
+
+const KernelSet *getSse41Kernels() noexcept
+{
+	return nullptr;
+}
+
+} // namespace CpuKernels
+} // namespace ShowDraw
+} // namespace KaitoTokyo
+
+#endif
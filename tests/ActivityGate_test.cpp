@@ -0,0 +1,109 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Core/ActivityGate.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+
+namespace {
+
+constexpr std::uint32_t Width = 320;
+constexpr std::uint32_t Height = 180;
+constexpr std::uint64_t FrameNs = 33333333;
+constexpr double HoldSeconds = 0.5;
+
+std::vector<std::uint8_t> makeFrame(std::uint8_t background)
+{
+	return std::vector<std::uint8_t>(static_cast<std::size_t>(Width) * Height, background);
+}
+
+LumaPlaneView view(const std::vector<std::uint8_t> &frame)
+{
+	return {frame.data(), Width, Width, Height, 1};
+}
+
+} // namespace
+
+TEST(ActivityGateTest, TurnsStaticAfterTheHoldTime)
+{
+	ActivityGate gate;
+	const std::vector<std::uint8_t> frame = makeFrame(128);
+
+	EXPECT_EQ(gate.update(view(frame), 0, HoldSeconds), std::nullopt);
+	for (int i = 1; i <= 15; i++) {
+		EXPECT_EQ(gate.update(view(frame), i * FrameNs, HoldSeconds), std::nullopt) << "frame " << i;
+	}
+	EXPECT_EQ(gate.update(view(frame), 16 * FrameNs, HoldSeconds), std::optional<bool>(false));
+	EXPECT_FALSE(gate.isActive());
+}
+
+TEST(ActivityGateTest, IgnoresNoiseButWakesOnChange)
+{
+	ActivityGate gate;
+	std::vector<std::uint8_t> frame = makeFrame(128);
+	gate.update(view(frame), 0, HoldSeconds);
+	gate.update(view(frame), 20 * FrameNs, HoldSeconds);
+	ASSERT_FALSE(gate.isActive());
+
+	// Camera noise well below the sample threshold everywhere.
+	std::vector<std::uint8_t> noisy = frame;
+	for (std::size_t i = 0; i < noisy.size(); i++) {
+		noisy[i] = static_cast<std::uint8_t>(128 + static_cast<int>(i % 7) - 3);
+	}
+	EXPECT_EQ(gate.update(view(noisy), 21 * FrameNs, HoldSeconds), std::nullopt);
+
+	// A dark pen stroke across the middle of the sheet.
+	for (std::uint32_t x = 0; x < Width; x++) {
+		for (std::uint32_t y = Height / 2 - 2; y < Height / 2 + 2; y++) {
+			frame[y * Width + x] = 20;
+		}
+	}
+	EXPECT_EQ(gate.update(view(frame), 22 * FrameNs, HoldSeconds), std::optional<bool>(true));
+}
+
+TEST(ActivityGateTest, AccumulatesSlowChangesWhileStatic)
+{
+	ActivityGate gate;
+	gate.update(view(makeFrame(100)), 0, HoldSeconds);
+	gate.update(view(makeFrame(100)), 20 * FrameNs, HoldSeconds);
+	ASSERT_FALSE(gate.isActive());
+
+	// Each step is below the sample threshold, but the reference stays frozen while static.
+	std::optional<bool> changed;
+	int frameIndex = 21;
+	for (std::uint8_t level = 104; level <= 124 && !changed; level += 4) {
+		changed = gate.update(view(makeFrame(level)), frameIndex++ * FrameNs, HoldSeconds);
+	}
+	EXPECT_EQ(changed, std::optional<bool>(true));
+}
+
+TEST(ActivityGateTest, ResetTurnsActive)
+{
+	ActivityGate gate;
+	gate.update(view(makeFrame(128)), 0, HoldSeconds);
+	gate.update(view(makeFrame(128)), 20 * FrameNs, HoldSeconds);
+	ASSERT_FALSE(gate.isActive());
+	EXPECT_EQ(gate.reset(), std::optional<bool>(true));
+	EXPECT_EQ(gate.reset(), std::nullopt);
+}
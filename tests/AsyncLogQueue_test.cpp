@@ -0,0 +1,179 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "BridgeUtils/AsyncLogQueue.hpp"
+
+using namespace KaitoTokyo::BridgeUtils;
+
+namespace {
+
+constexpr int DroppedNoticeLevel = 99;
+
+struct Message {
+	int level;
+	std::string text;
+	std::thread::id thread;
+};
+
+/**
+ * @brief Records what the queue hands to its sink, optionally holding the flusher inside the sink until released.
+ */
+class RecordingSink {
+public:
+	AsyncLogQueue::Sink get()
+	{
+		return [this](int level, std::string_view text) {
+			std::unique_lock<std::mutex> lock(mutex);
+			messages.push_back({level, std::string(text), std::this_thread::get_id()});
+			cond.notify_all();
+			cond.wait(lock, [this] { return !holding; });
+		};
+	}
+
+	void hold()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		holding = true;
+	}
+
+	void release()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		holding = false;
+		cond.notify_all();
+	}
+
+	void waitForMessages(std::size_t count)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this, count] { return messages.size() >= count; });
+	}
+
+	std::vector<Message> getMessages()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return messages;
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool holding = false;
+	std::vector<Message> messages;
+};
+
+} // namespace
+
+TEST(AsyncLogQueueTest, DeliversMessagesInOrderOnTheFlusherThread)
+{
+	RecordingSink sink;
+	AsyncLogQueue queue(sink.get(), DroppedNoticeLevel, 1024);
+	for (int i = 0; i < 500; i++) {
+		EXPECT_TRUE(queue.tryPush(i % 4, std::to_string(i)));
+	}
+	queue.stop();
+
+	const std::vector<Message> messages = sink.getMessages();
+	ASSERT_EQ(messages.size(), 500u);
+	for (int i = 0; i < 500; i++) {
+		EXPECT_EQ(messages[i].level, i % 4);
+		EXPECT_EQ(messages[i].text, std::to_string(i));
+		EXPECT_NE(messages[i].thread, std::this_thread::get_id());
+	}
+	EXPECT_EQ(queue.getDroppedCount(), 0u);
+}
+
+TEST(AsyncLogQueueTest, SplitsLongMessagesAtLineBreaks)
+{
+	RecordingSink sink;
+	AsyncLogQueue queue(sink.get(), DroppedNoticeLevel);
+	const std::string firstLine = std::string(AsyncLogQueue::MaxChunkSize - 10, 'a') + "\n";
+	const std::string secondLine(20, 'b');
+	EXPECT_TRUE(queue.tryPush(1, firstLine + secondLine));
+	queue.stop();
+
+	const std::vector<Message> messages = sink.getMessages();
+	ASSERT_EQ(messages.size(), 2u);
+	EXPECT_EQ(messages[0].text, firstLine);
+	EXPECT_EQ(messages[1].text, secondLine);
+}
+
+TEST(AsyncLogQueueTest, DropsAndReportsMessagesWhenFull)
+{
+	RecordingSink sink;
+	AsyncLogQueue queue(sink.get(), DroppedNoticeLevel, 2);
+
+	// The flusher holds the first slot while it is inside the sink, which leaves one free slot.
+	sink.hold();
+	EXPECT_TRUE(queue.tryPush(1, "first"));
+	sink.waitForMessages(1);
+	EXPECT_TRUE(queue.tryPush(1, "second"));
+	EXPECT_FALSE(queue.tryPush(1, "third"));
+	EXPECT_FALSE(queue.tryPush(1, "fourth"));
+	EXPECT_EQ(queue.getDroppedCount(), 2u);
+
+	sink.release();
+	queue.stop();
+
+	const std::vector<Message> messages = sink.getMessages();
+	ASSERT_EQ(messages.size(), 3u);
+	EXPECT_EQ(messages[0].text, "first");
+	EXPECT_EQ(messages[1].text, "second");
+	EXPECT_EQ(messages[2].level, DroppedNoticeLevel);
+	EXPECT_NE(messages[2].text.find("2 log messages were dropped"), std::string::npos);
+}
+
+TEST(AsyncLogQueueTest, StopFlushesEveryQueuedMessage)
+{
+	RecordingSink sink;
+	AsyncLogQueue queue(sink.get(), DroppedNoticeLevel, 64);
+
+	sink.hold();
+	EXPECT_TRUE(queue.tryPush(1, "held"));
+	sink.waitForMessages(1);
+	for (int i = 0; i < 10; i++) {
+		EXPECT_TRUE(queue.tryPush(1, std::to_string(i)));
+	}
+	sink.release();
+	queue.stop();
+
+	EXPECT_EQ(sink.getMessages().size(), 11u);
+}
+
+TEST(AsyncLogQueueTest, HandsMessagesToTheSinkDirectlyOnceStopped)
+{
+	RecordingSink sink;
+	AsyncLogQueue queue(sink.get(), DroppedNoticeLevel);
+	queue.stop();
+	queue.stop();
+
+	EXPECT_TRUE(queue.tryPush(2, "late"));
+	const std::vector<Message> messages = sink.getMessages();
+	ASSERT_EQ(messages.size(), 1u);
+	EXPECT_EQ(messages[0].text, "late");
+	EXPECT_EQ(messages[0].thread, std::this_thread::get_id());
+}
@@ -0,0 +1,99 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "Core/AutoCalibrator.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+
+namespace {
+
+std::vector<BlockStats> makeBlocks(int paperBlocks, float paperLevel, int strokeBlocks, float strokeLevel)
+{
+	std::vector<BlockStats> blocks;
+	for (int i = 0; i < paperBlocks; i++) {
+		blocks.push_back({paperLevel, paperLevel * paperLevel, paperLevel * 2.0f});
+	}
+	for (int i = 0; i < strokeBlocks; i++) {
+		blocks.push_back({strokeLevel * 0.3f, strokeLevel * strokeLevel * 0.3f, strokeLevel});
+	}
+	return blocks;
+}
+
+} // namespace
+
+TEST(AutoCalibratorTest, HasNoValuesBeforeTheFirstMeasurement)
+{
+	AutoCalibrator calibrator;
+	calibrator.updateSobel({}, true);
+	EXPECT_FALSE(calibrator.getSobelScalingFactor());
+	EXPECT_FALSE(calibrator.getMotionThreshold());
+}
+
+TEST(AutoCalibratorTest, MapsTheStrokeLevelToFullScale)
+{
+	AutoCalibrator calibrator;
+	calibrator.updateSobel(makeBlocks(70, 0.01f, 30, 0.25f), false);
+	EXPECT_NEAR(*calibrator.getSobelScalingFactor(), 4.0f, 1e-4f);
+
+	AutoCalibrator logCalibrator;
+	logCalibrator.updateSobel(makeBlocks(70, 0.01f, 30, 0.25f), true);
+	EXPECT_NEAR(*logCalibrator.getSobelScalingFactor(), 1.0f / std::log2(1.25f), 1e-4f);
+}
+
+TEST(AutoCalibratorTest, DoesNotAmplifyTheNoiseOfABlankSheet)
+{
+	AutoCalibrator calibrator;
+	calibrator.updateSobel(makeBlocks(100, 0.05f, 0, 0.0f), false);
+	// The stroke level is floored at four times the median noise.
+	EXPECT_NEAR(*calibrator.getSobelScalingFactor(), 5.0f, 1e-4f);
+
+	AutoCalibrator silentCalibrator;
+	silentCalibrator.updateSobel(makeBlocks(100, 0.0f, 0, 0.0f), false);
+	EXPECT_FLOAT_EQ(*silentCalibrator.getSobelScalingFactor(), AutoCalibrator::MaxSobelScalingFactor);
+}
+
+TEST(AutoCalibratorTest, PlacesTheMotionThresholdAboveTheNoise)
+{
+	AutoCalibrator calibrator;
+	std::vector<BlockStats> blocks(100, BlockStats{0.04f, 0.04f * 0.04f + 0.01f * 0.01f, 0.1f});
+	calibrator.updateMotion(blocks);
+	EXPECT_NEAR(*calibrator.getMotionThreshold(), 0.04f + 3.0f * 0.01f, 1e-4f);
+
+	AutoCalibrator quietCalibrator;
+	quietCalibrator.updateMotion(std::vector<BlockStats>(100, BlockStats{0.0f, 0.0f, 0.0f}));
+	EXPECT_FLOAT_EQ(*quietCalibrator.getMotionThreshold(), AutoCalibrator::MinMotionThreshold);
+}
+
+TEST(AutoCalibratorTest, SmoothsTowardsNewTargets)
+{
+	AutoCalibrator calibrator;
+	calibrator.updateMotion(std::vector<BlockStats>(10, BlockStats{0.1f, 0.01f, 0.1f}));
+	calibrator.updateMotion(std::vector<BlockStats>(10, BlockStats{0.3f, 0.09f, 0.3f}));
+	const float afterOne = *calibrator.getMotionThreshold();
+	EXPECT_NEAR(afterOne, 0.1f + AutoCalibrator::SmoothingFactor * 0.2f, 1e-4f);
+
+	for (int i = 0; i < 200; i++) {
+		calibrator.updateMotion(std::vector<BlockStats>(10, BlockStats{0.3f, 0.09f, 0.3f}));
+	}
+	EXPECT_NEAR(*calibrator.getMotionThreshold(), 0.3f, 1e-3f);
+}
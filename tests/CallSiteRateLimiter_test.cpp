@@ -0,0 +1,97 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "BridgeUtils/ILogger.hpp"
+
+using KaitoTokyo::BridgeUtils::ILoggerDetail::CallSiteRateLimiter;
+
+namespace {
+
+constexpr std::uint32_t MaxMessages = CallSiteRateLimiter::MaxMessagesPerWindow;
+constexpr std::int64_t WindowNs = CallSiteRateLimiter::WindowNs;
+// A steady clock reading well past zero, as the limiter sees in practice.
+constexpr std::int64_t Now = 10 * WindowNs;
+
+const char siteA[] = "a";
+const char siteB[] = "b";
+
+} // namespace
+
+TEST(CallSiteRateLimiterTest, AdmitsUpToTheLimitPerWindow)
+{
+	CallSiteRateLimiter limiter;
+	std::uint32_t suppressed = 1;
+	for (std::uint32_t i = 0; i < MaxMessages; i++) {
+		EXPECT_TRUE(limiter.admit(siteA, Now + i, suppressed));
+		EXPECT_EQ(suppressed, 0u);
+	}
+	EXPECT_FALSE(limiter.admit(siteA, Now + 1, suppressed));
+	EXPECT_FALSE(limiter.admit(siteA, Now + WindowNs - 1, suppressed));
+}
+
+TEST(CallSiteRateLimiterTest, ReportsSuppressedMessagesInTheNextWindow)
+{
+	CallSiteRateLimiter limiter;
+	std::uint32_t suppressed = 0;
+	for (std::uint32_t i = 0; i < MaxMessages + 3; i++) {
+		limiter.admit(siteA, Now, suppressed);
+	}
+
+	EXPECT_TRUE(limiter.admit(siteA, Now + WindowNs, suppressed));
+	EXPECT_EQ(suppressed, 3u);
+	EXPECT_TRUE(limiter.admit(siteA, Now + WindowNs, suppressed));
+	EXPECT_EQ(suppressed, 0u);
+}
+
+TEST(CallSiteRateLimiterTest, LimitsEachCallSiteSeparately)
+{
+	CallSiteRateLimiter limiter;
+	std::uint32_t suppressed = 0;
+	for (std::uint32_t i = 0; i < MaxMessages; i++) {
+		EXPECT_TRUE(limiter.admit(siteA, Now, suppressed));
+	}
+	EXPECT_FALSE(limiter.admit(siteA, Now, suppressed));
+
+	EXPECT_TRUE(limiter.admit(siteB, Now, suppressed));
+	EXPECT_EQ(suppressed, 0u);
+}
+
+TEST(CallSiteRateLimiterTest, AdmitsEverythingFromCallSitesWithoutASlot)
+{
+	CallSiteRateLimiter limiter;
+	std::uint32_t suppressed = 0;
+	static char sites[CallSiteRateLimiter::SlotCount * 4];
+
+	// Only SlotCount call sites can hold a slot, and the rest are never limited rather than hidden.
+	std::size_t unlimitedSites = 0;
+	for (const char &site : sites) {
+		std::uint32_t admitted = 0;
+		for (std::uint32_t i = 0; i < MaxMessages + 1; i++) {
+			admitted += limiter.admit(&site, Now, suppressed) ? 1 : 0;
+		}
+		EXPECT_GE(admitted, MaxMessages);
+		unlimitedSites += admitted > MaxMessages ? 1 : 0;
+	}
+	EXPECT_GE(unlimitedSites, std::size(sites) - CallSiteRateLimiter::SlotCount);
+}
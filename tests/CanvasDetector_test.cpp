@@ -0,0 +1,137 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "CpuEngine/CanvasDetector.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+
+namespace {
+
+constexpr std::size_t Width = 160;
+constexpr std::size_t Height = 90;
+
+/**
+ * @brief A bright sheet on a darker desk, with the sheet given in normalized coordinates.
+ */
+LumaImage drawSheet(const CanvasQuad &sheet)
+{
+	const Homography toSheet = *computeUnitSquareToQuad(sheet);
+	LumaImage image(Width, Height, 60);
+	for (std::size_t y = 0; y < Height; y++) {
+		for (std::size_t x = 0; x < Width; x++) {
+			image.pixels[y * Width + x] = static_cast<std::uint8_t>(50 + (x + 3 * y) % 20);
+		}
+	}
+	// Scan the sheet densely in its own coordinates so that every covered pixel is painted.
+	for (int v = 0; v <= 1000; v++) {
+		for (int u = 0; u <= 1000; u++) {
+			const CanvasPoint p = applyHomography(toSheet, {u / 1000.0f, v / 1000.0f});
+			const auto x = static_cast<std::size_t>(p.x * Width);
+			const auto y = static_cast<std::size_t>(p.y * Height);
+			if (x < Width && y < Height) {
+				image.pixels[y * Width + x] = 220;
+			}
+		}
+	}
+	return image;
+}
+
+void expectNear(const CanvasQuad &expected, const CanvasQuad &actual)
+{
+	for (std::size_t i = 0; i < 4; i++) {
+		EXPECT_NEAR(expected.corners[i].x, actual.corners[i].x, 2.0 / Width) << "corner " << i;
+		EXPECT_NEAR(expected.corners[i].y, actual.corners[i].y, 2.0 / Height) << "corner " << i;
+	}
+}
+
+} // namespace
+
+TEST(CanvasDetectorTest, HomographyMapsTheUnitSquareToTheQuad)
+{
+	const CanvasQuad quad{{{{0.1f, 0.2f}, {0.8f, 0.1f}, {0.9f, 0.7f}, {0.2f, 0.9f}}}};
+	const Homography h = *computeUnitSquareToQuad(quad);
+	const CanvasPoint square[] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+	for (std::size_t i = 0; i < 4; i++) {
+		const CanvasPoint p = applyHomography(h, square[i]);
+		EXPECT_NEAR(p.x, quad.corners[i].x, 1e-5);
+		EXPECT_NEAR(p.y, quad.corners[i].y, 1e-5);
+	}
+}
+
+TEST(CanvasDetectorTest, RejectsCollinearCorners)
+{
+	const CanvasQuad quad{{{{0.0f, 0.0f}, {0.5f, 0.5f}, {1.0f, 1.0f}, {0.0f, 1.0f}}}};
+	EXPECT_FALSE(computeUnitSquareToQuad(quad));
+}
+
+TEST(CanvasDetectorTest, FindsAStraightSheet)
+{
+	const CanvasQuad sheet{{{{0.25f, 0.2f}, {0.75f, 0.2f}, {0.75f, 0.8f}, {0.25f, 0.8f}}}};
+	CanvasDetector detector;
+	const std::optional<CanvasQuad> detected = detector.detect(drawSheet(sheet).view());
+	ASSERT_TRUE(detected);
+	expectNear(sheet, *detected);
+}
+
+TEST(CanvasDetectorTest, FindsAPerspectiveSheet)
+{
+	const CanvasQuad sheet{{{{0.3f, 0.15f}, {0.7f, 0.2f}, {0.85f, 0.85f}, {0.15f, 0.8f}}}};
+	CanvasDetector detector;
+	const std::optional<CanvasQuad> detected = detector.detect(drawSheet(sheet).view());
+	ASSERT_TRUE(detected);
+	expectNear(sheet, *detected);
+}
+
+TEST(CanvasDetectorTest, FindsASheetRotatedBy45Degrees)
+{
+	const CanvasQuad sheet{{{{0.5f, 0.1f}, {0.75f, 0.5f}, {0.5f, 0.9f}, {0.25f, 0.5f}}}};
+	CanvasDetector detector;
+	const std::optional<CanvasQuad> detected = detector.detect(drawSheet(sheet).view());
+	ASSERT_TRUE(detected);
+	expectNear(sheet, *detected);
+}
+
+TEST(CanvasDetectorTest, IgnoresSmallBrightSpots)
+{
+	const CanvasQuad spot{{{{0.1f, 0.1f}, {0.2f, 0.1f}, {0.2f, 0.2f}, {0.1f, 0.2f}}}};
+	CanvasDetector detector;
+	EXPECT_FALSE(detector.detect(drawSheet(spot).view()));
+}
+
+TEST(CanvasDetectorTest, TrackerKeepsTheQuadThroughSmallMovesAndMisses)
+{
+	CanvasTracker tracker;
+	EXPECT_FALSE(tracker.get());
+
+	CanvasQuad quad = CanvasQuad::fullImage();
+	tracker.update(quad);
+	CanvasQuad nudged = quad;
+	nudged.corners[0].x += CanvasTracker::MinCornerShift / 2;
+	tracker.update(nudged);
+	tracker.update(std::nullopt);
+	EXPECT_EQ(tracker.get()->corners[0].x, 0.0f);
+
+	nudged.corners[0].x = 0.2f;
+	tracker.update(nudged);
+	EXPECT_EQ(tracker.get()->corners[0].x, 0.2f);
+}
@@ -0,0 +1,152 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <optional>
+#include <stdexcept>
+
+#include "Core/ContextRebuilder.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+
+namespace {
+
+struct Context {
+	int size;
+};
+
+struct Factory {
+	int builds = 0;
+
+	std::shared_ptr<Context> operator()(int size)
+	{
+		builds++;
+		return std::make_shared<Context>(Context{size});
+	}
+};
+
+} // namespace
+
+TEST(ContextRebuilderTest, BuildsOnlyWhenRebuilding)
+{
+	ContextRebuilder<Context, int> rebuilder;
+	Factory factory;
+
+	EXPECT_EQ(rebuilder.acquire(640), nullptr);
+	EXPECT_EQ(factory.builds, 0);
+
+	EXPECT_TRUE(rebuilder.rebuild(factory));
+	EXPECT_EQ(factory.builds, 1);
+	const std::shared_ptr<Context> context = rebuilder.acquire(640);
+	ASSERT_NE(context, nullptr);
+	EXPECT_EQ(context->size, 640);
+	EXPECT_FALSE(rebuilder.rebuild(factory));
+}
+
+TEST(ContextRebuilderTest, KeepsTheOldContextUntilTheNewOneIsBuilt)
+{
+	ContextRebuilder<Context, int> rebuilder;
+	Factory factory;
+	rebuilder.acquire(640);
+	rebuilder.rebuild(factory);
+	const std::shared_ptr<Context> old = rebuilder.get();
+
+	EXPECT_EQ(rebuilder.acquire(1280), nullptr);
+	EXPECT_EQ(rebuilder.get(), old);
+
+	EXPECT_TRUE(rebuilder.rebuild(factory));
+	ASSERT_NE(rebuilder.get(), nullptr);
+	EXPECT_EQ(rebuilder.get()->size, 1280);
+	// Whoever loaded the old context keeps it alive.
+	EXPECT_EQ(old->size, 640);
+}
+
+TEST(ContextRebuilderTest, BuildsOnlyTheLatestRequest)
+{
+	ContextRebuilder<Context, int> rebuilder;
+	Factory factory;
+	rebuilder.acquire(640);
+	rebuilder.acquire(1280);
+	rebuilder.acquire(1920);
+
+	EXPECT_TRUE(rebuilder.rebuild(factory));
+	EXPECT_EQ(factory.builds, 1);
+	EXPECT_EQ(rebuilder.get()->size, 1920);
+}
+
+TEST(ContextRebuilderTest, SkipsARequestForThePublishedSpec)
+{
+	ContextRebuilder<Context, int> rebuilder;
+	Factory factory;
+	rebuilder.acquire(640);
+	rebuilder.rebuild(factory);
+
+	// The size changed and changed back before the render thread got to it.
+	rebuilder.acquire(1280);
+	EXPECT_NE(rebuilder.acquire(640), nullptr);
+	EXPECT_FALSE(rebuilder.rebuild(factory));
+	EXPECT_EQ(factory.builds, 1);
+}
+
+TEST(ContextRebuilderTest, DropsTheContextOnRequest)
+{
+	ContextRebuilder<Context, int> rebuilder;
+	Factory factory;
+	rebuilder.acquire(640);
+	rebuilder.rebuild(factory);
+
+	EXPECT_EQ(rebuilder.acquire(std::nullopt), nullptr);
+	EXPECT_NE(rebuilder.get(), nullptr);
+	EXPECT_TRUE(rebuilder.rebuild(factory));
+	EXPECT_EQ(rebuilder.get(), nullptr);
+	EXPECT_EQ(factory.builds, 1);
+}
+
+TEST(ContextRebuilderTest, KeepsTheOldContextWhenBuildingFails)
+{
+	ContextRebuilder<Context, int> rebuilder;
+	Factory factory;
+	rebuilder.acquire(640);
+	rebuilder.rebuild(factory);
+	const std::shared_ptr<Context> old = rebuilder.get();
+
+	rebuilder.acquire(1280);
+	EXPECT_THROW(rebuilder.rebuild([](int) -> std::shared_ptr<Context> { throw std::runtime_error("failed"); }),
+		     std::runtime_error);
+	EXPECT_EQ(rebuilder.get(), old);
+	// The request was dropped, and the next frame asks again.
+	EXPECT_FALSE(rebuilder.rebuild(factory));
+	rebuilder.acquire(1280);
+	EXPECT_TRUE(rebuilder.rebuild(factory));
+	EXPECT_EQ(rebuilder.get()->size, 1280);
+}
+
+TEST(ContextRebuilderTest, ResetDropsTheContextAndTheRequest)
+{
+	ContextRebuilder<Context, int> rebuilder;
+	Factory factory;
+	rebuilder.acquire(640);
+	rebuilder.rebuild(factory);
+	rebuilder.acquire(1280);
+
+	rebuilder.reset();
+	EXPECT_EQ(rebuilder.get(), nullptr);
+	EXPECT_FALSE(rebuilder.rebuild(factory));
+}
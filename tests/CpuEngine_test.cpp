@@ -0,0 +1,244 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "CpuEngine/CpuEngine.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+
+namespace {
+
+constexpr std::size_t Width = 67;
+constexpr std::size_t Height = 29;
+
+LumaImage makeRandomImage(std::uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	LumaImage image(Width, Height);
+	for (auto &pixel : image.pixels) {
+		pixel = static_cast<std::uint8_t>(rng());
+	}
+	return image;
+}
+
+std::vector<std::uint8_t> toVector(const ConstLumaView &view)
+{
+	std::vector<std::uint8_t> result;
+	for (std::size_t y = 0; y < view.height; y++) {
+		result.insert(result.end(), view.row(y), view.row(y) + view.width);
+	}
+	return result;
+}
+
+/**
+ * @brief The stage-by-stage composition of the frame operations that CpuEngine streams.
+ */
+struct StageByStageReference {
+	const KernelSet &k;
+	LumaImage previous;
+	LumaImage motionMap;
+
+	StageByStageReference(const KernelSet &_k, std::size_t width, std::size_t height)
+		: k(_k),
+		  previous(width, height),
+		  motionMap(width, height)
+	{
+	}
+
+	LumaImage process(const LumaImage &input, const PresetSnapshot &snapshot)
+	{
+		const Preset &preset = snapshot.preset;
+		const PresetConstants &constants = snapshot.constants;
+		LumaImage grayscale = input;
+		if (preset.medianFilterEnabled) {
+			LumaImage median(input.width, input.height);
+			applyMedian3x3(k, grayscale.view(), median.view());
+			grayscale = median;
+		}
+		if (preset.motionAdaptiveFilteringStrength > 0.0) {
+			LumaImage filtered(input.width, input.height);
+			calculateMotionMap(k, grayscale.view(), previous.view(), motionMap.view());
+			applyMotionAdaptiveFilter(k, grayscale.view(), previous.view(), motionMap.view(), filtered.view(),
+						  MotionAdaptiveTable::create(constants.motionAdaptiveFilteringStrength,
+									      constants.motionAdaptiveFilteringMotionThreshold));
+			previous = filtered;
+			grayscale = filtered;
+		}
+		if (preset.extractionMode == ExtractionMode::ConvertToGrayscale) {
+			return grayscale;
+		}
+		if (preset.extractionMode == ExtractionMode::MotionMapCalculation) {
+			return motionMap;
+		}
+		LumaImage sobel(input.width, input.height), output(input.width, input.height);
+		applySobelMagnitude(k, grayscale.view(), sobel.view());
+		applyFinalizeSobelMagnitude(sobel.view(), output.view(),
+					    FinalizeTable::create(constants.sobelUseLog, constants.sobelScalingFactor));
+		return output;
+	}
+};
+
+} // namespace
+
+TEST(CpuEngineTest, PassthroughReturnsInput)
+{
+	Preset preset;
+	preset.extractionMode = ExtractionMode::Passthrough;
+	const PresetSnapshot snapshot(preset, 1);
+
+	CpuEngine engine(Width, Height);
+	const LumaImage input = makeRandomImage(1);
+	EXPECT_EQ(engine.processLuma(input.view(), snapshot).data, input.pixels.data());
+}
+
+TEST(CpuEngineTest, MatchesComposedKernelsAcrossFrames)
+{
+	const Preset preset;
+	const PresetSnapshot snapshot(preset, 1);
+	const KernelSet &k = getScalarKernels();
+	CpuEngine engine(Width, Height, k);
+
+	const MotionAdaptiveTable motionTable =
+		MotionAdaptiveTable::create(snapshot.constants.motionAdaptiveFilteringStrength,
+					    snapshot.constants.motionAdaptiveFilteringMotionThreshold);
+	const FinalizeTable finalizeTable =
+		FinalizeTable::create(snapshot.constants.sobelUseLog, snapshot.constants.sobelScalingFactor);
+
+	// The previous motion-adaptive output starts black, as a freshly created texture does.
+	LumaImage previous(Width, Height);
+	for (std::uint32_t frame = 0; frame < 3; frame++) {
+		const LumaImage input = makeRandomImage(10 + frame);
+
+		LumaImage median(Width, Height), motion(Width, Height), filtered(Width, Height);
+		LumaImage sobel(Width, Height), expected(Width, Height);
+		applyMedian3x3(k, input.view(), median.view());
+		calculateMotionMap(k, median.view(), previous.view(), motion.view());
+		applyMotionAdaptiveFilter(k, median.view(), previous.view(), motion.view(), filtered.view(), motionTable);
+		applySobelMagnitude(k, filtered.view(), sobel.view());
+		applyFinalizeSobelMagnitude(sobel.view(), expected.view(), finalizeTable);
+		previous = filtered;
+
+		EXPECT_EQ(toVector(engine.processLuma(input.view(), snapshot)), expected.pixels) << "frame " << frame;
+	}
+}
+
+TEST(CpuEngineTest, BuildsTablesForTheFirstSnapshotWhateverItsEpoch)
+{
+	const PresetSnapshot snapshot(Preset{}, 0);
+	const KernelSet &k = getScalarKernels();
+	CpuEngine engine(Width, Height, k);
+	StageByStageReference reference(k, Width, Height);
+
+	const LumaImage input = makeRandomImage(7);
+	EXPECT_EQ(toVector(engine.processLuma(input.view(), snapshot)), reference.process(input, snapshot).pixels);
+}
+
+TEST(CpuEngineTest, ThreadPoolMatchesSerialEngine)
+{
+	// Tall enough to be split into several bands.
+	constexpr std::size_t TallHeight = CpuEngine::MinBandRows * 5 + 3;
+	KaitoTokyo::BridgeUtils::WorkStealingThreadPool threadPool(4);
+	CpuEngine serial(Width, TallHeight);
+	CpuEngine parallel(Width, TallHeight, getKernels(), &threadPool);
+	ASSERT_GT(parallel.getBandCount(), 1u);
+
+	std::mt19937 rng(7);
+	for (ExtractionMode mode : {ExtractionMode::ConvertToGrayscale, ExtractionMode::MotionMapCalculation,
+				    ExtractionMode::SobelMagnitude}) {
+		Preset preset;
+		preset.extractionMode = mode;
+		const PresetSnapshot snapshot(preset, static_cast<std::uint64_t>(mode));
+		for (std::uint32_t frame = 0; frame < 3; frame++) {
+			LumaImage input(Width, TallHeight);
+			for (auto &pixel : input.pixels) {
+				pixel = static_cast<std::uint8_t>(rng());
+			}
+			EXPECT_EQ(toVector(parallel.processLuma(input.view(), snapshot)),
+				  toVector(serial.processLuma(input.view(), snapshot)))
+				<< "mode " << static_cast<int>(mode) << " frame " << frame;
+		}
+	}
+}
+
+TEST(CpuEngineTest, StreamingMatchesStageByStageForEveryStageCombination)
+{
+	constexpr std::size_t TallHeight = CpuEngine::MinBandRows * 3 + 1;
+	KaitoTokyo::BridgeUtils::WorkStealingThreadPool threadPool(3);
+	std::mt19937 rng(11);
+
+	for (bool threaded : {false, true}) {
+		for (ExtractionMode mode : {ExtractionMode::ConvertToGrayscale, ExtractionMode::MotionMapCalculation,
+					    ExtractionMode::SobelMagnitude}) {
+			for (int stages = 0; stages < 4; stages++) {
+				Preset preset;
+				preset.extractionMode = mode;
+				preset.medianFilterEnabled = (stages & 1) != 0;
+				preset.motionAdaptiveFilteringStrength = (stages & 2) != 0 ? 0.5 : 0.0;
+				const PresetSnapshot snapshot(preset, 1);
+
+				CpuEngine engine(Width, TallHeight, getKernels(), threaded ? &threadPool : nullptr);
+				StageByStageReference reference(getKernels(), Width, TallHeight);
+				for (std::uint32_t frame = 0; frame < 3; frame++) {
+					LumaImage input(Width, TallHeight);
+					for (auto &pixel : input.pixels) {
+						pixel = static_cast<std::uint8_t>(rng());
+					}
+					EXPECT_EQ(toVector(engine.processLuma(input.view(), snapshot)),
+						  reference.process(input, snapshot).pixels)
+						<< "threaded " << threaded << " mode " << static_cast<int>(mode)
+						<< " stages " << stages << " frame " << frame;
+				}
+			}
+		}
+	}
+}
+
+TEST(CpuEngineTest, BgraStreamingMatchesConvertedLuma)
+{
+	const PresetSnapshot snapshot(Preset{}, 1);
+	CpuEngine fromBgra(Width, Height);
+	CpuEngine fromLuma(Width, Height);
+
+	std::mt19937 rng(5);
+	for (std::uint32_t frame = 0; frame < 2; frame++) {
+		std::vector<std::uint8_t> bgra(Width * Height * 4);
+		for (auto &byte : bgra) {
+			byte = static_cast<std::uint8_t>(rng());
+		}
+		const ImageView<const std::uint8_t> bgraView{bgra.data(), Width, Height, Width * 4};
+		LumaImage luma(Width, Height);
+		convertBgraToLuma(getKernels(), bgraView, luma.view());
+
+		EXPECT_EQ(toVector(fromBgra.processBgra(bgraView, snapshot)),
+			  toVector(fromLuma.processLuma(luma.view(), snapshot)))
+			<< "frame " << frame;
+	}
+}
+
+TEST(CpuEngineTest, RejectsMismatchedFrameSize)
+{
+	const PresetSnapshot snapshot(Preset{}, 1);
+	CpuEngine engine(Width, Height);
+	const LumaImage input(Width + 1, Height);
+	EXPECT_THROW(engine.processLuma(input.view(), snapshot), std::invalid_argument);
+}
@@ -0,0 +1,343 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "CpuKernels/CpuKernels.hpp"
+
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+
+namespace {
+
+struct Size {
+	std::size_t width;
+	std::size_t height;
+};
+
+const Size testSizes[] = {{1, 1}, {2, 3}, {3, 2}, {37, 19}, {130, 67}};
+
+LumaImage makeRandomImage(std::size_t width, std::size_t height, std::uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> dist(0, 255);
+	LumaImage image(width, height);
+	for (auto &pixel : image.pixels) {
+		pixel = static_cast<std::uint8_t>(dist(rng));
+	}
+	return image;
+}
+
+std::vector<const KernelSet *> getSimdKernels()
+{
+	std::vector<const KernelSet *> result;
+	for (KernelIsa isa : {KernelIsa::Sse41, KernelIsa::Avx2, KernelIsa::Neon}) {
+		if (const KernelSet *kernels = getKernels(isa)) {
+			result.push_back(kernels);
+		}
+	}
+	return result;
+}
+
+float sampleClamped(const LumaImage &image, std::ptrdiff_t x, std::ptrdiff_t y)
+{
+	const auto cx = std::clamp<std::ptrdiff_t>(x, 0, static_cast<std::ptrdiff_t>(image.width) - 1);
+	const auto cy = std::clamp<std::ptrdiff_t>(y, 0, static_cast<std::ptrdiff_t>(image.height) - 1);
+	return image.pixels[static_cast<std::size_t>(cy) * image.width + static_cast<std::size_t>(cx)] / 255.0f;
+}
+
+std::uint8_t toUnorm8(float value)
+{
+	return static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+void expectWithin(const LumaImage &expected, const LumaImage &actual, int tolerance)
+{
+	ASSERT_EQ(expected.pixels.size(), actual.pixels.size());
+	for (std::size_t i = 0; i < expected.pixels.size(); i++) {
+		ASSERT_LE(std::abs(expected.pixels[i] - actual.pixels[i]), tolerance) << "at pixel " << i;
+	}
+}
+
+// Runs every frame operation and concatenates the results so that variants can be compared at once.
+std::vector<LumaImage> runAllStages(const KernelSet &k, Size size)
+{
+	const LumaImage current = makeRandomImage(size.width, size.height, 1);
+	const LumaImage previous = makeRandomImage(size.width, size.height, 2);
+
+	std::vector<std::uint8_t> bgra(size.width * size.height * 4);
+	std::mt19937 rng(3);
+	for (auto &byte : bgra) {
+		byte = static_cast<std::uint8_t>(rng());
+	}
+
+	std::vector<LumaImage> results(8, LumaImage(size.width, size.height));
+	convertBgraToLuma(k, {bgra.data(), size.width, size.height, size.width * 4}, results[0].view());
+	applyMedian3x3(k, current.view(), results[1].view());
+	applyErosion3x3(k, current.view(), results[2].view());
+	applyDilation3x3(k, current.view(), results[3].view());
+	calculateMotionMap(k, current.view(), previous.view(), results[4].view());
+	applyMotionAdaptiveFilter(k, current.view(), previous.view(), results[4].view(), results[5].view(),
+				  MotionAdaptiveTable::create(0.5f, 0.3f));
+	applySobelMagnitude(k, current.view(), results[6].view());
+	applyFinalizeSobelMagnitude(results[6].view(), results[7].view(), FinalizeTable::create(true, 2.0f));
+	return results;
+}
+
+} // namespace
+
+TEST(CpuKernelsTest, DispatchSelectsSupportedKernels)
+{
+	const KernelSet &best = getKernels();
+	EXPECT_EQ(getKernels(best.isa), &best);
+	EXPECT_EQ(getKernels(KernelIsa::Scalar), &getScalarKernels());
+}
+
+TEST(CpuKernelsTest, SimdVariantsAreBitExact)
+{
+	for (const KernelSet *kernels : getSimdKernels()) {
+		for (const Size &size : testSizes) {
+			SCOPED_TRACE(std::string(kernels->name) + " " + std::to_string(size.width) + "x" +
+				     std::to_string(size.height));
+			const auto expected = runAllStages(getScalarKernels(), size);
+			const auto actual = runAllStages(*kernels, size);
+			for (std::size_t stage = 0; stage < expected.size(); stage++) {
+				SCOPED_TRACE("stage " + std::to_string(stage));
+				EXPECT_EQ(expected[stage].pixels, actual[stage].pixels);
+			}
+		}
+	}
+}
+
+TEST(CpuKernelsTest, BandsMatchFrameOperations)
+{
+	const KernelSet &k = getKernels();
+	for (const Size &size : testSizes) {
+		SCOPED_TRACE(std::to_string(size.width) + "x" + std::to_string(size.height));
+		const LumaImage current = makeRandomImage(size.width, size.height, 1);
+		const LumaImage previous = makeRandomImage(size.width, size.height, 2);
+
+		using FrameOp = std::function<void(const LumaView &, std::size_t, std::size_t)>;
+		const std::vector<FrameOp> ops = {
+			[&](const LumaView &dst, std::size_t b, std::size_t e) {
+				applyMedian3x3(k, current.view(), dst, b, e);
+			},
+			[&](const LumaView &dst, std::size_t b, std::size_t e) {
+				applyErosion3x3(k, current.view(), dst, b, e);
+			},
+			[&](const LumaView &dst, std::size_t b, std::size_t e) {
+				applyDilation3x3(k, current.view(), dst, b, e);
+			},
+			[&](const LumaView &dst, std::size_t b, std::size_t e) {
+				calculateMotionMap(k, current.view(), previous.view(), dst, b, e);
+			},
+			[&](const LumaView &dst, std::size_t b, std::size_t e) {
+				applySobelMagnitude(k, current.view(), dst, b, e);
+			},
+		};
+		for (std::size_t op = 0; op < ops.size(); op++) {
+			SCOPED_TRACE("op " + std::to_string(op));
+			LumaImage expected(size.width, size.height);
+			ops[op](expected.view(), 0, size.height);
+
+			// Bands of one row exercise the halo on both sides of every row.
+			LumaImage banded(size.width, size.height);
+			for (std::size_t y = 0; y < size.height; y++) {
+				ops[op](banded.view(), y, y + 1);
+			}
+			EXPECT_EQ(expected.pixels, banded.pixels);
+		}
+	}
+}
+
+TEST(CpuKernelsTest, SobelSaturatesOnStrongEdges)
+{
+	LumaImage image(64, 3);
+	for (std::size_t x = 0; x < image.width; x++) {
+		image.pixels[image.width + x] = 255;
+		image.pixels[2 * image.width + x] = (x % 2) ? 255 : 0;
+	}
+	LumaImage expected(64, 3);
+	applySobelMagnitude(getScalarKernels(), image.view(), expected.view());
+	for (const KernelSet *kernels : getSimdKernels()) {
+		LumaImage actual(64, 3);
+		applySobelMagnitude(*kernels, image.view(), actual.view());
+		EXPECT_EQ(expected.pixels, actual.pixels) << kernels->name;
+	}
+}
+
+TEST(CpuKernelsTest, ConvertGrayscaleMatchesShader)
+{
+	std::vector<std::uint8_t> bgra;
+	for (int r = 0; r < 256; r += 5) {
+		for (int g = 0; g < 256; g += 3) {
+			for (int b = 0; b < 256; b += 7) {
+				bgra.insert(bgra.end(), {static_cast<std::uint8_t>(b), static_cast<std::uint8_t>(g),
+							 static_cast<std::uint8_t>(r), 255});
+			}
+		}
+	}
+	const std::size_t count = bgra.size() / 4;
+	LumaImage expected(count, 1), actual(count, 1);
+	for (std::size_t i = 0; i < count; i++) {
+		const float luma = 0.2126f * bgra[i * 4 + 2] / 255.0f + 0.7152f * bgra[i * 4 + 1] / 255.0f +
+				   0.0722f * bgra[i * 4] / 255.0f;
+		expected.pixels[i] = toUnorm8(luma);
+	}
+	convertBgraToLuma(getKernels(), {bgra.data(), count, 1, count * 4}, actual.view());
+	expectWithin(expected, actual, 1);
+}
+
+TEST(CpuKernelsTest, SeparableFiltersMatchShader)
+{
+	const LumaImage src = makeRandomImage(37, 19, 4);
+	const auto w = static_cast<std::ptrdiff_t>(src.width), h = static_cast<std::ptrdiff_t>(src.height);
+
+	auto reference = [&](const std::function<float(float, float, float)> &op) {
+		std::vector<float> mid(src.pixels.size());
+		for (std::ptrdiff_t y = 0; y < h; y++) {
+			for (std::ptrdiff_t x = 0; x < w; x++) {
+				mid[y * w + x] = op(sampleClamped(src, x - 1, y), sampleClamped(src, x, y),
+						    sampleClamped(src, x + 1, y));
+			}
+		}
+		LumaImage result(src.width, src.height);
+		for (std::ptrdiff_t y = 0; y < h; y++) {
+			for (std::ptrdiff_t x = 0; x < w; x++) {
+				const float a = mid[std::max<std::ptrdiff_t>(y - 1, 0) * w + x];
+				const float b = mid[y * w + x];
+				const float c = mid[std::min<std::ptrdiff_t>(y + 1, h - 1) * w + x];
+				result.pixels[y * w + x] = toUnorm8(op(a, b, c));
+			}
+		}
+		return result;
+	};
+
+	const auto median = [](float a, float b, float c) {
+		return std::max(std::min(a, b), std::min(std::max(a, b), c));
+	};
+	const auto minimum = [](float a, float b, float c) { return std::min(a, std::min(b, c)); };
+	const auto maximum = [](float a, float b, float c) { return std::max(a, std::max(b, c)); };
+
+	LumaImage actual(src.width, src.height);
+	applyMedian3x3(getKernels(), src.view(), actual.view());
+	expectWithin(reference(median), actual, 0);
+	applyErosion3x3(getKernels(), src.view(), actual.view());
+	expectWithin(reference(minimum), actual, 0);
+	applyDilation3x3(getKernels(), src.view(), actual.view());
+	expectWithin(reference(maximum), actual, 0);
+}
+
+TEST(CpuKernelsTest, MotionStagesMatchShader)
+{
+	const LumaImage current = makeRandomImage(37, 19, 5);
+	const LumaImage previous = makeRandomImage(37, 19, 6);
+	const auto w = static_cast<std::ptrdiff_t>(current.width), h = static_cast<std::ptrdiff_t>(current.height);
+
+	std::vector<float> horizontal(current.pixels.size());
+	for (std::ptrdiff_t y = 0; y < h; y++) {
+		for (std::ptrdiff_t x = 0; x < w; x++) {
+			float sad = 0.0f;
+			for (std::ptrdiff_t dx = -1; dx <= 1; dx++) {
+				sad += std::abs(sampleClamped(current, x + dx, y) - sampleClamped(previous, x + dx, y));
+			}
+			horizontal[y * w + x] = std::clamp(sad / 3.0f, 0.0f, 1.0f);
+		}
+	}
+	LumaImage expectedMotion(current.width, current.height);
+	for (std::ptrdiff_t y = 0; y < h; y++) {
+		for (std::ptrdiff_t x = 0; x < w; x++) {
+			const float total = horizontal[std::max<std::ptrdiff_t>(y - 1, 0) * w + x] + horizontal[y * w + x] +
+					    horizontal[std::min<std::ptrdiff_t>(y + 1, h - 1) * w + x];
+			expectedMotion.pixels[y * w + x] = toUnorm8(total / 3.0f);
+		}
+	}
+
+	LumaImage motion(current.width, current.height);
+	calculateMotionMap(getKernels(), current.view(), previous.view(), motion.view());
+	expectWithin(expectedMotion, motion, 0);
+
+	const float strength = 0.7f, threshold = 0.3f;
+	LumaImage expectedFiltered(current.width, current.height);
+	for (std::size_t i = 0; i < current.pixels.size(); i++) {
+		const float t = std::clamp(motion.pixels[i] / 255.0f / threshold, 0.0f, 1.0f);
+		const float blend = strength * t * t * (3.0f - 2.0f * t);
+		const float luma1 = previous.pixels[i] / 255.0f, luma = current.pixels[i] / 255.0f;
+		expectedFiltered.pixels[i] = toUnorm8(luma1 + (luma - luma1) * blend);
+	}
+
+	LumaImage filtered(current.width, current.height);
+	applyMotionAdaptiveFilter(getKernels(), current.view(), previous.view(), motion.view(), filtered.view(),
+				  MotionAdaptiveTable::create(strength, threshold));
+	expectWithin(expectedFiltered, filtered, 1);
+}
+
+TEST(CpuKernelsTest, SobelStagesMatchShader)
+{
+	const LumaImage src = makeRandomImage(37, 19, 7);
+	const auto w = static_cast<std::ptrdiff_t>(src.width), h = static_cast<std::ptrdiff_t>(src.height);
+
+	LumaImage expectedMagnitude(src.width, src.height);
+	for (std::ptrdiff_t y = 0; y < h; y++) {
+		for (std::ptrdiff_t x = 0; x < w; x++) {
+			auto s = [&](std::ptrdiff_t dx, std::ptrdiff_t dy) { return sampleClamped(src, x + dx, y + dy); };
+			const float gx = -s(-1, -1) - 2.0f * s(-1, 0) - s(-1, 1) + s(1, -1) + 2.0f * s(1, 0) + s(1, 1);
+			const float gy = -s(-1, -1) - 2.0f * s(0, -1) - s(1, -1) + s(-1, 1) + 2.0f * s(0, 1) + s(1, 1);
+			expectedMagnitude.pixels[y * w + x] = toUnorm8(std::sqrt(gx * gx + gy * gy) / 4.472136f);
+		}
+	}
+
+	LumaImage magnitude(src.width, src.height);
+	applySobelMagnitude(getKernels(), src.view(), magnitude.view());
+	expectWithin(expectedMagnitude, magnitude, 1);
+
+	for (bool useLog : {false, true}) {
+		const float scalingFactor = 3.1f;
+		LumaImage expectedFinal(src.width, src.height);
+		for (std::size_t i = 0; i < magnitude.pixels.size(); i++) {
+			float m = magnitude.pixels[i] / 255.0f;
+			if (useLog) {
+				m = std::log(1.0f + m) / std::log(2.0f);
+			}
+			expectedFinal.pixels[i] = toUnorm8(m * scalingFactor);
+		}
+
+		LumaImage finalized(src.width, src.height);
+		applyFinalizeSobelMagnitude(magnitude.view(), finalized.view(),
+					    FinalizeTable::create(useLog, scalingFactor));
+		expectWithin(expectedFinal, finalized, 1);
+	}
+}
+
+TEST(CpuKernelsTest, MotionAdaptiveTableBounds)
+{
+	const auto table = MotionAdaptiveTable::create(1.0f, 0.3f);
+	EXPECT_EQ(table.blendQ15[0], 0);
+	EXPECT_EQ(table.blendQ15[255], 32767);
+
+	const auto disabled = MotionAdaptiveTable::create(0.0f, 0.3f);
+	for (std::int16_t blend : disabled.blendQ15) {
+		EXPECT_EQ(blend, 0);
+	}
+}
@@ -0,0 +1,182 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+/**
+ * Exercises the deferred-free list without a graphics device: resources are stand-in pointers that are only ever
+ * taken back for reuse, never destroyed.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "BridgeUtils/GsUnique.hpp"
+
+using namespace KaitoTokyo::BridgeUtils::GsUnique;
+using KaitoTokyo::BridgeUtils::unique_gs_texture_t;
+
+namespace {
+
+constexpr ResourceDescriptor Descriptor{16, 9, GS_R8, GS_RENDER_TARGET};
+
+void *makeResource(std::uintptr_t id)
+{
+	return reinterpret_cast<void *>(id);
+}
+
+void push(std::uintptr_t id, const ResourceDescriptor &descriptor = Descriptor)
+{
+	std::unique_ptr<DeferredNode> node = makeDeferredNode(ResourceKind::Texture, descriptor);
+	node->resource = makeResource(id);
+	pushDeferred(std::move(node));
+}
+
+void *take(ResourceKind kind, const ResourceDescriptor &descriptor)
+{
+	const std::unique_ptr<DeferredNode> node = takeRecyclable(kind, descriptor);
+	return node ? node->resource : nullptr;
+}
+
+/**
+ * @brief Frees the nodes left on the list without destroying their stand-in resources.
+ */
+void discardAll()
+{
+	collect();
+	CollectedList &collected = getCollected();
+	while (collected.head) {
+		delete collected.unlinkAfter(nullptr);
+	}
+}
+
+class GsUniqueTest : public ::testing::Test {
+protected:
+	void TearDown() override { discardAll(); }
+};
+
+} // namespace
+
+TEST_F(GsUniqueTest, RecyclesOnlyAnIdenticalDescriptor)
+{
+	push(1);
+
+	EXPECT_EQ(take(ResourceKind::Texture, {17, 9, GS_R8, GS_RENDER_TARGET}), nullptr);
+	EXPECT_EQ(take(ResourceKind::Texture, {16, 10, GS_R8, GS_RENDER_TARGET}), nullptr);
+	EXPECT_EQ(take(ResourceKind::Texture, {16, 9, GS_BGRA, GS_RENDER_TARGET}), nullptr);
+	EXPECT_EQ(take(ResourceKind::Texture, {16, 9, GS_R8, 0}), nullptr);
+	EXPECT_EQ(take(ResourceKind::Stagesurf, Descriptor), nullptr);
+
+	EXPECT_EQ(take(ResourceKind::Texture, Descriptor), makeResource(1));
+	EXPECT_EQ(take(ResourceKind::Texture, Descriptor), nullptr);
+}
+
+TEST_F(GsUniqueTest, NeverRecyclesAZeroSizedDescriptor)
+{
+	push(1, {});
+
+	EXPECT_EQ(take(ResourceKind::Texture, {}), nullptr);
+}
+
+TEST_F(GsUniqueTest, RecyclesTheOldestResourceFirst)
+{
+	push(1);
+	push(2);
+	collect();
+	push(3);
+
+	EXPECT_EQ(take(ResourceKind::Texture, Descriptor), makeResource(1));
+	EXPECT_EQ(take(ResourceKind::Texture, Descriptor), makeResource(2));
+	EXPECT_EQ(take(ResourceKind::Texture, Descriptor), makeResource(3));
+}
+
+TEST_F(GsUniqueTest, KeepsEveryResourcePushedConcurrently)
+{
+	constexpr std::uintptr_t Producers = 4;
+	constexpr std::uintptr_t PushesPerProducer = 2000;
+
+	std::atomic<std::uintptr_t> finished = 0;
+	std::vector<std::thread> producers;
+	for (std::uintptr_t p = 0; p < Producers; p++) {
+		producers.emplace_back([p, &finished] {
+			for (std::uintptr_t i = 0; i < PushesPerProducer; i++) {
+				push(p * PushesPerProducer + i + 1);
+			}
+			finished.fetch_add(1);
+		});
+	}
+
+	std::set<void *> taken;
+	const auto takeAll = [&taken] {
+		while (void *resource = take(ResourceKind::Texture, Descriptor)) {
+			EXPECT_TRUE(taken.insert(resource).second);
+		}
+	};
+	// The consumer collects while the producers are still pushing, as the render thread would.
+	while (finished.load() < Producers) {
+		takeAll();
+	}
+	for (std::thread &producer : producers) {
+		producer.join();
+	}
+	takeAll();
+
+	EXPECT_EQ(taken.size(), Producers * PushesPerProducer);
+}
+
+TEST_F(GsUniqueTest, AppendsAfterTakingTheLastNode)
+{
+	constexpr ResourceDescriptor Other{32, 18, GS_R8, GS_RENDER_TARGET};
+	push(1);
+	push(2, Other);
+	EXPECT_EQ(take(ResourceKind::Texture, Other), makeResource(2));
+
+	push(3, Other);
+	EXPECT_EQ(take(ResourceKind::Texture, Other), makeResource(3));
+	EXPECT_EQ(take(ResourceKind::Texture, Descriptor), makeResource(1));
+	EXPECT_EQ(getCollected().head, nullptr);
+	EXPECT_EQ(getCollected().tail, nullptr);
+}
+
+TEST_F(GsUniqueTest, ReleasesThroughTheNodeCreatedWithTheWrapper)
+{
+	std::unique_ptr<DeferredNode> node = makeDeferredNode(ResourceKind::Texture, Descriptor);
+	const DeferredNode *const created = node.get();
+	{
+		unique_gs_texture_t texture(static_cast<gs_texture_t *>(makeResource(1)), {std::move(node)});
+	}
+
+	const std::unique_ptr<DeferredNode> taken = takeRecyclable(ResourceKind::Texture, Descriptor);
+	ASSERT_EQ(taken.get(), created);
+	EXPECT_EQ(taken->resource, makeResource(1));
+}
+
+TEST_F(GsUniqueTest, StillSchedulesAnAdoptedResourceWithoutRecyclingIt)
+{
+	{
+		unique_gs_texture_t texture(static_cast<gs_texture_t *>(makeResource(1)));
+	}
+
+	EXPECT_EQ(take(ResourceKind::Texture, Descriptor), nullptr);
+	ASSERT_NE(getCollected().head, nullptr);
+	EXPECT_EQ(getCollected().head->resource, makeResource(1));
+}
@@ -0,0 +1,128 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Core/InkTileTracker.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+
+namespace {
+
+constexpr std::uint32_t BlocksWide = 8;
+constexpr std::uint32_t BlocksHigh = 5;
+constexpr std::uint32_t BlockSize = 16;
+// The last row and column of blocks extend past the image.
+constexpr std::uint32_t Width = 120;
+constexpr std::uint32_t Height = 70;
+constexpr float Threshold = 0.1f;
+constexpr std::uint32_t CommitFrames = 3;
+
+std::vector<BlockStats> makeStill()
+{
+	return std::vector<BlockStats>(BlocksWide * BlocksHigh, BlockStats{0.01f, 0.0001f, 0.02f});
+}
+
+std::vector<BlockStats> makeMotionAt(std::uint32_t x, std::uint32_t y)
+{
+	std::vector<BlockStats> blocks = makeStill();
+	blocks[y * BlocksWide + x] = {0.2f, 0.05f, 0.5f};
+	return blocks;
+}
+
+} // namespace
+
+TEST(InkTileTrackerTest, RecomputesEverythingBeforeTheFirstUpdate)
+{
+	InkTileTracker tracker;
+	const std::optional<RoiRect> rect = tracker.getDirtyRect(Width, Height, BlockSize);
+	ASSERT_TRUE(rect);
+	EXPECT_EQ(*rect, (RoiRect{0, 0, Width, Height}));
+}
+
+TEST(InkTileTrackerTest, SettlesAfterTheCommitFrames)
+{
+	InkTileTracker tracker;
+	for (std::uint32_t i = 0; i < CommitFrames - 1; i++) {
+		tracker.update(makeStill(), BlocksWide, Threshold, CommitFrames);
+		EXPECT_TRUE(tracker.getDirtyRect(Width, Height, BlockSize));
+	}
+	tracker.update(makeStill(), BlocksWide, Threshold, CommitFrames);
+	EXPECT_FALSE(tracker.getDirtyRect(Width, Height, BlockSize));
+}
+
+TEST(InkTileTrackerTest, RecomputesAroundMotionGrownByOneTile)
+{
+	InkTileTracker tracker;
+	for (std::uint32_t i = 0; i < CommitFrames; i++) {
+		tracker.update(makeStill(), BlocksWide, Threshold, CommitFrames);
+	}
+	tracker.update(makeMotionAt(3, 2), BlocksWide, Threshold, CommitFrames);
+
+	const std::optional<RoiRect> rect = tracker.getDirtyRect(Width, Height, BlockSize);
+	ASSERT_TRUE(rect);
+	EXPECT_EQ(*rect, (RoiRect{2 * BlockSize, 1 * BlockSize, 3 * BlockSize, 3 * BlockSize}));
+
+	// The tile stays dirty until it has been still for the commit frames again.
+	for (std::uint32_t i = 0; i < CommitFrames - 1; i++) {
+		tracker.update(makeStill(), BlocksWide, Threshold, CommitFrames);
+		EXPECT_TRUE(tracker.getDirtyRect(Width, Height, BlockSize));
+	}
+	tracker.update(makeStill(), BlocksWide, Threshold, CommitFrames);
+	EXPECT_FALSE(tracker.getDirtyRect(Width, Height, BlockSize));
+}
+
+TEST(InkTileTrackerTest, ClampsTheRegionToTheImage)
+{
+	InkTileTracker tracker;
+	for (std::uint32_t i = 0; i < CommitFrames; i++) {
+		tracker.update(makeMotionAt(BlocksWide - 1, BlocksHigh - 1), BlocksWide, Threshold, CommitFrames);
+	}
+
+	const std::optional<RoiRect> rect = tracker.getDirtyRect(Width, Height, BlockSize);
+	ASSERT_TRUE(rect);
+	EXPECT_EQ(*rect, (RoiRect{(BlocksWide - 2) * BlockSize, (BlocksHigh - 2) * BlockSize,
+				  Width - (BlocksWide - 2) * BlockSize, Height - (BlocksHigh - 2) * BlockSize}));
+}
+
+TEST(InkTileTrackerTest, ResetRecomputesEverything)
+{
+	InkTileTracker tracker;
+	for (std::uint32_t i = 0; i < CommitFrames; i++) {
+		tracker.update(makeStill(), BlocksWide, Threshold, CommitFrames);
+	}
+	ASSERT_FALSE(tracker.getDirtyRect(Width, Height, BlockSize));
+
+	tracker.reset();
+	const std::optional<RoiRect> rect = tracker.getDirtyRect(Width, Height, BlockSize);
+	ASSERT_TRUE(rect);
+	EXPECT_EQ(*rect, (RoiRect{0, 0, Width, Height}));
+}
+
+TEST(InkTileTrackerTest, StartsOverWhenTheGridChanges)
+{
+	InkTileTracker tracker;
+	for (std::uint32_t i = 0; i < CommitFrames; i++) {
+		tracker.update(makeStill(), BlocksWide, Threshold, CommitFrames);
+	}
+	tracker.update(std::vector<BlockStats>(4, BlockStats{0.0f, 0.0f, 0.0f}), 2, Threshold, CommitFrames);
+	EXPECT_TRUE(tracker.getDirtyRect(Width, Height, BlockSize));
+}
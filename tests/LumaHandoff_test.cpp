@@ -0,0 +1,105 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "Core/LumaHandoff.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+
+namespace {
+
+void publishFrame(LumaHandoff &handoff, std::uint8_t value)
+{
+	std::vector<std::uint8_t> &staging = handoff.getStaging(4);
+	staging.assign(4, value);
+	handoff.publish();
+}
+
+} // namespace
+
+TEST(LumaHandoffTest, HasNoFrameUntilOneIsPublished)
+{
+	// A new context renders before filter_video has staged anything, and must not process its luma texture.
+	LumaHandoff handoff;
+	EXPECT_EQ(handoff.take(), nullptr);
+	EXPECT_FALSE(handoff.hasTakenFrame());
+
+	handoff.getStaging(4);
+	EXPECT_EQ(handoff.take(), nullptr);
+	EXPECT_FALSE(handoff.hasTakenFrame());
+
+	publishFrame(handoff, 7);
+	EXPECT_FALSE(handoff.hasTakenFrame());
+	const std::vector<std::uint8_t> *frame = handoff.take();
+	ASSERT_NE(frame, nullptr);
+	EXPECT_EQ(*frame, std::vector<std::uint8_t>(4, 7));
+	EXPECT_TRUE(handoff.hasTakenFrame());
+}
+
+TEST(LumaHandoffTest, StillHasAFrameOnceNoNewOneIsPublished)
+{
+	LumaHandoff handoff;
+	publishFrame(handoff, 1);
+	ASSERT_NE(handoff.take(), nullptr);
+
+	EXPECT_EQ(handoff.take(), nullptr);
+	EXPECT_TRUE(handoff.hasTakenFrame());
+}
+
+TEST(LumaHandoffTest, TakesOnlyTheLatestFrame)
+{
+	LumaHandoff handoff;
+	publishFrame(handoff, 1);
+	publishFrame(handoff, 2);
+	publishFrame(handoff, 3);
+
+	const std::vector<std::uint8_t> *frame = handoff.take();
+	ASSERT_NE(frame, nullptr);
+	EXPECT_EQ(*frame, std::vector<std::uint8_t>(4, 3));
+	EXPECT_EQ(handoff.take(), nullptr);
+}
+
+TEST(LumaHandoffTest, TakesWholeFramesWhilePublishing)
+{
+	constexpr int Frames = 2000;
+	LumaHandoff handoff;
+
+	std::thread filter([&handoff] {
+		for (int i = 1; i <= Frames; i++) {
+			publishFrame(handoff, static_cast<std::uint8_t>(i));
+		}
+	});
+	std::uint8_t last = 0;
+	int taken = 0;
+	while (last != static_cast<std::uint8_t>(Frames)) {
+		if (const std::vector<std::uint8_t> *frame = handoff.take()) {
+			ASSERT_EQ(*frame, std::vector<std::uint8_t>(4, (*frame)[0]));
+			last = (*frame)[0];
+			taken++;
+		}
+	}
+	filter.join();
+
+	EXPECT_GT(taken, 0);
+	EXPECT_TRUE(handoff.hasTakenFrame());
+}
@@ -0,0 +1,153 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include <obs.h>
+
+#if defined(__linux__)
+#include <obs-nix-platform.h>
+#include <X11/Xlib.h>
+#endif
+
+#include "BridgeUtils/GsUnique.hpp"
+
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace Testing {
+
+/**
+ * @class ObsHeadlessVideo
+ * @brief Starts libobs with a video pipeline and no window, for tests and benchmarks.
+ *
+ * On Linux the OpenGL renderer is forced onto Mesa's llvmpipe unless LIBGL_ALWAYS_SOFTWARE or GALLIUM_DRIVER
+ * is already set, so results do not depend on the GPU of the machine. libobs-opengl only supports the X11 and
+ * Wayland EGL platforms, so a display is still required; run under `xvfb-run` on headless machines.
+ */
+class ObsHeadlessVideo {
+public:
+	static constexpr std::uint32_t DefaultFps = 30;
+
+	ObsHeadlessVideo()
+	{
+#if defined(__linux__)
+		setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+		setenv("GALLIUM_DRIVER", "llvmpipe", 0);
+
+		display = XOpenDisplay(nullptr);
+		if (!display) {
+			throw std::runtime_error("XOpenDisplay failed; run under xvfb-run when no display is available");
+		}
+		obs_set_nix_platform(OBS_NIX_PLATFORM_X11_EGL);
+		obs_set_nix_platform_display(display);
+#endif
+
+		if (!obs_startup("en-US", nullptr, nullptr)) {
+			closeDisplay();
+			throw std::runtime_error("obs_startup failed");
+		}
+	}
+
+	~ObsHeadlessVideo() noexcept
+	{
+		if (obs_get_video()) {
+			BridgeUtils::GraphicsContextGuard guard;
+			BridgeUtils::GsUnique::drain();
+		}
+		obs_shutdown();
+		closeDisplay();
+	}
+
+	ObsHeadlessVideo(const ObsHeadlessVideo &) = delete;
+	ObsHeadlessVideo &operator=(const ObsHeadlessVideo &) = delete;
+	ObsHeadlessVideo(ObsHeadlessVideo &&) = delete;
+	ObsHeadlessVideo &operator=(ObsHeadlessVideo &&) = delete;
+
+	/**
+	 * @brief (Re)configures the video pipeline. Fails while outputs are active.
+	 */
+	void resetVideo(std::uint32_t width, std::uint32_t height, std::uint32_t fps = DefaultFps)
+	{
+		obs_video_info ovi = {};
+#if defined(_WIN32)
+		ovi.graphics_module = "libobs-d3d11.dll";
+#elif defined(__APPLE__)
+		ovi.graphics_module = "libobs-opengl.dylib";
+#else
+		ovi.graphics_module = "libobs-opengl.so";
+#endif
+
+		ovi.fps_num = fps;
+		ovi.fps_den = 1;
+
+		ovi.base_width = width;
+		ovi.base_height = height;
+
+		ovi.output_width = width;
+		ovi.output_height = height;
+		ovi.output_format = VIDEO_FORMAT_BGRA;
+
+		ovi.adapter = 0;
+
+		ovi.gpu_conversion = true;
+
+		ovi.colorspace = VIDEO_CS_709;
+		ovi.range = VIDEO_RANGE_FULL;
+
+		ovi.scale_type = OBS_SCALE_DISABLE;
+
+		const int result = obs_reset_video(&ovi);
+		if (result != OBS_VIDEO_SUCCESS) {
+			throw std::runtime_error("obs_reset_video failed: " + std::to_string(result));
+		}
+	}
+
+	/**
+	 * @brief Gets the name of the renderer, e.g. "llvmpipe (LLVM 15.0.7, 256 bits)" on Mesa.
+	 */
+	static std::string getRendererName()
+	{
+		BridgeUtils::GraphicsContextGuard guard;
+		const char *name = gs_get_device_name();
+		return name ? name : "(unknown)";
+	}
+
+private:
+	void closeDisplay() noexcept
+	{
+#if defined(__linux__)
+		if (display) {
+			XCloseDisplay(display);
+			display = nullptr;
+		}
+#endif
+	}
+
+#if defined(__linux__)
+	Display *display = nullptr;
+#endif
+};
+
+} // namespace Testing
+} // namespace ShowDraw
+} // namespace KaitoTokyo
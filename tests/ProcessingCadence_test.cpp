@@ -0,0 +1,82 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Core/ProcessingCadence.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+
+namespace {
+
+constexpr std::uint64_t Fps60IntervalNs = 16666667;
+
+std::vector<std::uint32_t> feedFrames(ProcessingCadence &cadence, int maxProcessingRate, int count,
+				      std::uint64_t intervalNs)
+{
+	std::vector<std::uint32_t> steps;
+	for (int i = 0; i < count; i++) {
+		steps.push_back(cadence.onNewFrame(1000000000ULL + static_cast<std::uint64_t>(i) * intervalNs,
+						   maxProcessingRate));
+	}
+	return steps;
+}
+
+} // namespace
+
+TEST(ProcessingCadenceTest, UnlimitedProcessesEveryFrame)
+{
+	ProcessingCadence cadence;
+	EXPECT_EQ(feedFrames(cadence, 0, 5, Fps60IntervalNs), (std::vector<std::uint32_t>{1, 1, 1, 1, 1}));
+}
+
+TEST(ProcessingCadenceTest, HalvesA60FpsSourceAt30Hz)
+{
+	ProcessingCadence cadence;
+	EXPECT_EQ(feedFrames(cadence, 30, 7, Fps60IntervalNs), (std::vector<std::uint32_t>{1, 0, 2, 0, 2, 0, 2}));
+}
+
+TEST(ProcessingCadenceTest, ToleratesTimestampJitter)
+{
+	ProcessingCadence cadence;
+	EXPECT_EQ(cadence.onNewFrame(0, 30), 1u);
+	EXPECT_EQ(cadence.onNewFrame(16000000, 30), 0u);
+	// Slightly early by the 1/8 slack: still processed, so the cadence does not slip a whole frame.
+	EXPECT_EQ(cadence.onNewFrame(31000000, 30), 2u);
+}
+
+TEST(ProcessingCadenceTest, RestartsWhenTimestampsGoBackwards)
+{
+	ProcessingCadence cadence;
+	EXPECT_EQ(cadence.onNewFrame(5000000000ULL, 15), 1u);
+	EXPECT_EQ(cadence.onNewFrame(1000000000ULL, 15), 1u);
+	EXPECT_EQ(cadence.onNewFrame(1000000000ULL + Fps60IntervalNs, 15), 0u);
+}
+
+TEST(ProcessingCadenceTest, ScalesTemporalStrengthToMatchPerFrameBlending)
+{
+	EXPECT_FLOAT_EQ(ProcessingCadence::scaleTemporalStrength(0.5f, 1), 0.5f);
+	EXPECT_FLOAT_EQ(ProcessingCadence::scaleTemporalStrength(0.5f, 2), 0.75f);
+	EXPECT_FLOAT_EQ(ProcessingCadence::scaleTemporalStrength(0.0f, 4), 0.0f);
+	EXPECT_FLOAT_EQ(ProcessingCadence::scaleTemporalStrength(1.0f, 4), 1.0f);
+	EXPECT_NEAR(ProcessingCadence::scaleTemporalStrength(0.2f, 3), 1.0f - std::pow(0.8f, 3.0f), 1e-6f);
+}
@@ -0,0 +1,193 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "Core/ContextRebuilder.hpp"
+#include "Core/QualityGovernor.hpp"
+#include "Core/RenderingLayout.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+
+namespace {
+
+constexpr std::uint64_t BudgetNs = 4000000;
+constexpr std::uint64_t OverBudgetNs = 5000000;
+constexpr std::uint64_t NearBudgetNs = 3000000;
+constexpr std::uint64_t HeadroomNs = 1000000;
+// 60 fps.
+constexpr std::uint64_t FrameIntervalNs = 16666667;
+
+void stepDown(QualityGovernor &governor)
+{
+	for (std::uint32_t i = 0; i < QualityGovernor::OverBudgetSamples; i++) {
+		governor.update(OverBudgetNs, BudgetNs);
+	}
+}
+
+} // namespace
+
+TEST(QualityGovernorTest, StepsDownAfterConsecutiveSamplesOverBudget)
+{
+	QualityGovernor governor;
+	for (std::uint32_t i = 0; i + 1 < QualityGovernor::OverBudgetSamples; i++) {
+		EXPECT_FALSE(governor.update(OverBudgetNs, BudgetNs));
+	}
+
+	const std::optional<QualityTransition> transition = governor.update(OverBudgetNs, BudgetNs);
+	ASSERT_TRUE(transition);
+	EXPECT_EQ(transition->from, QualityLevel::Full);
+	EXPECT_EQ(transition->to, QualityLevel::SmallerMedian);
+	EXPECT_EQ(transition->pipelineNs, OverBudgetNs);
+	EXPECT_EQ(transition->budgetNs, BudgetNs);
+	EXPECT_EQ(governor.getLevel(), QualityLevel::SmallerMedian);
+}
+
+TEST(QualityGovernorTest, IgnoresASingleSpike)
+{
+	QualityGovernor governor;
+	for (int i = 0; i < 10; i++) {
+		EXPECT_FALSE(governor.update(OverBudgetNs, BudgetNs));
+		EXPECT_FALSE(governor.update(NearBudgetNs, BudgetNs));
+	}
+	EXPECT_EQ(governor.getLevel(), QualityLevel::Full);
+}
+
+TEST(QualityGovernorTest, StopsAtTheBottomOfTheLadder)
+{
+	QualityGovernor governor;
+	for (int i = 0; i < 10; i++) {
+		stepDown(governor);
+	}
+	EXPECT_EQ(governor.getLevel(), QualityLevel::ReducedRate);
+}
+
+TEST(QualityGovernorTest, StepsUpOnlyAfterSustainedHeadroom)
+{
+	QualityGovernor governor;
+	stepDown(governor);
+	stepDown(governor);
+	ASSERT_EQ(governor.getLevel(), QualityLevel::NoMotionAdaptiveFiltering);
+
+	// A load just under the budget is not headroom, so the quality holds.
+	for (int i = 0; i < 50; i++) {
+		EXPECT_FALSE(governor.update(NearBudgetNs, BudgetNs));
+	}
+
+	for (std::uint32_t i = 0; i + 1 < QualityGovernor::HeadroomSamples; i++) {
+		EXPECT_FALSE(governor.update(HeadroomNs, BudgetNs));
+	}
+	const std::optional<QualityTransition> transition = governor.update(HeadroomNs, BudgetNs);
+	ASSERT_TRUE(transition);
+	EXPECT_EQ(transition->from, QualityLevel::NoMotionAdaptiveFiltering);
+	EXPECT_EQ(transition->to, QualityLevel::SmallerMedian);
+}
+
+TEST(QualityGovernorTest, ResetRestoresFullQuality)
+{
+	QualityGovernor governor;
+	stepDown(governor);
+	EXPECT_EQ(governor.reset(), QualityLevel::SmallerMedian);
+	EXPECT_EQ(governor.getLevel(), QualityLevel::Full);
+}
+
+TEST(QualityGovernorTest, FullQualityKeepsThePreset)
+{
+	Preset preset;
+	preset.processingScale = 75;
+	preset.temporalMedianFrames = 5;
+	preset.medianFilterEnabled = true;
+	preset.motionAdaptiveFilteringStrength = 0.5;
+	preset.maxProcessingRate = 20;
+
+	const Preset degraded = QualityGovernor::degrade(preset, QualityLevel::Full, FrameIntervalNs);
+	EXPECT_EQ(degraded.processingScale, 75);
+	EXPECT_EQ(degraded.temporalMedianFrames, 5);
+	EXPECT_EQ(degraded.temporalMedianFramesLimit, 5);
+	EXPECT_TRUE(degraded.medianFilterEnabled);
+	EXPECT_DOUBLE_EQ(degraded.motionAdaptiveFilteringStrength, 0.5);
+	EXPECT_EQ(degraded.maxProcessingRate, 20);
+}
+
+TEST(QualityGovernorTest, DegradesCumulatively)
+{
+	Preset preset;
+	preset.processingScale = 100;
+	preset.temporalMedianFrames = 5;
+	preset.medianFilterEnabled = true;
+	preset.motionAdaptiveFilteringStrength = 0.5;
+	preset.maxProcessingRate = 0;
+
+	const Preset median = QualityGovernor::degrade(preset, QualityLevel::SmallerMedian, FrameIntervalNs);
+	EXPECT_EQ(median.temporalMedianFramesLimit, 3);
+	EXPECT_FALSE(median.medianFilterEnabled);
+	EXPECT_DOUBLE_EQ(median.motionAdaptiveFilteringStrength, 0.5);
+
+	const Preset still = QualityGovernor::degrade(preset, QualityLevel::NoMotionAdaptiveFiltering, FrameIntervalNs);
+	EXPECT_EQ(still.temporalMedianFramesLimit, 3);
+	EXPECT_DOUBLE_EQ(still.motionAdaptiveFilteringStrength, 0.0);
+	EXPECT_EQ(still.maxProcessingRate, 0);
+
+	const Preset slow = QualityGovernor::degrade(preset, QualityLevel::ReducedRate, FrameIntervalNs);
+	EXPECT_EQ(slow.maxProcessingRate, 30);
+}
+
+TEST(QualityGovernorTest, NeverRaisesTheConfiguredQuality)
+{
+	Preset preset;
+	preset.temporalMedianFrames = 3;
+	preset.maxProcessingRate = 10;
+
+	const Preset degraded = QualityGovernor::degrade(preset, QualityLevel::ReducedRate, FrameIntervalNs);
+	EXPECT_EQ(degraded.temporalMedianFramesLimit, 0);
+	EXPECT_EQ(degraded.maxProcessingRate, 5);
+}
+
+TEST(QualityGovernorTest, NoStepRebuildsTheRenderingContext)
+{
+	constexpr std::uint32_t Width = 1920;
+	constexpr std::uint32_t Height = 1080;
+	Preset preset;
+	preset.processingScale = 75;
+	preset.temporalMedianFrames = 5;
+	preset.inkCommitEnabled = true;
+	preset.autoCalibrationEnabled = true;
+	preset.roiEnabled = true;
+	preset.roiCropLeft = 10.0;
+
+	const auto getSpec = [](const Preset &p) {
+		return RenderingContextSpec{Width, Height, RenderingLayout::fromPreset(p, Width, Height, true)};
+	};
+	const auto makeContext = [](const RenderingContextSpec &) { return std::make_shared<int>(0); };
+	ContextRebuilder<int, RenderingContextSpec> contexts;
+	contexts.acquire(getSpec(preset));
+	ASSERT_TRUE(contexts.rebuild(makeContext));
+	const std::shared_ptr<int> context = contexts.get();
+
+	// A rebuild would drop the temporal histories and pass frames through while the GPU is already over budget.
+	for (QualityLevel level : {QualityLevel::SmallerMedian, QualityLevel::NoMotionAdaptiveFiltering,
+				   QualityLevel::ReducedRate, QualityLevel::Full}) {
+		const Preset degraded = QualityGovernor::degrade(preset, level, FrameIntervalNs);
+		EXPECT_EQ(contexts.acquire(getSpec(degraded)), context) << getQualityLevelName(level);
+		EXPECT_FALSE(contexts.rebuild(makeContext)) << getQualityLevelName(level);
+	}
+}
@@ -0,0 +1,115 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include "Core/RenderBudgetScheduler.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+
+namespace {
+
+constexpr std::uint64_t BudgetNs = 1000;
+constexpr std::uint32_t MaxDeferrals = 2;
+
+} // namespace
+
+TEST(RenderBudgetSchedulerTest, RunsStagesThatFitTheBudget)
+{
+	RenderBudgetScheduler scheduler(BudgetNs, MaxDeferrals);
+	EXPECT_TRUE(scheduler.tryRun(1, 400, 0));
+	EXPECT_TRUE(scheduler.tryRun(1, 600, 0));
+	EXPECT_FALSE(scheduler.tryRun(1, 1, 0));
+}
+
+TEST(RenderBudgetSchedulerTest, OpensEachTickWithOneStageWhateverItsCost)
+{
+	RenderBudgetScheduler scheduler(BudgetNs, MaxDeferrals);
+	EXPECT_TRUE(scheduler.tryRun(1, 5000, 0));
+	EXPECT_FALSE(scheduler.tryRun(1, 100, 0));
+	EXPECT_TRUE(scheduler.tryRun(2, 5000, 1));
+}
+
+TEST(RenderBudgetSchedulerTest, LetsTheLongestWaitingStageOpenATick)
+{
+	RenderBudgetScheduler scheduler(BudgetNs, MaxDeferrals);
+	EXPECT_TRUE(scheduler.tryRun(1, BudgetNs, 0));
+	EXPECT_FALSE(scheduler.tryRun(1, BudgetNs, 0));
+	// The stage that just ran would otherwise take the next tick again.
+	EXPECT_FALSE(scheduler.tryRun(2, BudgetNs, 0));
+	EXPECT_TRUE(scheduler.tryRun(2, BudgetNs, 1));
+}
+
+TEST(RenderBudgetSchedulerTest, UnmeasuredStagesTakeTheWholeBudget)
+{
+	RenderBudgetScheduler scheduler(BudgetNs, MaxDeferrals);
+	EXPECT_TRUE(scheduler.tryRun(1, std::nullopt, 0));
+	EXPECT_FALSE(scheduler.tryRun(1, std::nullopt, 0));
+	EXPECT_FALSE(scheduler.tryRun(1, 1, 0));
+}
+
+TEST(RenderBudgetSchedulerTest, RunsStagesThatWaitedTooLong)
+{
+	RenderBudgetScheduler scheduler(BudgetNs, MaxDeferrals);
+	EXPECT_TRUE(scheduler.tryRun(1, BudgetNs, 0));
+	EXPECT_FALSE(scheduler.tryRun(1, BudgetNs, MaxDeferrals - 1));
+	EXPECT_TRUE(scheduler.tryRun(1, BudgetNs, MaxDeferrals));
+}
+
+TEST(DeferrableStageTest, StaggersFiltersAcrossTicks)
+{
+	RenderBudgetScheduler scheduler(BudgetNs, MaxDeferrals);
+	std::array<DeferrableStage, 3> stages;
+	std::array<int, 3> runs{};
+
+	for (std::uint64_t tick = 1; tick <= 6; tick++) {
+		int runsThisTick = 0;
+		for (std::size_t i = 0; i < stages.size(); i++) {
+			if (stages[i].tryRun(scheduler, tick, BudgetNs)) {
+				runs[i]++;
+				runsThisTick++;
+			}
+		}
+		EXPECT_EQ(runsThisTick, 1);
+	}
+	EXPECT_EQ(runs, (std::array<int, 3>{2, 2, 2}));
+}
+
+TEST(DeferrableStageTest, BoundsTheDeferrals)
+{
+	RenderBudgetScheduler scheduler(BudgetNs, MaxDeferrals);
+	std::array<DeferrableStage, 5> stages;
+	std::array<int, 5> runs{};
+
+	constexpr int Ticks = 12;
+	for (std::uint64_t tick = 1; tick <= Ticks; tick++) {
+		for (std::size_t i = 0; i < stages.size(); i++) {
+			if (stages[i].tryRun(scheduler, tick, BudgetNs)) {
+				runs[i]++;
+			}
+			EXPECT_LE(stages[i].getDeferrals(), MaxDeferrals);
+		}
+	}
+	for (int count : runs) {
+		EXPECT_GE(count, Ticks / static_cast<int>(MaxDeferrals + 1));
+	}
+}
@@ -0,0 +1,52 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include "Core/Preset.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+
+TEST(RoiTest, DisabledCoversTheFrame)
+{
+	Preset preset;
+	preset.roiCropLeft = 25.0;
+	EXPECT_EQ(preset.getRoiRect(1920, 1080), (RoiRect{0, 0, 1920, 1080}));
+}
+
+TEST(RoiTest, CropsEachEdgeByPercentage)
+{
+	Preset preset;
+	preset.roiEnabled = true;
+	preset.roiCropLeft = 10.0;
+	preset.roiCropTop = 20.0;
+	preset.roiCropRight = 30.0;
+	preset.roiCropBottom = 5.0;
+	EXPECT_EQ(preset.getRoiRect(1920, 1080), (RoiRect{192, 216, 1152, 810}));
+}
+
+TEST(RoiTest, KeepsAtLeastOnePixel)
+{
+	Preset preset;
+	preset.roiEnabled = true;
+	preset.roiCropLeft = 80.0;
+	preset.roiCropRight = 80.0;
+	preset.roiCropTop = 100.0;
+	preset.roiCropBottom = -5.0;
+	EXPECT_EQ(preset.getRoiRect(100, 50), (RoiRect{80, 49, 1, 1}));
+}
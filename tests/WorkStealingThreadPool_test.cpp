@@ -0,0 +1,84 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "BridgeUtils/WorkStealingThreadPool.hpp"
+
+using namespace KaitoTokyo::BridgeUtils;
+
+TEST(WorkStealingThreadPoolTest, RunsEveryIterationOnce)
+{
+	for (std::size_t threadCount : {1, 2, 4}) {
+		WorkStealingThreadPool pool(threadCount);
+		EXPECT_EQ(pool.getThreadCount(), threadCount);
+		for (std::size_t count : {0, 1, 3, 100}) {
+			std::vector<std::atomic<int>> runs(count);
+			pool.parallelFor(count, [&](std::size_t i) { runs[i]++; });
+			for (std::size_t i = 0; i < count; i++) {
+				EXPECT_EQ(runs[i].load(), 1) << threadCount << " threads, iteration " << i;
+			}
+		}
+	}
+}
+
+TEST(WorkStealingThreadPoolTest, RethrowsAfterAllIterationsFinish)
+{
+	WorkStealingThreadPool pool(3);
+	std::atomic<int> finished{0};
+	EXPECT_THROW(pool.parallelFor(16,
+				      [&](std::size_t i) {
+					      finished++;
+					      if (i == 5) {
+						      throw std::runtime_error("iteration failed");
+					      }
+				      }),
+		     std::runtime_error);
+	EXPECT_EQ(finished.load(), 16);
+}
+
+TEST(WorkStealingThreadPoolTest, AcceptsCallsFromSeveralThreads)
+{
+	WorkStealingThreadPool pool(3);
+	std::atomic<int> total{0};
+	std::vector<std::thread> callers;
+	for (int caller = 0; caller < 4; caller++) {
+		callers.emplace_back([&] {
+			for (int round = 0; round < 50; round++) {
+				pool.parallelFor(8, [&](std::size_t) { total++; });
+			}
+		});
+	}
+	for (std::thread &caller : callers) {
+		caller.join();
+	}
+	EXPECT_EQ(total.load(), 4 * 50 * 8);
+}
+
+TEST(WorkStealingThreadPoolTest, PinnedPoolRuns)
+{
+	WorkStealingThreadPool pool(2, true);
+	std::atomic<int> total{0};
+	pool.parallelFor(10, [&](std::size_t) { total++; });
+	EXPECT_EQ(total.load(), 10);
+}
@@ -0,0 +1,116 @@
+/*
+obs-showdraw
+Copyright (C) 2025 Kaito Udagawa umireon@kaito.tokyo
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "CpuEngine/YuvFrame.hpp"
+
+using namespace KaitoTokyo::ShowDraw;
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+
+namespace {
+
+// Odd sizes and padded rows, as camera frames often have.
+constexpr std::size_t Width = 7;
+constexpr std::size_t Height = 5;
+constexpr std::size_t Padding = 9;
+
+LumaImage makeGradient()
+{
+	LumaImage image(Width, Height);
+	for (std::size_t i = 0; i < image.pixels.size(); i++) {
+		image.pixels[i] = static_cast<std::uint8_t>(i * 7);
+	}
+	return image;
+}
+
+} // namespace
+
+TEST(YuvFrameTest, Nv12IsReadInPlaceAndChromaIsNeutralized)
+{
+	const std::size_t linesize = Width + Padding;
+	std::vector<std::uint8_t> y(linesize * Height, 0);
+	std::vector<std::uint8_t> uv(linesize * 3, 0);
+	const YuvFrameView frame{
+		YuvFormat::NV12, {y.data(), uv.data(), nullptr}, {linesize, linesize, 0}, Width, Height};
+
+	LumaImage scratch;
+	EXPECT_EQ(extractLuma(frame, scratch).data, y.data());
+
+	const LumaImage luma = makeGradient();
+	writeLumaWithNeutralChroma(frame, luma.view());
+	for (std::size_t row = 0; row < Height; row++) {
+		for (std::size_t x = 0; x < Width; x++) {
+			EXPECT_EQ(y[row * linesize + x], luma.pixels[row * Width + x]);
+		}
+		EXPECT_EQ(y[row * linesize + Width], 0) << "padding must stay untouched";
+	}
+	for (std::size_t row = 0; row < 3; row++) {
+		for (std::size_t x = 0; x < 8; x++) {
+			EXPECT_EQ(uv[row * linesize + x], 128);
+		}
+	}
+}
+
+TEST(YuvFrameTest, Yuy2RoundTripsAndNeutralizesChroma)
+{
+	const std::size_t linesize = Width * 2 + Padding;
+	std::vector<std::uint8_t> packed(linesize * Height, 7);
+	const YuvFrameView frame{YuvFormat::YUY2, {packed.data(), nullptr, nullptr}, {linesize, 0, 0}, Width, Height};
+
+	const LumaImage luma = makeGradient();
+	writeLumaWithNeutralChroma(frame, luma.view());
+
+	LumaImage scratch;
+	const ConstLumaView extracted = extractLuma(frame, scratch);
+	for (std::size_t row = 0; row < Height; row++) {
+		for (std::size_t x = 0; x < Width; x++) {
+			EXPECT_EQ(extracted.row(row)[x], luma.pixels[row * Width + x]);
+			EXPECT_EQ(packed[row * linesize + x * 2 + 1], 128);
+		}
+	}
+}
+
+TEST(YuvFrameTest, P010UsesTheHighByte)
+{
+	const std::size_t linesize = Width * 2 + Padding;
+	std::vector<std::uint8_t> y(linesize * Height, 0);
+	std::vector<std::uint8_t> uv(linesize * 3, 0);
+	// 10-bit 600 sits in the top bits: 600 << 6 = 0x9600.
+	for (std::size_t row = 0; row < Height; row++) {
+		for (std::size_t x = 0; x < Width; x++) {
+			y[row * linesize + x * 2] = 0x00;
+			y[row * linesize + x * 2 + 1] = 0x96;
+		}
+	}
+	const YuvFrameView frame{
+		YuvFormat::P010, {y.data(), uv.data(), nullptr}, {linesize, linesize, 0}, Width, Height};
+
+	LumaImage scratch;
+	EXPECT_EQ(extractLuma(frame, scratch).row(2)[3], 0x96);
+
+	writeLumaWithNeutralChroma(frame, makeGradient().view());
+	EXPECT_EQ(y[linesize + 2 * 2], 63);
+	EXPECT_EQ(y[linesize + 2 * 2 + 1], 63);
+	EXPECT_EQ(uv[0], 0x00);
+	EXPECT_EQ(uv[1], 0x80);
+	EXPECT_EQ(uv[2 * linesize + 15], 0x80);
+}
@@ -25,7 +25,9 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <gtest/gtest.h>
 #include <obs-module.h>
 
-#include <obs-bridge-utils/obs-bridge-utils.hpp>
+#include <memory>
+
+#include "ObsHeadlessVideo.hpp"
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE(PLUGIN_NAME, "en-US")
@@ -34,10 +36,9 @@ constexpr int FPS = 30;
 constexpr int WIDTH = 640;
 constexpr int HEIGHT = 480;
 
-using namespace kaito_tokyo::obs_bridge_utils;
-
-namespace kaito_tokyo {
-namespace obs_showdraw_testing {
+namespace KaitoTokyo {
+namespace ShowDraw {
+namespace Testing {
 
 class ObsTestEnvironment : public ::testing::Environment {
 public:
@@ -59,63 +60,34 @@ class ObsTestWithVideoEnvironment : public ::testing::Environment {
 public:
 	void SetUp() override
 	{
-		if (!obs_startup("en-US", nullptr, nullptr)) {
-			FAIL() << "OBS startup failed.";
-		}
-
-		obs_video_info ovi;
-#if defined(_WIN32)
-		ovi.graphics_module = "libobs-d3d11.dll";
-#elif defined(__APPLE__)
-		ovi.graphics_module = "libobs-opengl.dylib";
-#else
-		ovi.graphics_module = "libobs-opengl.so";
-#endif
-
-		ovi.fps_num = FPS;
-		ovi.fps_den = 1;
-
-		ovi.base_width = WIDTH;
-		ovi.base_height = HEIGHT;
-
-		ovi.output_width = WIDTH;
-		ovi.output_height = HEIGHT;
-		ovi.output_format = VIDEO_FORMAT_BGRA;
-
-		ovi.adapter = 0;
-
-		ovi.gpu_conversion = true;
-
-		ovi.colorspace = VIDEO_CS_709;
-		ovi.range = VIDEO_RANGE_FULL;
-
-		ovi.scale_type = OBS_SCALE_DISABLE;
-
-		if (obs_reset_video(&ovi) != OBS_VIDEO_SUCCESS) {
-			FAIL() << "obs_reset_video failed";
+		try {
+			video = std::make_unique<ObsHeadlessVideo>();
+			video->resetVideo(WIDTH, HEIGHT, FPS);
+		} catch (const std::exception &e) {
+			FAIL() << e.what();
 		}
 	}
 
 	void TearDown() override
 	{
-		{
-			graphics_context_guard guard;
-			gs_unique::drain();
-		}
-		obs_shutdown();
+		video.reset();
 		ASSERT_EQ(0, bnum_allocs()) << "Memory leak detected: " << bnum_allocs();
 	}
+
+private:
+	std::unique_ptr<ObsHeadlessVideo> video;
 };
 
-} // namespace obs_showdraw_testing
-} // namespace kaito_tokyo
+} // namespace Testing
+} // namespace ShowDraw
+} // namespace KaitoTokyo
 
 #if defined(TEST_LIBOBS_ONLY)
 ::testing::Environment *const obs_env =
-	::testing::AddGlobalTestEnvironment(new kaito_tokyo::obs_showdraw_testing::ObsTestEnvironment());
+	::testing::AddGlobalTestEnvironment(new KaitoTokyo::ShowDraw::Testing::ObsTestEnvironment());
 #elif defined(TEST_LIBOBS_WITH_VIDEO)
 ::testing::Environment *const obs_env =
-	::testing::AddGlobalTestEnvironment(new kaito_tokyo::obs_showdraw_testing::ObsTestWithVideoEnvironment());
+	::testing::AddGlobalTestEnvironment(new KaitoTokyo::ShowDraw::Testing::ObsTestWithVideoEnvironment());
 #endif
 
 #ifndef CMAKE_SOURCE_DIR
@@ -16,9 +16,719 @@ You should have received a copy of the GNU General Public License along
 with this program. If not, see <https://www.gnu.org/licenses/>
 */
 
+/**
+ * Runs every technique of main.effect through MainEffect on software-rendered libobs and compares the result
+ * with the CpuKernels reference, which documents a tolerance of 1 LSB for every stage.
+ * Each test also records the time per run of its technique as the test property "us_per_run",
+ * so a rewritten shader can be proven both correct and faster with one run of this binary.
+ */
+
 #include <gtest/gtest.h>
 
-TEST(DrawingEffectShader, Draw)
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <obs.h>
+
+#include "BridgeUtils/AsyncTextureReader.hpp"
+#include "BridgeUtils/GsUnique.hpp"
+#include "BridgeUtils/ObsUnique.hpp"
+#include "Core/MainEffect.hpp"
+#include "CpuKernels/CpuKernels.hpp"
+
+#include "ObsHeadlessVideo.hpp"
+
+using namespace KaitoTokyo::BridgeUtils;
+using namespace KaitoTokyo::ShowDraw;
+using namespace KaitoTokyo::ShowDraw::CpuKernels;
+using namespace KaitoTokyo::ShowDraw::Testing;
+
+namespace {
+
+// Not a multiple of any tile or vector width, so edge handling is exercised on both axes.
+constexpr std::uint32_t Width = 250;
+constexpr std::uint32_t Height = 141;
+
+constexpr int Tolerance = 1;
+constexpr int TimedRuns = 20;
+
+std::vector<std::uint8_t> makeRandomBytes(std::size_t size, std::uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<std::uint8_t> bytes(size);
+	for (auto &byte : bytes) {
+		byte = static_cast<std::uint8_t>(rng());
+	}
+	return bytes;
+}
+
+/**
+ * @brief A smooth gradient with a few hard strokes and mild noise, so that every filter sees both flat
+ * regions and edges.
+ */
+LumaImage makeSyntheticImage(std::uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	LumaImage image(Width, Height);
+	for (std::size_t y = 0; y < Height; y++) {
+		for (std::size_t x = 0; x < Width; x++) {
+			int value = static_cast<int>((x * 255) / Width + (y * 64) / Height) / 2 + 48;
+			if ((x + 2 * y + seed) % 37 < 3) {
+				value = 16;
+			}
+			value += static_cast<int>(rng() % 9) - 4;
+			image.pixels[y * Width + x] = static_cast<std::uint8_t>(std::clamp(value, 0, 255));
+		}
+	}
+	return image;
+}
+
+unique_gs_texture_t uploadTexture(gs_color_format format, const std::uint8_t *data)
+{
+	const std::uint8_t *levels[] = {data};
+	return make_unique_gs_texture(Width, Height, format, 1, levels, 0);
+}
+
+unique_gs_texture_t makeRenderTarget(gs_color_format format)
+{
+	return make_unique_gs_texture(Width, Height, format, 1, nullptr, GS_RENDER_TARGET);
+}
+
+/**
+ * @brief Reads one byte per pixel back from a render target. Stalls until the GPU has finished.
+ * @param channel The byte within a pixel to extract, e.g. 2 for the red channel of GS_BGRX.
+ */
+LumaImage readBack(const unique_gs_texture_t &texture, gs_color_format format, std::size_t channel = 0)
+{
+	const std::size_t bytesPerPixel = format == GS_R8 ? 1 : 4;
+	unique_gs_stagesurf_t stagesurf = make_unique_gs_stagesurf(Width, Height, format);
+	gs_stage_texture(stagesurf.get(), texture.get());
+
+	std::vector<std::uint8_t> packed(Width * Height * bytesPerPixel);
+	{
+		AsyncTextureReaderDetail::ScopedStageSurfMap mapped(stagesurf.get());
+		AsyncTextureReaderDetail::copyRows(packed.data(), Width * bytesPerPixel, mapped.data, mapped.linesize,
+						   Width * bytesPerPixel, Height);
+	}
+
+	LumaImage image(Width, Height);
+	for (std::size_t i = 0; i < image.pixels.size(); i++) {
+		image.pixels[i] = packed[i * bytesPerPixel + channel];
+	}
+	return image;
+}
+
+/**
+ * @brief Runs a draw call into a target cleared to transparent black, one output pixel per texel.
+ */
+void drawToTarget(const unique_gs_texture_t &target, const std::function<void()> &draw)
+{
+	const MainEffectDetail::RenderTargetGuard renderTargetGuard;
+	const MainEffectDetail::TransformStateGuard transformStateGuard;
+
+	gs_set_render_target_with_color_space(target.get(), nullptr, GS_CS_SRGB);
+	gs_set_viewport(0, 0, Width, Height);
+	gs_ortho(0.0f, static_cast<float>(Width), 0.0f, static_cast<float>(Height), -100.0f, 100.0f);
+	gs_matrix_identity();
+
+	struct vec4 transparent;
+	vec4_zero(&transparent);
+	gs_clear(GS_CLEAR_COLOR, &transparent, 0.0f, 0);
+	draw();
+}
+
+void expectWithinTolerance(const LumaImage &expected, const LumaImage &actual)
+{
+	int maxDifference = 0;
+	std::size_t inexactPixels = 0;
+	std::size_t firstMismatch = expected.pixels.size();
+	for (std::size_t i = 0; i < expected.pixels.size(); i++) {
+		const int difference = std::abs(int{expected.pixels[i]} - int{actual.pixels[i]});
+		if (difference > 0) {
+			inexactPixels++;
+		}
+		if (difference > Tolerance && firstMismatch == expected.pixels.size()) {
+			firstMismatch = i;
+		}
+		maxDifference = std::max(maxDifference, difference);
+	}
+
+	::testing::Test::RecordProperty("max_difference", maxDifference);
+	::testing::Test::RecordProperty("inexact_pixels", static_cast<int>(inexactPixels));
+	EXPECT_LE(maxDifference, Tolerance)
+		<< "first mismatch at (" << firstMismatch % Width << ", " << firstMismatch / Width << "): expected "
+		<< int{expected.pixels[firstMismatch]} << ", actual " << int{actual.pixels[firstMismatch]};
+}
+
+/**
+ * @brief The mean, mean of squares and maximum of each block of an image.
+ */
+struct BlockStatsImage {
+	std::uint32_t width;
+	std::uint32_t height;
+	std::vector<std::array<float, 3>> stats;
+};
+
+/**
+ * @brief Merges each 4x4 block; blocks past the edge repeat the edge texels, as the clamped sampler does.
+ */
+BlockStatsImage reduceBlockStats4x4(const BlockStatsImage &input)
+{
+	BlockStatsImage output{(input.width + 3) / 4, (input.height + 3) / 4, {}};
+	for (std::uint32_t y = 0; y < output.height; y++) {
+		for (std::uint32_t x = 0; x < output.width; x++) {
+			std::array<float, 3> merged{0.0f, 0.0f, 0.0f};
+			for (std::uint32_t i = 0; i < 16; i++) {
+				const std::uint32_t sx = std::min(x * 4 + i % 4, input.width - 1);
+				const std::uint32_t sy = std::min(y * 4 + i / 4, input.height - 1);
+				const std::array<float, 3> &stats = input.stats[sy * input.width + sx];
+				merged[0] += stats[0] / 16.0f;
+				merged[1] += stats[1] / 16.0f;
+				merged[2] = std::max(merged[2], stats[2]);
+			}
+			output.stats.push_back(merged);
+		}
+	}
+	return output;
+}
+
+class DrawingEffectShaderTest : public ::testing::Test {
+protected:
+	static void SetUpTestSuite()
+	{
+		try {
+			video = std::make_unique<ObsHeadlessVideo>();
+			video->resetVideo(Width, Height);
+
+			GraphicsContextGuard guard;
+			mainEffect = std::make_unique<MainEffect>(
+				unique_bfree_char_t(bstrdup(CMAKE_SOURCE_DIR "/data/effects/main.effect")));
+			sampleEffect = std::make_unique<MainEffect>(
+				unique_bfree_char_t(bstrdup(CMAKE_SOURCE_DIR "/data/effects/main.effect")),
+				TexelFetchMode::Sample);
+			quadSobelEffect = std::make_unique<MainEffect>(
+				unique_bfree_char_t(bstrdup(CMAKE_SOURCE_DIR "/data/effects/main.effect")),
+				TexelFetchMode::LoadQuadSobel);
+			std::cout << "Renderer: " << gs_get_device_name() << std::endl;
+		} catch (const std::exception &e) {
+			setupError = e.what();
+		}
+	}
+
+	static void TearDownTestSuite()
+	{
+		if (mainEffect) {
+			GraphicsContextGuard guard;
+			mainEffect.reset();
+			sampleEffect.reset();
+			quadSobelEffect.reset();
+		}
+		video.reset();
+	}
+
+	void SetUp() override
+	{
+		if (!mainEffect) {
+			GTEST_FAIL() << "Failed to set up the graphics context: " << setupError;
+		}
+		guard = std::make_unique<GraphicsContextGuard>();
+	}
+
+	void TearDown() override { guard.reset(); }
+
+	/**
+	 * @brief Runs the technique TimedRuns times and records the wall time per run, including the final sync.
+	 */
+	static void recordTiming(const std::function<void()> &run, const unique_gs_texture_t &target,
+				 gs_color_format format)
+	{
+		run();
+		readBack(target, format);
+
+		const std::uint64_t start = os_gettime_ns();
+		for (int i = 0; i < TimedRuns; i++) {
+			run();
+		}
+		readBack(target, format);
+		const double usPerRun = static_cast<double>(os_gettime_ns() - start) / 1000.0 / TimedRuns;
+
+		RecordProperty("us_per_run", std::to_string(usPerRun));
+		std::cout << "[  TIMING  ] " << ::testing::UnitTest::GetInstance()->current_test_info()->name() << ": "
+			  << usPerRun << " us/run at " << Width << "x" << Height << std::endl;
+	}
+
+	static const KernelSet &kernels() { return getScalarKernels(); }
+
+	static inline std::unique_ptr<ObsHeadlessVideo> video;
+	// The backend's default fetch mode, and the other modes for the tests that pin one.
+	static inline std::unique_ptr<MainEffect> mainEffect;
+	static inline std::unique_ptr<MainEffect> sampleEffect;
+	static inline std::unique_ptr<MainEffect> quadSobelEffect;
+	static inline std::string setupError;
+
+	std::unique_ptr<GraphicsContextGuard> guard;
+};
+
+TEST_F(DrawingEffectShaderTest, ConvertGrayscale)
+{
+	std::vector<std::uint8_t> bgrx = makeRandomBytes(Width * Height * 4, 1);
+	for (std::size_t i = 3; i < bgrx.size(); i += 4) {
+		bgrx[i] = 255;
+	}
+	unique_gs_texture_t source = uploadTexture(GS_BGRX, bgrx.data());
+	unique_gs_texture_t target = makeRenderTarget(GS_R8);
+
+	auto run = [&] { mainEffect->applyConvertToGrayscale(target, source); };
+	run();
+
+	LumaImage expected(Width, Height);
+	convertBgraToLuma(kernels(), {bgrx.data(), Width, Height, Width * 4}, expected.view());
+	expectWithinTolerance(expected, readBack(target, GS_R8));
+	recordTiming(run, target, GS_R8);
+}
+
+TEST_F(DrawingEffectShaderTest, WarpConvertGrayscaleIdentity)
+{
+	std::vector<std::uint8_t> bgrx = makeRandomBytes(Width * Height * 4, 8);
+	for (std::size_t i = 3; i < bgrx.size(); i += 4) {
+		bgrx[i] = 255;
+	}
+	unique_gs_texture_t source = uploadTexture(GS_BGRX, bgrx.data());
+	unique_gs_texture_t target = makeRenderTarget(GS_R8);
+
+	// The whole source as the canvas, so the warp must sample exactly where ConvertGrayscale does.
+	const std::array<float, 9> identity{1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+	auto run = [&] { mainEffect->applyWarpConvertToGrayscale(target, source, identity); };
+	run();
+
+	LumaImage expected(Width, Height);
+	convertBgraToLuma(kernels(), {bgrx.data(), Width, Height, Width * 4}, expected.view());
+	expectWithinTolerance(expected, readBack(target, GS_R8));
+	recordTiming(run, target, GS_R8);
+}
+
+TEST_F(DrawingEffectShaderTest, Median3x3)
+{
+	const LumaImage input = makeSyntheticImage(2);
+	unique_gs_texture_t source = uploadTexture(GS_R8, input.pixels.data());
+	unique_gs_texture_t intermediate = makeRenderTarget(GS_R32F);
+	unique_gs_texture_t target = makeRenderTarget(GS_R8);
+
+	auto run = [&] { mainEffect->applyMedianFilter(target, intermediate, source); };
+	run();
+
+	LumaImage expected(Width, Height);
+	applyMedian3x3(kernels(), input.view(), expected.view());
+	expectWithinTolerance(expected, readBack(target, GS_R8));
+	recordTiming(run, target, GS_R8);
+}
+
+TEST_F(DrawingEffectShaderTest, MotionAdaptiveFilter)
+{
+	constexpr float strength = 0.5f;
+	constexpr float motionThreshold = 0.3f;
+
+	const LumaImage current = makeSyntheticImage(3);
+	const LumaImage previous = makeSyntheticImage(4);
+	unique_gs_texture_t currentTexture = uploadTexture(GS_R8, current.pixels.data());
+	unique_gs_texture_t previousTexture = uploadTexture(GS_R8, previous.pixels.data());
+	unique_gs_texture_t intermediate = makeRenderTarget(GS_R32F);
+	unique_gs_texture_t motionMap = makeRenderTarget(GS_R8);
+	unique_gs_texture_t target = makeRenderTarget(GS_R8);
+
+	auto run = [&] {
+		mainEffect->applyMotionAdaptiveFilter(target, motionMap, intermediate, currentTexture, previousTexture,
+						      strength, motionThreshold);
+	};
+	run();
+
+	LumaImage expectedMotion(Width, Height);
+	calculateMotionMap(kernels(), current.view(), previous.view(), expectedMotion.view());
+	expectWithinTolerance(expectedMotion, readBack(motionMap, GS_R8));
+
+	LumaImage expected(Width, Height);
+	applyMotionAdaptiveFilter(kernels(), current.view(), previous.view(), expectedMotion.view(), expected.view(),
+				  MotionAdaptiveTable::create(strength, motionThreshold));
+	expectWithinTolerance(expected, readBack(target, GS_R8));
+	recordTiming(run, target, GS_R8);
+}
+
+/**
+ * @brief Runs the temporal median of the given number of frames and compares it with the per-pixel median.
+ */
+void expectTemporalMedian(const MainEffect &mainEffect, std::size_t frameCount, std::uint32_t seed)
+{
+	std::vector<LumaImage> frames;
+	std::vector<unique_gs_texture_t> history;
+	for (std::size_t i = 0; i < frameCount; i++) {
+		frames.push_back(makeSyntheticImage(seed + static_cast<std::uint32_t>(i)));
+		history.push_back(uploadTexture(GS_R8, frames.back().pixels.data()));
+	}
+	unique_gs_texture_t target = makeRenderTarget(GS_R8);
+
+	std::vector<const unique_gs_texture_t *> historySlots;
+	for (const unique_gs_texture_t &slot : history) {
+		historySlots.push_back(&slot);
+	}
+	mainEffect.applyTemporalMedian(target, historySlots);
+
+	LumaImage expected(Width, Height);
+	std::vector<std::uint8_t> samples(frameCount);
+	for (std::size_t i = 0; i < expected.pixels.size(); i++) {
+		for (std::size_t j = 0; j < frameCount; j++) {
+			samples[j] = frames[j].pixels[i];
+		}
+		std::nth_element(samples.begin(), samples.begin() + frameCount / 2, samples.end());
+		expected.pixels[i] = samples[frameCount / 2];
+	}
+	expectWithinTolerance(expected, readBack(target, GS_R8));
+}
+
+TEST_F(DrawingEffectShaderTest, TemporalMedian3)
 {
-	EXPECT_TRUE(true);
+	expectTemporalMedian(*mainEffect, 3, 11);
 }
+
+TEST_F(DrawingEffectShaderTest, TemporalMedian5)
+{
+	expectTemporalMedian(*mainEffect, 5, 14);
+}
+
+TEST_F(DrawingEffectShaderTest, ApplySobel)
+{
+	const LumaImage input = makeSyntheticImage(5);
+	unique_gs_texture_t source = uploadTexture(GS_R8, input.pixels.data());
+	unique_gs_texture_t target = makeRenderTarget(GS_BGRX);
+
+	auto run = [&] { mainEffect->applySobel(target, source); };
+	run();
+
+	// The magnitude is written to the red channel, which is byte 2 of a BGRX pixel.
+	LumaImage expected(Width, Height);
+	applySobelMagnitude(kernels(), input.view(), expected.view());
+	expectWithinTolerance(expected, readBack(target, GS_BGRX, 2));
+	recordTiming(run, target, GS_BGRX);
+}
+
+TEST_F(DrawingEffectShaderTest, FinalizeSobelMagnitude)
+{
+	const LumaImage input = makeSyntheticImage(6);
+	unique_gs_texture_t source = uploadTexture(GS_R8, input.pixels.data());
+	unique_gs_texture_t target = makeRenderTarget(GS_R8);
+
+	for (bool useLog : {false, true}) {
+		SCOPED_TRACE(useLog ? "useLog" : "linear");
+		constexpr float scalingFactor = 3.1622777f;
+		mainEffect->applyFinalizeSobelMagnitude(target, source, useLog, scalingFactor);
+
+		LumaImage expected(Width, Height);
+		applyFinalizeSobelMagnitude(input.view(), expected.view(), FinalizeTable::create(useLog, scalingFactor));
+		expectWithinTolerance(expected, readBack(target, GS_R8));
+	}
+	recordTiming([&] { mainEffect->applyFinalizeSobelMagnitude(target, source, true, 3.1622777f); }, target,
+		     GS_R8);
+}
+
+TEST_F(DrawingEffectShaderTest, EffectsOfTheSameFileKeepTheirOwnValues)
+{
+	// libobs caches effects by path, so every MainEffect of the file writes the parameters of one effect.
+	const MainEffect otherEffect(unique_bfree_char_t(bstrdup(CMAKE_SOURCE_DIR "/data/effects/main.effect")));
+	const LumaImage input = makeSyntheticImage(6);
+	unique_gs_texture_t source = uploadTexture(GS_R8, input.pixels.data());
+	unique_gs_texture_t target = makeRenderTarget(GS_R8);
+	unique_gs_texture_t otherTarget = makeRenderTarget(GS_R8);
+
+	mainEffect->applyFinalizeSobelMagnitude(target, source, false, 2.0f);
+	otherEffect.applyFinalizeSobelMagnitude(otherTarget, source, true, 5.0f);
+	mainEffect->applyFinalizeSobelMagnitude(target, source, false, 2.0f);
+
+	LumaImage expected(Width, Height);
+	applyFinalizeSobelMagnitude(input.view(), expected.view(), FinalizeTable::create(false, 2.0f));
+	expectWithinTolerance(expected, readBack(target, GS_R8));
+	applyFinalizeSobelMagnitude(input.view(), expected.view(), FinalizeTable::create(true, 5.0f));
+	expectWithinTolerance(expected, readBack(otherTarget, GS_R8));
+}
+
+TEST_F(DrawingEffectShaderTest, ReduceToBlockStats)
+{
+	const LumaImage input = makeSyntheticImage(9);
+	unique_gs_texture_t source = uploadTexture(GS_R8, input.pixels.data());
+
+	BlockStatsImage expected{Width, Height, {}};
+	for (std::uint8_t value : input.pixels) {
+		const float v = static_cast<float>(value) / 255.0f;
+		expected.stats.push_back({v, v * v, v});
+	}
+	std::vector<unique_gs_texture_t> chain;
+	for (int i = 0; i < 2; i++) {
+		expected = reduceBlockStats4x4(expected);
+		chain.push_back(make_unique_gs_texture(expected.width, expected.height, GS_RGBA32F, 1, nullptr,
+						       GS_RENDER_TARGET));
+	}
+
+	AsyncTextureReader reader(expected.width, expected.height, GS_RGBA32F);
+	auto run = [&] { mainEffect->applyReduceToBlockStats(chain, source); };
+	run();
+	reader.stage(chain.back().get());
+	reader.sync();
+
+	for (std::uint32_t y = 0; y < expected.height; y++) {
+		const std::uint8_t *row = reader.getBuffer().data() + y * reader.getBufferLinesize();
+		for (std::uint32_t x = 0; x < expected.width; x++) {
+			float actual[4];
+			std::memcpy(actual, row + x * sizeof(actual), sizeof(actual));
+			const std::array<float, 3> &stats = expected.stats[y * expected.width + x];
+			for (std::size_t c = 0; c < 3; c++) {
+				EXPECT_NEAR(stats[c], actual[c], 1e-4f)
+					<< "at (" << x << ", " << y << ") channel " << c;
+			}
+		}
+	}
+
+	const std::uint64_t start = os_gettime_ns();
+	for (int i = 0; i < TimedRuns; i++) {
+		run();
+	}
+	reader.stage(chain.back().get());
+	reader.sync();
+	const double usPerRun = static_cast<double>(os_gettime_ns() - start) / 1000.0 / TimedRuns;
+	RecordProperty("us_per_run", std::to_string(usPerRun));
+}
+
+TEST_F(DrawingEffectShaderTest, Erosion3x3)
+{
+	const LumaImage input = makeSyntheticImage(7);
+	unique_gs_texture_t source = uploadTexture(GS_R8, input.pixels.data());
+	unique_gs_texture_t intermediate = makeRenderTarget(GS_R32F);
+	unique_gs_texture_t target = makeRenderTarget(GS_R8);
+
+	auto run = [&] {
+		mainEffect->applyMorphology(target, intermediate, source, mainEffect->techHorizontalErosion3,
+					    mainEffect->techVerticalErosion3);
+	};
+	run();
+
+	LumaImage expected(Width, Height);
+	applyErosion3x3(kernels(), input.view(), expected.view());
+	expectWithinTolerance(expected, readBack(target, GS_R8));
+	recordTiming(run, target, GS_R8);
+}
+
+TEST_F(DrawingEffectShaderTest, Dilation3x3)
+{
+	const LumaImage input = makeSyntheticImage(8);
+	unique_gs_texture_t source = uploadTexture(GS_R8, input.pixels.data());
+	unique_gs_texture_t intermediate = makeRenderTarget(GS_R32F);
+	unique_gs_texture_t target = makeRenderTarget(GS_R8);
+
+	auto run = [&] {
+		mainEffect->applyMorphology(target, intermediate, source, mainEffect->techHorizontalDilation3,
+					    mainEffect->techVerticalDilation3);
+	};
+	run();
+
+	LumaImage expected(Width, Height);
+	applyDilation3x3(kernels(), input.view(), expected.view());
+	expectWithinTolerance(expected, readBack(target, GS_R8));
+	recordTiming(run, target, GS_R8);
+}
+
+TEST_F(DrawingEffectShaderTest, CommitInk)
+{
+	constexpr float motionThreshold = 0.3f;
+	constexpr int commitFrames = 4;
+
+	const LumaImage edges = makeSyntheticImage(12);
+	const LumaImage committed = makeSyntheticImage(13);
+	// Motion on the right half. On the left, odd columns changed since the last frame and even ones are about
+	// to reach the commit frame count.
+	std::vector<std::uint8_t> motion(Width * Height);
+	std::vector<std::uint8_t> previousState(Width * Height * 4);
+	for (std::size_t y = 0; y < Height; y++) {
+		for (std::size_t x = 0; x < Width; x++) {
+			const std::size_t i = y * Width + x;
+			motion[i] = x >= Width / 2 ? 255 : 0;
+			previousState[i * 4 + 0] = committed.pixels[i];
+			previousState[i * 4 + 1] = static_cast<std::uint8_t>(edges.pixels[i] + (x % 2 == 0 ? 0 : 40));
+			previousState[i * 4 + 2] = commitFrames - 1;
+			previousState[i * 4 + 3] = 255;
+		}
+	}
+	unique_gs_texture_t edgesTexture = uploadTexture(GS_R8, edges.pixels.data());
+	unique_gs_texture_t motionTexture = uploadTexture(GS_R8, motion.data());
+	unique_gs_texture_t previousStateTexture = uploadTexture(GS_RGBA, previousState.data());
+	unique_gs_texture_t state = makeRenderTarget(GS_RGBA);
+	unique_gs_texture_t target = makeRenderTarget(GS_R8);
+
+	auto run = [&] {
+		mainEffect->applyCommitInk(target, state, edgesTexture, previousStateTexture, motionTexture,
+					   motionThreshold, static_cast<float>(commitFrames));
+	};
+	run();
+
+	LumaImage expectedCommitted(Width, Height);
+	LumaImage expected(Width, Height);
+	for (std::size_t y = 0; y < Height; y++) {
+		for (std::size_t x = 0; x < Width; x++) {
+			const std::size_t i = y * Width + x;
+			const bool isMoving = x >= Width / 2;
+			const bool commits = !isMoving && x % 2 == 0;
+			expectedCommitted.pixels[i] = commits ? edges.pixels[i] : committed.pixels[i];
+			expected.pixels[i] = isMoving ? committed.pixels[i] : edges.pixels[i];
+		}
+	}
+	expectWithinTolerance(expectedCommitted, readBack(state, GS_RGBA, 0));
+	expectWithinTolerance(expected, readBack(target, GS_R8));
+	recordTiming(run, target, GS_R8);
+}
+
+/**
+ * @brief Draws edges with an ink composition and checks each channel against the blend computed per pixel.
+ * @param blend Gives the expected value of a channel from the edge, the source and the ink, all in [0, 1].
+ */
+void expectInkComposition(const std::function<void(const unique_gs_texture_t &, const unique_gs_texture_t &,
+						   std::uint32_t)> &draw,
+			  const std::function<float(float, float, float)> &blend, bool expectsOpaque)
+{
+	// 0xAABBGGRR: an orange ink.
+	constexpr std::uint32_t inkColor = 0xFF2080E0;
+	const std::array<std::uint8_t, 3> ink{0xE0, 0x80, 0x20};
+
+	const LumaImage edges = makeSyntheticImage(14);
+	std::vector<std::uint8_t> bgrx = makeRandomBytes(Width * Height * 4, 15);
+	for (std::size_t i = 3; i < bgrx.size(); i += 4) {
+		bgrx[i] = 255;
+	}
+	unique_gs_texture_t edgesTexture = uploadTexture(GS_R8, edges.pixels.data());
+	unique_gs_texture_t colorTexture = uploadTexture(GS_BGRX, bgrx.data());
+	unique_gs_texture_t target = makeRenderTarget(GS_RGBA);
+
+	drawToTarget(target, [&] { draw(edgesTexture, colorTexture, inkColor); });
+
+	for (std::size_t channel = 0; channel < 3; channel++) {
+		LumaImage expected(Width, Height);
+		for (std::size_t i = 0; i < expected.pixels.size(); i++) {
+			// RGBA channel c of the output is BGRX byte 2 - c of the source.
+			const float value = blend(edges.pixels[i] / 255.0f, bgrx[i * 4 + 2 - channel] / 255.0f,
+						  ink[channel] / 255.0f);
+			const long rounded = std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+			expected.pixels[i] = static_cast<std::uint8_t>(rounded);
+		}
+		expectWithinTolerance(expected, readBack(target, GS_RGBA, channel));
+	}
+
+	LumaImage expectedAlpha(Width, Height);
+	for (std::size_t i = 0; i < expectedAlpha.pixels.size(); i++) {
+		expectedAlpha.pixels[i] = expectsOpaque ? 255 : edges.pixels[i];
+	}
+	expectWithinTolerance(expectedAlpha, readBack(target, GS_RGBA, 3));
+}
+
+TEST_F(DrawingEffectShaderTest, DrawMultiply)
+{
+	expectInkComposition(
+		[&](const unique_gs_texture_t &edges, const unique_gs_texture_t &color, std::uint32_t ink) {
+			mainEffect->drawGrayscaleMultiplied(edges, color, {0.0f, 0.0f, 1.0f, 1.0f}, ink, nullptr);
+		},
+		[](float edge, float source, float ink) { return source * (1.0f + (ink - 1.0f) * edge); }, true);
+}
+
+TEST_F(DrawingEffectShaderTest, DrawOverlay)
+{
+	expectInkComposition(
+		[&](const unique_gs_texture_t &edges, const unique_gs_texture_t &color, std::uint32_t ink) {
+			mainEffect->drawGrayscaleOverlaid(edges, color, {0.0f, 0.0f, 1.0f, 1.0f}, ink, nullptr);
+		},
+		[](float edge, float source, float ink) { return source + (ink - source) * edge; }, true);
+}
+
+TEST_F(DrawingEffectShaderTest, DrawAlphaMask)
+{
+	expectInkComposition(
+		[&](const unique_gs_texture_t &edges, const unique_gs_texture_t &, std::uint32_t ink) {
+			mainEffect->drawGrayscaleAsAlpha(edges, ink, nullptr);
+		},
+		[](float edge, float, float ink) { return ink * edge; }, false);
+}
+
+TEST_F(DrawingEffectShaderTest, SampleFetchNeighbourhoods)
+{
+	const LumaImage input = makeSyntheticImage(9);
+	const LumaImage previous = makeSyntheticImage(10);
+	unique_gs_texture_t source = uploadTexture(GS_R8, input.pixels.data());
+	unique_gs_texture_t previousTexture = uploadTexture(GS_R8, previous.pixels.data());
+	unique_gs_texture_t intermediate = makeRenderTarget(GS_R32F);
+	unique_gs_texture_t motionMap = makeRenderTarget(GS_R8);
+	unique_gs_texture_t target = makeRenderTarget(GS_R8);
+	unique_gs_texture_t sobelTarget = makeRenderTarget(GS_BGRX);
+
+	LumaImage expected(Width, Height);
+	sampleEffect->applyMedianFilter(target, intermediate, source);
+	applyMedian3x3(kernels(), input.view(), expected.view());
+	expectWithinTolerance(expected, readBack(target, GS_R8));
+
+	sampleEffect->applyMotionAdaptiveFilter(target, motionMap, intermediate, source, previousTexture, 0.5f, 0.3f);
+	calculateMotionMap(kernels(), input.view(), previous.view(), expected.view());
+	expectWithinTolerance(expected, readBack(motionMap, GS_R8));
+
+	sampleEffect->applySobel(sobelTarget, source);
+	applySobelMagnitude(kernels(), input.view(), expected.view());
+	expectWithinTolerance(expected, readBack(sobelTarget, GS_BGRX, 2));
+
+	sampleEffect->applyMorphology(target, intermediate, source, sampleEffect->techHorizontalErosion3,
+				      sampleEffect->techVerticalErosion3);
+	applyErosion3x3(kernels(), input.view(), expected.view());
+	expectWithinTolerance(expected, readBack(target, GS_R8));
+}
+
+TEST_F(DrawingEffectShaderTest, QuadSobel)
+{
+	if (gs_get_device_type() != GS_DEVICE_DIRECT3D_11) {
+		// Other backends may filter 8-bit textures in 8-bit fixed point, which rounds the corner taps.
+		GTEST_SKIP() << "The corner taps need full-precision filtering, which only Direct3D 11 guarantees";
+	}
+
+	const LumaImage input = makeSyntheticImage(5);
+	unique_gs_texture_t source = uploadTexture(GS_R8, input.pixels.data());
+	unique_gs_texture_t target = makeRenderTarget(GS_BGRX);
+
+	auto run = [&] { quadSobelEffect->applySobel(target, source); };
+	run();
+
+	LumaImage expected(Width, Height);
+	applySobelMagnitude(kernels(), input.view(), expected.view());
+	expectWithinTolerance(expected, readBack(target, GS_BGRX, 2));
+	recordTiming(run, target, GS_BGRX);
+}
+
+TEST_F(DrawingEffectShaderTest, RecycledRenderTargetStartsCleared)
+{
+	GsUnique::drain();
+
+	unique_gs_texture_t previous = makeRenderTarget(GS_R8);
+	{
+		const MainEffectDetail::RenderTargetGuard renderTargetGuard;
+		gs_set_render_target_with_color_space(previous.get(), nullptr, GS_CS_SRGB);
+		struct vec4 white;
+		vec4_set(&white, 1.0f, 1.0f, 1.0f, 1.0f);
+		gs_clear(GS_CLEAR_COLOR, &white, 0.0f, 0);
+	}
+	gs_texture_t *const previousTexture = previous.get();
+	previous.reset();
+
+	unique_gs_texture_t recycled = makeRenderTarget(GS_R8);
+	ASSERT_EQ(recycled.get(), previousTexture);
+	expectWithinTolerance(LumaImage(Width, Height), readBack(recycled, GS_R8));
+}
+
+} // namespace